@@ -0,0 +1,510 @@
+// Kernel micro-benchmark for MiCo-Lib
+// Sweeps the 16 mixed-precision MatMul kernels of the runtime table over an
+// (M, K, N) grid, plus activation quantization, im2col, decode attention and
+// softmax. Each case runs warmup + reps iterations and reports the median
+// and p99 latency, GOPS and bytes moved per op, as CSV or JSON.
+// The backend is selected at link time (see bench/Makefile), so one binary
+// measures one backend; --baseline compares against a saved CSV run.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include "mico_quant.h"
+#include "mico_runtime.h"
+
+#ifdef USE_HOST
+#include <time.h>
+#endif
+
+#ifdef MICO_EMU
+#include "mico_emu.h"
+#endif
+
+#ifndef MICO_BENCH_BACKEND
+#define MICO_BENCH_BACKEND "default"
+#endif
+
+#define BENCH_MAX_GRID 16
+#define BENCH_MAX_ROWS 1024
+
+extern MiCoRuntime MiCo_runtime;
+
+typedef struct {
+    char backend[32];
+    char kernel[16];
+    char variant[16];
+    size_t m, k, n;
+    int reps;
+    double median_us;
+    double p99_us;
+    double gops;
+    double bytes_per_op;
+} BenchRow;
+
+typedef struct {
+    size_t m[BENCH_MAX_GRID], k[BENCH_MAX_GRID], n[BENCH_MAX_GRID];
+    int n_m, n_k, n_n;
+    int seq[BENCH_MAX_GRID], n_seq;
+    int conv[6];        // C, H, W, kernel, stride, pad
+    int heads, head_size;
+    int warmup, reps;
+    int json;
+    unsigned kernels;
+    const char* out[4];
+    int n_out;
+    const char* baseline;
+    double threshold;
+} BenchConfig;
+
+enum {
+    BENCH_MATMUL  = 1 << 0,
+    BENCH_QUANT   = 1 << 1,
+    BENCH_IM2COL  = 1 << 2,
+    BENCH_ATTN    = 1 << 3,
+    BENCH_SOFTMAX = 1 << 4,
+};
+
+static BenchRow rows[BENCH_MAX_ROWS];
+static int n_rows = 0;
+
+// Wall-clock time in microseconds; MiCo_time() is too coarse on host
+static double __now_us(void){
+    #ifdef USE_HOST
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+    #else
+    return (double)MiCo_time();
+    #endif
+}
+
+static int __cmp_double(const void* a, const void* b){
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void __fill_bytes(qbyte* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        p[i] = (qbyte)(rand() & 0xFF);
+    }
+}
+
+static void __fill_f32(float* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        p[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    }
+}
+
+static BenchRow* __new_row(const char* kernel, const char* variant,
+    const size_t m, const size_t k, const size_t n){
+    MiCo_assert(n_rows < BENCH_MAX_ROWS, "[Bench] too many cases");
+    BenchRow* r = &rows[n_rows++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->backend, sizeof(r->backend), "%s", MICO_BENCH_BACKEND);
+    snprintf(r->kernel, sizeof(r->kernel), "%s", kernel);
+    snprintf(r->variant, sizeof(r->variant), "%s", variant);
+    r->m = m;
+    r->k = k;
+    r->n = n;
+    return r;
+}
+
+// Median / p99 of the timed repetitions; ops and bytes are per call
+static void __finish_row(BenchRow* r, double* t, const int reps,
+    const double ops, const double bytes){
+    qsort(t, reps, sizeof(double), __cmp_double);
+    int p99 = (int)ceil(0.99 * reps) - 1;
+    if (p99 < 0) p99 = 0;
+    r->reps = reps;
+    r->median_us = reps % 2 ? t[reps / 2] : 0.5 * (t[reps / 2 - 1] + t[reps / 2]);
+    r->p99_us = t[p99];
+    r->gops = r->median_us > 0 ? ops / (r->median_us * 1e3) : 0.0;
+    r->bytes_per_op = bytes / ops;
+    fprintf(stderr, "  %-8s %-6s M=%-5zu K=%-5zu N=%-5zu  median %10.2f us  p99 %10.2f us  %8.3f GOPS\n",
+        r->kernel, r->variant, r->m, r->k, r->n, r->median_us, r->p99_us, r->gops);
+}
+
+#ifdef MICO_EMU
+// Custom-ISA instruction mix of one call on the emulator
+static void __emu_mix(MatMulFunc f, int32_t* O, const Tensor2D_Q8* x, const Tensor2D_Q8* w){
+    MiCo_emu_reset();
+    f(O, x, w);
+    const MiCo_Emu_Stats* s = MiCo_emu_stats();
+    const uint64_t dots = s->insn[MICO_EMU_VPU_VDOT] + s->insn[MICO_EMU_SIMD_MAC] +
+        s->insn[MICO_EMU_BN_SUM] + s->insn[MICO_EMU_BN_DOTP8] + s->insn[MICO_EMU_BN_DOTP8X2];
+    fprintf(stderr, "                   emu: %lu dot insns, %lu vector loads (%lu B), %lu bn.store, %.1f%% of MACs on custom ops\n",
+        (unsigned long)dots, (unsigned long)s->insn[MICO_EMU_VPU_LOAD],
+        (unsigned long)s->load_bytes, (unsigned long)s->insn[MICO_EMU_BN_STORE],
+        100.0 * s->macs / ((double)x->shape[0] * x->shape[1] * w->shape[0]));
+}
+#endif
+
+// MatMul O[M, N] = X[M, K] . W[N, K]^T for every (aq, wq) in the table
+static void __bench_matmul(const BenchConfig* cfg, double* t){
+    for (int im = 0; im < cfg->n_m; im++)
+    for (int ik = 0; ik < cfg->n_k; ik++)
+    for (int in = 0; in < cfg->n_n; in++){
+        const size_t M = cfg->m[im], K = cfg->k[ik], N = cfg->n[in];
+        qbyte* x = malloc(M * K);
+        qbyte* w = malloc(N * K);
+        int32_t* O = malloc(M * N * sizeof(int32_t));
+        MiCo_assert(x != NULL && w != NULL && O != NULL, "[Bench] failed to allocate buffers");
+        __fill_bytes(x, M * K);
+        __fill_bytes(w, N * K);
+
+        for (int a = 3; a >= 0; a--)
+        for (int b = 3; b >= 0; b--){
+            const qtype aq = 1 << a, wq = 1 << b;
+            Tensor2D_Q8 qx = { .shape = {M, K}, .data = x, .scale = 1.0f, .wq = aq };
+            Tensor2D_Q8 qw = { .shape = {N, K}, .data = w, .scale = 1.0f, .wq = wq };
+            MatMulFunc f = MiCo_runtime.matmul_matrix[a][b];
+            char variant[16];
+            if (aq == wq) snprintf(variant, sizeof(variant), "Q%d", aq);
+            else snprintf(variant, sizeof(variant), "Q%dx%d", aq, wq);
+
+            for (int r = 0; r < cfg->warmup + cfg->reps; r++){
+                memset(O, 0, M * N * sizeof(int32_t));
+                const double t0 = __now_us();
+                f(O, &qx, &qw);
+                if (r >= cfg->warmup) t[r - cfg->warmup] = __now_us() - t0;
+            }
+            const double bytes = (double)M * K * aq / 8 + (double)N * K * wq / 8 +
+                (double)M * N * sizeof(int32_t);
+            __finish_row(__new_row("matmul", variant, M, K, N), t, cfg->reps,
+                2.0 * M * K * N, bytes);
+            #ifdef MICO_EMU
+            __emu_mix(f, O, &qx, &qw);
+            #endif
+        }
+        free(x);
+        free(w);
+        free(O);
+    }
+}
+
+// Activation quantization of an [M, K] FP32 tensor (ops = elements)
+static void __bench_quant(const BenchConfig* cfg, double* t){
+    for (int im = 0; im < cfg->n_m; im++)
+    for (int ik = 0; ik < cfg->n_k; ik++){
+        const size_t M = cfg->m[im], K = cfg->k[ik];
+        float* xf = malloc(M * K * sizeof(float));
+        qbyte* q = malloc(MiCo_qact_size(M, K, 8, 32));
+        MiCo_assert(xf != NULL && q != NULL, "[Bench] failed to allocate buffers");
+        __fill_f32(xf, M * K);
+        Tensor2D_F32 x = { .shape = {M, K}, .data = xf };
+
+        for (int a = 3; a >= 0; a--){
+            const qtype aq = 1 << a;
+            Tensor2D_Q8 qx = { .data = q };
+            char variant[16];
+            snprintf(variant, sizeof(variant), "A%d", aq);
+            for (int r = 0; r < cfg->warmup + cfg->reps; r++){
+                const double t0 = __now_us();
+                MiCo_2D_quant_act(&qx, &x, aq, 32);
+                if (r >= cfg->warmup) t[r - cfg->warmup] = __now_us() - t0;
+            }
+            __finish_row(__new_row("quant", variant, M, K, 0), t, cfg->reps,
+                (double)M * K, (double)M * K * sizeof(float) + (double)M * K * aq / 8);
+        }
+        free(xf);
+        free(q);
+    }
+}
+
+// im2col of one conv input into the [OH * OW, C * ks * ks] column matrix
+static void __bench_im2col(const BenchConfig* cfg, double* t){
+    const int C = cfg->conv[0], H = cfg->conv[1], W = cfg->conv[2];
+    const int ks = cfg->conv[3], stride = cfg->conv[4], pad = cfg->conv[5];
+    const int OH = (H + 2 * pad - ks) / stride + 1;
+    const int OW = (W + 2 * pad - ks) / stride + 1;
+    MiCo_assert(OH > 0 && OW > 0, "[Bench] invalid im2col shape");
+    const size_t cols = (size_t)C * ks * ks;
+    float* im = malloc((size_t)C * H * W * sizeof(float));
+    float* col = malloc((size_t)OH * OW * cols * sizeof(float));
+    MiCo_assert(im != NULL && col != NULL, "[Bench] failed to allocate buffers");
+    __fill_f32(im, (size_t)C * H * W);
+
+    char variant[16];
+    snprintf(variant, sizeof(variant), "k%ds%dp%d", ks, stride, pad);
+    for (int r = 0; r < cfg->warmup + cfg->reps; r++){
+        const double t0 = __now_us();
+        im2col_block_T(im, C, H, W, ks, stride, pad, col, 0, OH, OW);
+        if (r >= cfg->warmup) t[r - cfg->warmup] = __now_us() - t0;
+    }
+    const double elems = (double)OH * OW * cols;
+    __finish_row(__new_row("im2col", variant, (size_t)OH * OW, cols, C), t, cfg->reps,
+        elems, (double)C * H * W * sizeof(float) + elems * sizeof(float));
+    free(im);
+    free(col);
+}
+
+// Single-token decode attention over pos + 1 cached keys
+static void __bench_attn(const BenchConfig* cfg, double* t){
+    for (int is = 0; is < cfg->n_seq; is++){
+        const int L = cfg->seq[is];
+        const int dim = cfg->heads * cfg->head_size;
+        MiCo_MHA_Config mha = {
+            .n_heads = cfg->heads, .head_size = cfg->head_size,
+            .kv_dim = dim, .kv_mul = 1, .seq_len = L
+        };
+        float* qf = malloc(dim * sizeof(float));
+        float* of = malloc(dim * sizeof(float));
+        float* kc = malloc((size_t)L * dim * sizeof(float));
+        float* vc = malloc((size_t)L * dim * sizeof(float));
+        float* att = malloc((size_t)cfg->heads * L * sizeof(float));
+        MiCo_assert(qf != NULL && of != NULL && kc != NULL && vc != NULL && att != NULL,
+            "[Bench] failed to allocate buffers");
+        __fill_f32(qf, dim);
+        __fill_f32(kc, (size_t)L * dim);
+        __fill_f32(vc, (size_t)L * dim);
+        Tensor2D_F32 q = { .shape = {cfg->heads, cfg->head_size}, .data = qf };
+        Tensor2D_F32 o = { .shape = {cfg->heads, cfg->head_size}, .data = of };
+
+        char variant[16];
+        snprintf(variant, sizeof(variant), "h%d", cfg->heads);
+        for (int r = 0; r < cfg->warmup + cfg->reps; r++){
+            const double t0 = __now_us();
+            MiCo_multihead_attention_f32(&o, &q, kc, vc, att, L - 1, &mha);
+            if (r >= cfg->warmup) t[r - cfg->warmup] = __now_us() - t0;
+        }
+        __finish_row(__new_row("attn", variant, 1, cfg->head_size, L), t, cfg->reps,
+            4.0 * L * dim, 2.0 * L * dim * sizeof(float));
+        free(qf);
+        free(of);
+        free(kc);
+        free(vc);
+        free(att);
+    }
+}
+
+// Row-wise softmax of an [M, N] FP32 tensor (ops = elements)
+static void __bench_softmax(const BenchConfig* cfg, double* t){
+    for (int im = 0; im < cfg->n_m; im++)
+    for (int in = 0; in < cfg->n_n; in++){
+        const size_t M = cfg->m[im], N = cfg->n[in];
+        float* x = malloc(M * N * sizeof(float));
+        float* y = malloc(M * N * sizeof(float));
+        MiCo_assert(x != NULL && y != NULL, "[Bench] failed to allocate buffers");
+        __fill_f32(x, M * N);
+        for (int r = 0; r < cfg->warmup + cfg->reps; r++){
+            const double t0 = __now_us();
+            for (size_t i = 0; i < M; i++){
+                MiCo_softmax_f32(y + i * N, x + i * N, N);
+            }
+            if (r >= cfg->warmup) t[r - cfg->warmup] = __now_us() - t0;
+        }
+        __finish_row(__new_row("softmax", "f32", M, 0, N), t, cfg->reps,
+            (double)M * N, 2.0 * M * N * sizeof(float));
+        free(x);
+        free(y);
+    }
+}
+
+static void __write_results(FILE* f, const int json){
+    if (json){
+        fprintf(f, "[\n");
+        for (int i = 0; i < n_rows; i++){
+            const BenchRow* r = &rows[i];
+            fprintf(f, "  {\"backend\": \"%s\", \"kernel\": \"%s\", \"variant\": \"%s\", "
+                "\"M\": %zu, \"K\": %zu, \"N\": %zu, \"reps\": %d, "
+                "\"median_us\": %.3f, \"p99_us\": %.3f, \"gops\": %.4f, \"bytes_per_op\": %.4f}%s\n",
+                r->backend, r->kernel, r->variant, r->m, r->k, r->n, r->reps,
+                r->median_us, r->p99_us, r->gops, r->bytes_per_op,
+                i + 1 < n_rows ? "," : "");
+        }
+        fprintf(f, "]\n");
+    } else {
+        fprintf(f, "backend,kernel,variant,M,K,N,reps,median_us,p99_us,gops,bytes_per_op\n");
+        for (int i = 0; i < n_rows; i++){
+            const BenchRow* r = &rows[i];
+            fprintf(f, "%s,%s,%s,%zu,%zu,%zu,%d,%.3f,%.3f,%.4f,%.4f\n",
+                r->backend, r->kernel, r->variant, r->m, r->k, r->n, r->reps,
+                r->median_us, r->p99_us, r->gops, r->bytes_per_op);
+        }
+    }
+}
+
+// Compare medians against a CSV baseline of the same format.
+// Cases match on (backend, kernel, variant, M, K, N); returns the number of
+// cases slower than baseline * (1 + threshold).
+static int __compare_baseline(const char* path, const double threshold){
+    FILE* f = fopen(path, "r");
+    if (f == NULL){
+        fprintf(stderr, "[Bench] cannot open baseline %s\n", path);
+        return -1;
+    }
+    char line[256];
+    int matched = 0, regressions = 0;
+    while (fgets(line, sizeof(line), f)){
+        BenchRow b;
+        if (sscanf(line, "%31[^,],%15[^,],%15[^,],%zu,%zu,%zu,%d,%lf,%lf,%lf,%lf",
+            b.backend, b.kernel, b.variant, &b.m, &b.k, &b.n, &b.reps,
+            &b.median_us, &b.p99_us, &b.gops, &b.bytes_per_op) != 11) continue;
+        for (int i = 0; i < n_rows; i++){
+            const BenchRow* r = &rows[i];
+            if (strcmp(r->backend, b.backend) || strcmp(r->kernel, b.kernel) ||
+                strcmp(r->variant, b.variant) || r->m != b.m || r->k != b.k || r->n != b.n) continue;
+            matched++;
+            const double ratio = b.median_us > 0 ? r->median_us / b.median_us : 1.0;
+            if (ratio > 1.0 + threshold){
+                regressions++;
+                fprintf(stderr, "REGRESSION %s %s %s M=%zu K=%zu N=%zu: %.2f us -> %.2f us (%+.1f%%)\n",
+                    r->backend, r->kernel, r->variant, r->m, r->k, r->n,
+                    b.median_us, r->median_us, (ratio - 1.0) * 100.0);
+            } else if (ratio < 1.0 - threshold){
+                fprintf(stderr, "improved   %s %s %s M=%zu K=%zu N=%zu: %.2f us -> %.2f us (%+.1f%%)\n",
+                    r->backend, r->kernel, r->variant, r->m, r->k, r->n,
+                    b.median_us, r->median_us, (ratio - 1.0) * 100.0);
+            }
+            break;
+        }
+    }
+    fclose(f);
+    fprintf(stderr, "[Bench] %d cases compared, %d regressions (threshold %.0f%%)\n",
+        matched, regressions, threshold * 100.0);
+    return regressions;
+}
+
+static int __parse_list(const char* s, size_t* out){
+    int n = 0;
+    while (*s && n < BENCH_MAX_GRID){
+        char* end;
+        const long v = strtol(s, &end, 10);
+        MiCo_assert(end != s && v > 0, "[Bench] invalid list value");
+        out[n++] = (size_t)v;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static unsigned __parse_kernels(const char* s){
+    unsigned mask = 0;
+    if (strstr(s, "all")) return ~0u;
+    if (strstr(s, "matmul")) mask |= BENCH_MATMUL;
+    if (strstr(s, "quant")) mask |= BENCH_QUANT;
+    if (strstr(s, "im2col")) mask |= BENCH_IM2COL;
+    if (strstr(s, "attn")) mask |= BENCH_ATTN;
+    if (strstr(s, "softmax")) mask |= BENCH_SOFTMAX;
+    return mask;
+}
+
+static void __usage(const char* prog){
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -m LIST           rows (batch / tokens), default 1,16\n"
+        "  -k LIST           reduction dim, multiple of 32, default 256,1024\n"
+        "  -n LIST           output features, default 256,1024\n"
+        "  --seq LIST        attention context lengths, default 128,512\n"
+        "  --heads H,D       attention heads and head size, default 8,64\n"
+        "  --conv C,H,W,K,S,P  im2col shape, default 32,32,32,3,1,1\n"
+        "  --kernels LIST    matmul,quant,im2col,attn,softmax or all (default)\n"
+        "  --warmup N        warmup iterations, default 3\n"
+        "  --reps N          timed iterations, default 20\n"
+        "  --json            JSON to stdout instead of CSV\n"
+        "  -o FILE           write results to FILE, JSON if it ends in .json;\n"
+        "                    may be given more than once (default stdout)\n"
+        "  --baseline FILE   compare against a CSV baseline, exit 1 on regressions\n"
+        "  --threshold F     regression threshold, default 0.10\n", prog);
+}
+
+int main(int argc, char** argv){
+    BenchConfig cfg = {
+        .m = {1, 16}, .n_m = 2,
+        .k = {256, 1024}, .n_k = 2,
+        .n = {256, 1024}, .n_n = 2,
+        .seq = {128, 512}, .n_seq = 2,
+        .conv = {32, 32, 32, 3, 1, 1},
+        .heads = 8, .head_size = 64,
+        .warmup = 3, .reps = 20,
+        .json = 0, .kernels = ~0u,
+        .n_out = 0, .baseline = NULL, .threshold = 0.10
+    };
+
+    for (int i = 1; i < argc; i++){
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        size_t tmp[BENCH_MAX_GRID];
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")){
+            __usage(argv[0]);
+            return 0;
+        } else if (!strcmp(a, "--json")){
+            cfg.json = 1;
+            continue;
+        }
+        if (v == NULL){
+            __usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (!strcmp(a, "-m")) cfg.n_m = __parse_list(v, cfg.m);
+        else if (!strcmp(a, "-k")) cfg.n_k = __parse_list(v, cfg.k);
+        else if (!strcmp(a, "-n")) cfg.n_n = __parse_list(v, cfg.n);
+        else if (!strcmp(a, "--seq")){
+            cfg.n_seq = __parse_list(v, tmp);
+            for (int j = 0; j < cfg.n_seq; j++) cfg.seq[j] = (int)tmp[j];
+        } else if (!strcmp(a, "--heads")){
+            MiCo_assert(__parse_list(v, tmp) == 2, "[Bench] --heads expects H,D");
+            cfg.heads = (int)tmp[0];
+            cfg.head_size = (int)tmp[1];
+        } else if (!strcmp(a, "--conv")){
+            // pad may be zero, so parse without the positivity check
+            MiCo_assert(sscanf(v, "%d,%d,%d,%d,%d,%d", &cfg.conv[0], &cfg.conv[1], &cfg.conv[2],
+                &cfg.conv[3], &cfg.conv[4], &cfg.conv[5]) == 6, "[Bench] --conv expects C,H,W,K,S,P");
+        }
+        else if (!strcmp(a, "--kernels")) cfg.kernels = __parse_kernels(v);
+        else if (!strcmp(a, "--warmup")) cfg.warmup = atoi(v);
+        else if (!strcmp(a, "--reps")) cfg.reps = atoi(v);
+        else if (!strcmp(a, "-o")){
+            MiCo_assert(cfg.n_out < 4, "[Bench] too many output files");
+            cfg.out[cfg.n_out++] = v;
+        }
+        else if (!strcmp(a, "--baseline")) cfg.baseline = v;
+        else if (!strcmp(a, "--threshold")) cfg.threshold = atof(v);
+        else {
+            __usage(argv[0]);
+            return 2;
+        }
+    }
+    MiCo_assert(cfg.reps > 0 && cfg.warmup >= 0, "[Bench] invalid repetition count");
+    for (int i = 0; i < cfg.n_k; i++){
+        // 1-bit packing and the SIMD / LUT kernels need 32-aligned K
+        MiCo_assert(cfg.k[i] % 32 == 0, "[Bench] K must be a multiple of 32");
+    }
+
+    srand(42);
+    double* t = malloc(cfg.reps * sizeof(double));
+    MiCo_assert(t != NULL, "[Bench] failed to allocate buffers");
+
+    fprintf(stderr, "[Bench] backend: %s, warmup %d, reps %d\n", MICO_BENCH_BACKEND, cfg.warmup, cfg.reps);
+    if (cfg.kernels & BENCH_MATMUL) __bench_matmul(&cfg, t);
+    if (cfg.kernels & BENCH_QUANT) __bench_quant(&cfg, t);
+    if (cfg.kernels & BENCH_IM2COL) __bench_im2col(&cfg, t);
+    if (cfg.kernels & BENCH_ATTN) __bench_attn(&cfg, t);
+    if (cfg.kernels & BENCH_SOFTMAX) __bench_softmax(&cfg, t);
+    free(t);
+
+    if (cfg.n_out == 0){
+        __write_results(stdout, cfg.json);
+    }
+    for (int i = 0; i < cfg.n_out; i++){
+        const size_t len = strlen(cfg.out[i]);
+        const int json = len >= 5 && !strcmp(cfg.out[i] + len - 5, ".json");
+        FILE* f = fopen(cfg.out[i], "w");
+        MiCo_assert(f != NULL, "[Bench] cannot open output file");
+        __write_results(f, json);
+        fclose(f);
+    }
+
+    if (cfg.baseline){
+        const int regressions = __compare_baseline(cfg.baseline, cfg.threshold);
+        if (regressions != 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,308 @@
+// Data-cache sweep for SoC cache sizing and im2col block tuning
+// Runs each layer once per cache geometry on the host with the cache model
+// (-DMICO_CACHESIM) and prints one CSV row per layer, geometry and access
+// kind (im2col, quant, matmul, total) with reads, writes, misses and memory
+// writes. Every layer starts from a cold cache.
+//
+// The im2col block size is a compile-time constant (MICO_IM2COL_BLOCK_ROWS),
+// so `make cachesim` builds one binary per entry of CACHE_BLOCKS. Geometries
+// are given as <ways>x<sets>x<line>[,wt][,nwa]; shapes use the latency LUT
+// format:
+//   linear <batch> <in_features> <out_features>
+//   conv   <in_c> <in_h> <in_w> <out_c> <kernel> <stride> <padding> <groups>
+
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+
+#ifndef MICO_BENCH_BACKEND
+#define MICO_BENCH_BACKEND "default"
+#endif
+
+#ifdef USE_ALT_LAYOUT
+#define CS_LAYOUT "alt"
+#else
+#define CS_LAYOUT "default"
+#endif
+
+#ifndef MICO_IM2COL_BLOCK_ROWS
+#define MICO_IM2COL_BLOCK_ROWS 2
+#endif
+
+#ifndef MICO_CS_ALIGN
+#define MICO_CS_ALIGN 32
+#endif
+
+#define MICO_CS_MAX_SHAPES 256
+#define MICO_CS_MAX_CACHES 32
+
+#ifndef MICO_CACHESIM
+#error "mico_cachesim needs -DMICO_CACHESIM (make cachesim)"
+#endif
+
+#define CS_LINEAR 0
+#define CS_CONV   1
+
+typedef struct {
+    int op;
+    size_t batch, in_c, in_h, in_w, out_c;
+    size_t kernel, stride, padding, groups;
+} CS_Shape;
+
+#define CS_LINEAR_SHAPE(b, k, n) { CS_LINEAR, b, k, 1, 1, n, 1, 1, 0, 1 }
+#define CS_CONV_SHAPE(c, h, w, oc, ks, s, p, g) { CS_CONV, 1, c, h, w, oc, ks, s, p, g }
+
+// The im2col block survey layer, then LeNet / small CNN / MLP layers
+static const CS_Shape cs_default_shapes[] = {
+    CS_CONV_SHAPE(16, 32, 32, 16, 5, 1, 0, 1),
+    CS_CONV_SHAPE(1, 28, 28, 6, 5, 1, 0, 1),
+    CS_CONV_SHAPE(6, 12, 12, 16, 5, 1, 0, 1),
+    CS_CONV_SHAPE(3, 32, 32, 32, 3, 1, 1, 1),
+    CS_CONV_SHAPE(32, 16, 16, 32, 3, 1, 1, 32),
+    CS_LINEAR_SHAPE(1, 256, 120),
+    CS_LINEAR_SHAPE(16, 512, 512),
+};
+
+// The two data caches of doc/Survey_On_Im2Col_Blocks.md
+static const char* cs_default_caches[] = { "2x64x64", "4x64x64" };
+
+static const char* cs_kind_names[MICO_CACHE_N_KINDS] = { "im2col", "quant", "matmul" };
+
+static CS_Shape cs_shapes[MICO_CS_MAX_SHAPES];
+static size_t cs_n_shapes = 0;
+static uint32_t cs_seed = 0x1234567u;
+
+static void __fill_bytes(qbyte* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        cs_seed = cs_seed * 1664525u + 1013904223u;
+        p[i] = (qbyte)(cs_seed >> 24);
+    }
+}
+
+static void __fill_f32(float* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        cs_seed = cs_seed * 1664525u + 1013904223u;
+        p[i] = (float)(cs_seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+    }
+}
+
+static size_t __align(const size_t n){
+    return (n + MICO_CS_ALIGN - 1) / MICO_CS_ALIGN * MICO_CS_ALIGN;
+}
+
+static size_t __out_h(const CS_Shape* s){
+    return (s->in_h + 2 * s->padding - s->kernel) / s->stride + 1;
+}
+
+static size_t __out_w(const CS_Shape* s){
+    return (s->in_w + 2 * s->padding - s->kernel) / s->stride + 1;
+}
+
+static size_t __k(const CS_Shape* s){
+    if (s->op == CS_LINEAR) return __align(s->in_c);
+    return __align(s->in_c / s->groups * s->kernel * s->kernel);
+}
+
+static const char* __check(const CS_Shape* s, const qtype aq){
+    if (s->op == CS_CONV){
+        if (s->kernel == 0 || s->stride == 0 || s->groups == 0) return "invalid conv";
+        if (s->in_c % s->groups || s->out_c % s->groups) return "channels not divisible by groups";
+        if (s->in_h + 2 * s->padding < s->kernel || s->in_w + 2 * s->padding < s->kernel)
+            return "kernel larger than input";
+    }
+    if (s->batch == 0 || s->in_c == 0 || s->out_c == 0) return "empty shape";
+    const size_t rows = s->op == CS_LINEAR ? s->batch : MICO_IM2COL_BLOCK_ROWS * __out_w(s);
+    if (rows * __k(s) / (8 / aq) >= QUANTIZE_BUFFER_SIZE) return "exceeds QUANTIZE_BUFFER_SIZE";
+    return NULL;
+}
+
+static void __run(const CS_Shape* s, const qtype aq, const qtype wq){
+    const size_t K = __k(s);
+    const size_t wbytes = s->out_c * K * wq / 8;
+    qbyte* wd = MiCo_malloc(wbytes);
+    float* bias = MiCo_malloc(s->out_c * sizeof(float));
+    MiCo_assert(wd != NULL && bias != NULL, "[CacheSim] failed to allocate weights");
+    __fill_bytes(wd, wbytes);
+    __fill_f32(bias, s->out_c);
+    Tensor1D_F32 b = { .shape = {s->out_c}, .data = bias };
+
+    size_t x_size, y_size;
+    if (s->op == CS_LINEAR){
+        x_size = s->batch * s->in_c;
+        y_size = s->batch * s->out_c;
+    } else {
+        x_size = s->in_c * s->in_h * s->in_w;
+        y_size = s->out_c * __out_h(s) * __out_w(s);
+    }
+    float* x = MiCo_malloc(x_size * sizeof(float));
+    float* y = MiCo_malloc(y_size * sizeof(float));
+    MiCo_assert(x != NULL && y != NULL, "[CacheSim] failed to allocate activations");
+    __fill_f32(x, x_size);
+
+    MiCo_QX_Buffer_Global.src = NULL;
+    MiCo_cache_reset();
+    if (s->op == CS_LINEAR){
+        Tensor2D_F32 xt = { .shape = {s->batch, s->in_c}, .data = x };
+        Tensor2D_F32 yt = { .shape = {s->batch, s->out_c}, .data = y };
+        #ifdef USE_ALT_LAYOUT
+        Tensor2D_Q8 w = { .shape = {K, s->out_c}, .data = wd, .scale = 0.01f, .wq = wq };
+        #else
+        Tensor2D_Q8 w = { .shape = {s->out_c, K}, .data = wd, .scale = 0.01f, .wq = wq };
+        #endif
+        MiCo_bitlinear_f32(&yt, &xt, &w, &b, wq, aq, MICO_CS_ALIGN);
+    } else {
+        #ifdef USE_ALT_LAYOUT
+        Tensor4D_F32 xt = { .shape = {1, s->in_h, s->in_w, s->in_c}, .data = x };
+        Tensor4D_F32 yt = { .shape = {1, __out_h(s), __out_w(s), s->out_c}, .data = y };
+        Tensor4D_Q8 w = { .shape = {s->kernel, s->kernel, s->in_c / s->groups, s->out_c},
+            .data = wd, .scale = 0.01f, .wq = wq };
+        #else
+        Tensor4D_F32 xt = { .shape = {1, s->in_c, s->in_h, s->in_w}, .data = x };
+        Tensor4D_F32 yt = { .shape = {1, s->out_c, __out_h(s), __out_w(s)}, .data = y };
+        Tensor4D_Q8 w = { .shape = {s->out_c, s->in_c / s->groups, s->kernel, s->kernel},
+            .data = wd, .scale = 0.01f, .wq = wq };
+        #endif
+        MiCo_bitconv2d_f32(&yt, &xt, &w, &b, wq, aq, s->stride, s->padding, 1,
+            s->groups, MICO_CS_ALIGN);
+    }
+
+    MiCo_free(wd);
+    MiCo_free(bias);
+    MiCo_free(x);
+    MiCo_free(y);
+}
+
+// "<ways>x<sets>x<line>[,wt][,nwa]"
+static int __parse_cache(const char* str, MiCo_Cache_Config* cfg){
+    unsigned ways, sets, line;
+    if (sscanf(str, "%ux%ux%u", &ways, &sets, &line) != 3) return -1;
+    cfg->ways = ways;
+    cfg->sets = sets;
+    cfg->line = line;
+    cfg->write_back = strstr(str, ",wt") == NULL;
+    cfg->write_allocate = strstr(str, ",nwa") == NULL;
+    return 0;
+}
+
+// One layer per line, '#' starts a comment
+static size_t __read_shapes(const char* path){
+    FILE* f = fopen(path, "r");
+    MiCo_assert(f != NULL, "[CacheSim] cannot open shape file");
+    char line[256];
+    size_t n = 0;
+    while (fgets(line, sizeof(line), f)){
+        char op[16];
+        CS_Shape* s = &cs_shapes[n];
+        if (line[0] == '#' || sscanf(line, "%15s", op) != 1) continue;
+        MiCo_assert(n < MICO_CS_MAX_SHAPES, "[CacheSim] too many shapes");
+        if (!strcmp(op, "linear")){
+            const CS_Shape d = CS_LINEAR_SHAPE(0, 0, 0);
+            *s = d;
+            MiCo_assert(sscanf(line, "%*s %zu %zu %zu", &s->batch, &s->in_c, &s->out_c) == 3,
+                "[CacheSim] expected: linear <batch> <in_features> <out_features>");
+        } else if (!strcmp(op, "conv")){
+            const CS_Shape d = CS_CONV_SHAPE(0, 0, 0, 0, 0, 0, 0, 0);
+            *s = d;
+            MiCo_assert(sscanf(line, "%*s %zu %zu %zu %zu %zu %zu %zu %zu", &s->in_c, &s->in_h,
+                &s->in_w, &s->out_c, &s->kernel, &s->stride, &s->padding, &s->groups) == 8,
+                "[CacheSim] expected: conv <in_c> <in_h> <in_w> <out_c> <kernel> <stride> <padding> <groups>");
+        } else {
+            MiCo_assert(0, "[CacheSim] unknown layer type, expected linear or conv");
+        }
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static void __print_row(const CS_Shape* s, const size_t l, const char* cache,
+    const qtype aq, const qtype wq, const char* kind, const MiCo_Cache_Counts* c){
+    printf("%s,%s,%d,\"%s\",%ld,%s,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%d,%d,%s,%lu,%lu,%lu,%lu,%lu\n",
+        MICO_BENCH_BACKEND, CS_LAYOUT, MICO_IM2COL_BLOCK_ROWS, cache, (long)l,
+        s->op == CS_LINEAR ? "linear" : "conv",
+        (long)s->batch, (long)s->in_c, (long)s->in_h, (long)s->in_w, (long)s->out_c,
+        (long)s->kernel, (long)s->stride, (long)s->padding, (long)s->groups,
+        (int)aq, (int)wq, kind,
+        (unsigned long)c->reads, (unsigned long)c->writes,
+        (unsigned long)c->read_misses, (unsigned long)c->write_misses,
+        (unsigned long)c->mem_writes);
+}
+
+int main(int argc, char** argv){
+    const char* shapes = NULL;
+    const char* caches[MICO_CS_MAX_CACHES];
+    int n_caches = 0;
+    int header = 1;
+    qtype aq = 8, wq = 8;
+
+    for (int i = 1; i < argc; i++){
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "--no-header")){
+            header = 0;
+            continue;
+        }
+        if (v != NULL && !strcmp(a, "--shapes")) shapes = v;
+        else if (v != NULL && !strcmp(a, "--cache") && n_caches < MICO_CS_MAX_CACHES) caches[n_caches++] = v;
+        else if (v != NULL && !strcmp(a, "--aq")) aq = (qtype)atoi(v);
+        else if (v != NULL && !strcmp(a, "--wq")) wq = (qtype)atoi(v);
+        else {
+            fprintf(stderr, "Usage: %s [--shapes FILE] [--cache WAYSxSETSxLINE[,wt][,nwa]]... "
+                "[--aq N] [--wq N] [--no-header]\n", argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    MiCo_assert((aq == 1 || aq == 2 || aq == 4 || aq == 8) && (wq == 1 || wq == 2 || wq == 4 || wq == 8),
+        "[CacheSim] aq and wq must be 1, 2, 4 or 8");
+    #ifdef USE_ALT_LAYOUT
+    MiCo_assert(aq == 8 && wq == 8, "[CacheSim] [K, N] weights are INT8 only");
+    #endif
+    if (n_caches == 0){
+        for (size_t i = 0; i < sizeof(cs_default_caches) / sizeof(cs_default_caches[0]); i++){
+            caches[n_caches++] = cs_default_caches[i];
+        }
+    }
+
+    if (shapes != NULL){
+        cs_n_shapes = __read_shapes(shapes);
+    } else {
+        for (size_t i = 0; i < sizeof(cs_default_shapes) / sizeof(cs_default_shapes[0]); i++){
+            cs_shapes[cs_n_shapes++] = cs_default_shapes[i];
+        }
+    }
+
+    if (header){
+        printf("backend,layout,block_rows,cache,layer,op,batch,in_c,in_h,in_w,out_c,kernel,stride,"
+            "padding,groups,aq,wq,kind,reads,writes,read_misses,write_misses,mem_writes\n");
+    }
+    for (int c = 0; c < n_caches; c++){
+        MiCo_Cache_Config cfg;
+        if (__parse_cache(caches[c], &cfg) || MiCo_cache_config(&cfg)){
+            fprintf(stderr, "[CacheSim] invalid cache geometry %s\n", caches[c]);
+            return 2;
+        }
+        for (size_t l = 0; l < cs_n_shapes; l++){
+            const CS_Shape* s = &cs_shapes[l];
+            const char* skip = __check(s, aq);
+            if (skip != NULL){
+                if (c == 0) fprintf(stderr, "[CacheSim] layer %ld skipped: %s\n", (long)l, skip);
+                continue;
+            }
+            __run(s, aq, wq);
+            MiCo_Cache_Counts t = { 0 };
+            for (int k = 0; k < MICO_CACHE_N_KINDS; k++){
+                const MiCo_Cache_Counts* n = MiCo_cache_counts(k);
+                __print_row(s, l, caches[c], aq, wq, cs_kind_names[k], n);
+                t.reads += n->reads;
+                t.writes += n->writes;
+                t.read_misses += n->read_misses;
+                t.write_misses += n->write_misses;
+                t.mem_writes += n->mem_writes;
+            }
+            __print_row(s, l, caches[c], aq, wq, "total", &t);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,1650 @@
+// Randomized conformance harness for MiCo-Lib backends
+// Generates random shapes (M and N with arbitrary tails, K on the packing
+// alignment), random packed data for every (aq, wq) in the MatMul table and
+// checks the linked backend bit-exact against a scalar oracle built only on
+// the packing macros of mico_qnn.h. The activation quantizer is checked
+// against a scalar model of the generic quantizer, the conv path is run
+// once with the backend table and once with the oracle table, and the KV
+// cache bookkeeping is checked against its expected block counts. Fused,
+// cached and quantized LLM/ViT kernels are compared with the plain kernels
+// they replace, within a rounding or quantization tolerance and untimed.
+// Every case is also timed against the oracle: a backend that is slower than
+// the scalar reference by more than --threshold fails, as does any mismatch.
+// The backend and the weight layout are selected at build time (see
+// bench/Makefile); under USE_ALT_LAYOUT only the Q8 kernel supports [K, N]
+// weights, so the other pairs are skipped there. On the instruction emulator
+// (MICO_EMU) only correctness is checked, as its timings mean nothing.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include "mico_quant.h"
+#include "mico_runtime.h"
+
+#ifdef USE_HOST
+#include <time.h>
+#endif
+
+#ifdef MICO_EMU
+#define CONFORM_JUDGE_SPEED 0
+#else
+#define CONFORM_JUDGE_SPEED 1
+#endif
+
+#ifndef MICO_BENCH_BACKEND
+#define MICO_BENCH_BACKEND "default"
+#endif
+
+#ifdef USE_ALT_LAYOUT
+#define CONFORM_LAYOUT "alt"
+#else
+#define CONFORM_LAYOUT "default"
+#endif
+
+#define CONFORM_MAX_ROWS 4096
+#define CONFORM_ALIGN 32
+
+extern MiCoRuntime MiCo_runtime;
+
+typedef struct {
+    char check[16];
+    char variant[16];
+    size_t m, k, n;
+    size_t mismatches;
+    double median_us;
+    double ref_us;
+    int judged;         // speed is judged against ref_us
+} ConformRow;
+
+typedef struct {
+    uint32_t seed;
+    int cases;
+    int reps;
+    size_t max_m, max_k, max_n;
+    size_t k_align;
+    unsigned checks;
+    double threshold;
+    double min_us;
+    const char* out;
+    const char* baseline;
+    int verbose;
+} ConformConfig;
+
+enum {
+    CONFORM_MATMUL = 1 << 0,
+    CONFORM_QUANT  = 1 << 1,
+    CONFORM_CONV   = 1 << 2,
+    CONFORM_KV     = 1 << 3,
+    CONFORM_ATTN   = 1 << 4,
+    CONFORM_LINEAR = 1 << 5,
+};
+
+static ConformRow rows[CONFORM_MAX_ROWS];
+static int n_rows = 0;
+static uint32_t rng_state = 1;
+
+static double __now_us(void){
+    #ifdef USE_HOST
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+    #else
+    return (double)MiCo_time();
+    #endif
+}
+
+// xorshift32, so a seed reproduces the same cases on every libc
+static uint32_t __rand(void){
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+// Uniform in [lo, hi]
+static size_t __rand_range(const size_t lo, const size_t hi){
+    return lo + __rand() % (hi - lo + 1);
+}
+
+static void __fill_bytes(qbyte* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        p[i] = (qbyte)(__rand() >> 24);
+    }
+}
+
+static int __cmp_double(const void* a, const void* b){
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double __median(double* t, const int n){
+    qsort(t, n, sizeof(double), __cmp_double);
+    return n % 2 ? t[n / 2] : 0.5 * (t[n / 2 - 1] + t[n / 2]);
+}
+
+static ConformRow* __new_row(const char* check, const char* variant,
+    const size_t m, const size_t k, const size_t n){
+    MiCo_assert(n_rows < CONFORM_MAX_ROWS, "[Conform] too many cases");
+    ConformRow* r = &rows[n_rows++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->check, sizeof(r->check), "%s", check);
+    snprintf(r->variant, sizeof(r->variant), "%s", variant);
+    r->m = m;
+    r->k = k;
+    r->n = n;
+    return r;
+}
+
+static void __pair_name(char* s, const size_t len, const qtype a, const qtype b){
+    if (a == b) snprintf(s, len, "Q%d", a);
+    else snprintf(s, len, "Q%dx%d", a, b);
+}
+
+// ---------------------------------------------------------------------------
+// Scalar oracle
+
+// Element idx of a packed tensor at q bits, decoded as the kernels do
+static int32_t __decode(const qbyte* d, const size_t idx, const qtype q){
+    switch (q){
+        case 8:
+            return (int8_t)d[idx];
+        case 4:
+            return SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(d[idx / 2], idx & 1), 4);
+        case 2:
+            return TWO_BIT_TO_INT8(EXTRACT_2BIT(d[idx / 4], idx & 3));
+        default:
+            return BIT_TO_INT8(EXTRACT_BIT(d[idx / 8], idx & 7));
+    }
+}
+
+// O[M, N] = X[M, K] . W^T, W is [N, K] (or [K, N] under USE_ALT_LAYOUT)
+static void __ref_matmul(int32_t* O, const Tensor2D_Q8* x, const Tensor2D_Q8* w,
+    const qtype xq, const qtype wq){
+    const size_t M = x->shape[0];
+    const size_t K = x->shape[1];
+    #ifdef USE_ALT_LAYOUT
+    const size_t N = w->shape[1];
+    #else
+    const size_t N = w->shape[0];
+    #endif
+    for (size_t i = 0; i < M; i++){
+        for (size_t j = 0; j < N; j++){
+            int32_t acc = 0;
+            for (size_t k = 0; k < K; k++){
+                #ifdef USE_ALT_LAYOUT
+                const size_t wi = k * N + j;
+                #else
+                const size_t wi = j * K + k;
+                #endif
+                acc += __decode(x->data, i * K + k, xq) * __decode(w->data, wi, wq);
+            }
+            O[i * N + j] += acc;
+        }
+    }
+}
+
+#define __REF_MM(a, b) \
+    static void __ref_mm_##a##_##b(int32_t* O, const Tensor2D_Q8* x, const Tensor2D_Q8* w){ \
+        __ref_matmul(O, x, w, a, b); \
+    }
+__REF_MM(1, 1) __REF_MM(1, 2) __REF_MM(1, 4) __REF_MM(1, 8)
+__REF_MM(2, 1) __REF_MM(2, 2) __REF_MM(2, 4) __REF_MM(2, 8)
+__REF_MM(4, 1) __REF_MM(4, 2) __REF_MM(4, 4) __REF_MM(4, 8)
+__REF_MM(8, 1) __REF_MM(8, 2) __REF_MM(8, 4) __REF_MM(8, 8)
+
+static MatMulFunc ref_table[MAX_QTYPE_LOG2 + 1][MAX_QTYPE_LOG2 + 1] = {
+    {__ref_mm_1_1, __ref_mm_1_2, __ref_mm_1_4, __ref_mm_1_8},
+    {__ref_mm_2_1, __ref_mm_2_2, __ref_mm_2_4, __ref_mm_2_8},
+    {__ref_mm_4_1, __ref_mm_4_2, __ref_mm_4_4, __ref_mm_4_8},
+    {__ref_mm_8_1, __ref_mm_8_2, __ref_mm_8_4, __ref_mm_8_8},
+};
+
+// Model of the generic activation quantizer: one scale per tensor, values
+// packed low bits first, padding and incomplete trailing groups are zero.
+static float __ref_quant(qbyte* q, const float* x, const size_t rows,
+    const size_t cols, const size_t qcols, const qtype aq){
+    const size_t per_byte = 8 / aq;
+    float absmax = 0.f, absmean = 0.f;
+    for (size_t i = 0; i < rows * cols; i++){
+        const float v = fabsf(x[i]);
+        if (v > absmax) absmax = v;
+        absmean += v;
+    }
+    absmean /= rows * cols;
+    const float scale = aq == 8 ? 127.0f / absmax : aq == 4 ? 7.0f / absmax : 1.0f / absmax;
+    memset(q, 0, rows * qcols / per_byte);
+    for (size_t r = 0; r < rows; r++){
+        for (size_t c = 0; c + per_byte <= cols; c += per_byte){
+            for (size_t j = 0; j < per_byte; j++){
+                const float v = x[r * cols + c + j];
+                const size_t idx = r * qcols + c + j;
+                uint8_t bits;
+                if (aq == 1){
+                    bits = v <= 0;
+                } else {
+                    int8_t iv = (int8_t)roundf(v * scale);
+                    if (aq == 2) iv = CLAMP_INT2(iv & 0x3);
+                    bits = (uint8_t)iv & ((1 << aq) - 1);
+                }
+                q[idx / per_byte] |= bits << (aq * (idx % per_byte));
+            }
+        }
+    }
+    return aq == 1 ? absmean : 1.0f / scale;
+}
+
+// Uniform in [-1, 1)
+static void __fill_f32(float* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        p[i] = (float)(__rand() >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+    }
+}
+
+static float __absmax_f32(const float* x, const size_t n){
+    float m = 0.f;
+    for (size_t i = 0; i < n; i++){
+        if (fabsf(x[i]) > m) m = fabsf(x[i]);
+    }
+    return m;
+}
+
+// Values of got further than atol + rtol * |ref| from ref (NaN included)
+static size_t __count_far(const float* got, const float* ref, const size_t n,
+    const float atol, const float rtol, const int verbose){
+    size_t far = 0;
+    for (size_t i = 0; i < n; i++){
+        if (!(fabsf(got[i] - ref[i]) <= atol + rtol * fabsf(ref[i]))){
+            if (far == 0 && verbose){
+                fprintf(stderr, "  first mismatch at %zu: got %g, expected %g\n", i, got[i], ref[i]);
+            }
+            far++;
+        }
+    }
+    return far;
+}
+
+// ---------------------------------------------------------------------------
+// Checks
+
+typedef void (*__timed_fn)(void* ctx);
+
+static double __time_median(__timed_fn f, void* ctx, double* t, const int reps){
+    for (int r = 0; r < reps; r++){
+        const double t0 = __now_us();
+        f(ctx);
+        t[r] = __now_us() - t0;
+    }
+    return __median(t, reps);
+}
+
+typedef struct {
+    MatMulFunc f;
+    int32_t* O;
+    size_t size;
+    const Tensor2D_Q8 *x, *w;
+} __mm_ctx;
+
+static void __run_mm(void* p){
+    __mm_ctx* c = p;
+    memset(c->O, 0, c->size * sizeof(int32_t));
+    c->f(c->O, c->x, c->w);
+}
+
+static void __check_matmul(const ConformConfig* cfg, double* t){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t M = __rand_range(1, cfg->max_m);
+        const size_t N = __rand_range(1, cfg->max_n);
+        const size_t K = __rand_range(1, cfg->max_k / cfg->k_align) * cfg->k_align;
+        qbyte* xd = malloc(M * K);
+        qbyte* wd = malloc(N * K);
+        int32_t* O = malloc(M * N * sizeof(int32_t));
+        int32_t* R = malloc(M * N * sizeof(int32_t));
+        MiCo_assert(xd != NULL && wd != NULL && O != NULL && R != NULL,
+            "[Conform] failed to allocate buffers");
+        __fill_bytes(xd, M * K);
+        __fill_bytes(wd, N * K);
+
+        for (int a = MAX_QTYPE_LOG2; a >= 0; a--)
+        for (int b = MAX_QTYPE_LOG2; b >= 0; b--){
+            #ifdef USE_ALT_LAYOUT
+            if (a != 3 || b != 3) continue;
+            Tensor2D_Q8 qw = { .shape = {K, N}, .data = wd, .scale = 1.0f, .wq = 1 << b };
+            #else
+            Tensor2D_Q8 qw = { .shape = {N, K}, .data = wd, .scale = 1.0f, .wq = 1 << b };
+            #endif
+            Tensor2D_Q8 qx = { .shape = {M, K}, .data = xd, .scale = 1.0f, .wq = 1 << a };
+            char variant[16];
+            __pair_name(variant, sizeof(variant), 1 << a, 1 << b);
+            ConformRow* r = __new_row("matmul", variant, M, K, N);
+            r->judged = CONFORM_JUDGE_SPEED;
+
+            __mm_ctx ref = { ref_table[a][b], R, M * N, &qx, &qw };
+            __mm_ctx dut = { MiCo_runtime.matmul_matrix[a][b], O, M * N, &qx, &qw };
+            r->ref_us = __time_median(__run_mm, &ref, t, cfg->reps);
+            r->median_us = __time_median(__run_mm, &dut, t, cfg->reps);
+            for (size_t i = 0; i < M * N; i++){
+                if (O[i] != R[i]){
+                    if (r->mismatches == 0 && cfg->verbose){
+                        fprintf(stderr, "  first mismatch at (%zu, %zu): got %d, expected %d\n",
+                            i / N, i % N, (int)O[i], (int)R[i]);
+                    }
+                    r->mismatches++;
+                }
+            }
+        }
+        free(xd);
+        free(wd);
+        free(O);
+        free(R);
+    }
+}
+
+typedef struct {
+    Tensor2D_Q8* q;
+    const Tensor2D_F32* x;
+    qtype aq;
+    qbyte* ref;
+    float ref_scale;
+} __quant_ctx;
+
+static void __run_quant(void* p){
+    __quant_ctx* c = p;
+    MiCo_2D_quant_act(c->q, c->x, c->aq, CONFORM_ALIGN);
+}
+
+static void __run_quant_ref(void* p){
+    __quant_ctx* c = p;
+    c->ref_scale = __ref_quant(c->ref, c->x->data, c->x->shape[0], c->x->shape[1],
+        (c->x->shape[1] + CONFORM_ALIGN - 1) / CONFORM_ALIGN * CONFORM_ALIGN, c->aq);
+}
+
+static void __check_quant(const ConformConfig* cfg, double* t){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t M = __rand_range(1, cfg->max_m);
+        // at least one full 8-element group per row
+        const size_t K = __rand_range(8, cfg->max_k);
+        const size_t qsize = MiCo_qact_size(M, K, 8, CONFORM_ALIGN);
+        float* xf = malloc(M * K * sizeof(float));
+        qbyte* q = malloc(qsize);
+        qbyte* ref = malloc(qsize);
+        MiCo_assert(xf != NULL && q != NULL && ref != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(xf, M * K);
+        Tensor2D_F32 x = { .shape = {M, K}, .data = xf };
+
+        for (int a = MAX_QTYPE_LOG2; a >= 0; a--){
+            const qtype aq = 1 << a;
+            Tensor2D_Q8 qx = { .data = q };
+            char variant[16];
+            snprintf(variant, sizeof(variant), "A%d", aq);
+            // The model skips the clamping and padding branches of a real
+            // quantizer, so it is no speed reference; only --baseline judges.
+            ConformRow* r = __new_row("quant", variant, M, K, 0);
+
+            __quant_ctx c = { &qx, &x, aq, ref, 0.f };
+            r->ref_us = __time_median(__run_quant_ref, &c, t, cfg->reps);
+            r->median_us = __time_median(__run_quant, &c, t, cfg->reps);
+            const size_t n = MiCo_qact_size(M, K, aq, CONFORM_ALIGN);
+            for (size_t i = 0; i < n; i++){
+                if (q[i] != ref[i]) r->mismatches++;
+            }
+            // absmean is a sum, so SIMD quantizers may round it differently
+            const float tol = aq == 1 ? 1e-5f * c.ref_scale : 0.f;
+            if (fabsf(qx.scale - c.ref_scale) > tol) r->mismatches++;
+            if (r->mismatches && cfg->verbose){
+                fprintf(stderr, "  scale %g, expected %g\n", qx.scale, c.ref_scale);
+            }
+        }
+        free(xf);
+        free(q);
+        free(ref);
+    }
+}
+
+typedef struct {
+    Tensor4D_F32 *y;
+    const Tensor4D_F32 *x;
+    const Tensor4D_Q8 *w;
+    const Tensor1D_F32 *bias;
+    qtype wq, aq;
+    size_t stride, pad;
+    MatMulFunc (*table)[MAX_QTYPE_LOG2 + 1];
+} __conv_ctx;
+
+static void __run_conv(void* p){
+    __conv_ctx* c = p;
+    MatMulFunc (*saved)[MAX_QTYPE_LOG2 + 1] = MiCo_runtime.matmul_matrix;
+    MiCo_runtime.matmul_matrix = c->table;
+    MiCo_bitconv2d_f32(c->y, c->x, c->w, c->bias, c->wq, c->aq,
+        c->stride, c->pad, 1, 1, CONFORM_ALIGN);
+    MiCo_runtime.matmul_matrix = saved;
+}
+
+// The conv path (im2col, block quantization, MatMul, dequant) once with the
+// backend table and once with the oracle table; outputs must be identical.
+static void __check_conv(const ConformConfig* cfg, double* t){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t C = __rand_range(1, 16);
+        const size_t OC = __rand_range(1, 24);
+        const size_t H = __rand_range(3, 14), W = __rand_range(3, 14);
+        const size_t ks = __rand() & 1 ? 3 : 1;
+        const size_t stride = __rand_range(1, 2), pad = ks == 3 ? __rand_range(0, 1) : 0;
+        const size_t OH = (H + 2 * pad - ks) / stride + 1;
+        const size_t OW = (W + 2 * pad - ks) / stride + 1;
+        const size_t aligned = (C * ks * ks + CONFORM_ALIGN - 1) / CONFORM_ALIGN * CONFORM_ALIGN;
+        float* xf = malloc(C * H * W * sizeof(float));
+        float* bf = malloc(OC * sizeof(float));
+        qbyte* wd = malloc(OC * aligned);
+        float* y = malloc(OC * OH * OW * sizeof(float));
+        float* yr = malloc(OC * OH * OW * sizeof(float));
+        MiCo_assert(xf != NULL && bf != NULL && wd != NULL && y != NULL && yr != NULL,
+            "[Conform] failed to allocate buffers");
+        __fill_f32(xf, C * H * W);
+        __fill_f32(bf, OC);
+        __fill_bytes(wd, OC * aligned);
+        Tensor1D_F32 bias = { .shape = {OC}, .data = bf };
+        #ifdef USE_ALT_LAYOUT
+        Tensor4D_F32 x = { .shape = {1, H, W, C}, .data = xf };
+        Tensor4D_Q8 w = { .shape = {ks, ks, C, OC}, .data = wd, .scale = 0.01f };
+        Tensor4D_F32 yo = { .shape = {1, OH, OW, OC}, .data = y };
+        Tensor4D_F32 yo_ref = { .shape = {1, OH, OW, OC}, .data = yr };
+        #else
+        Tensor4D_F32 x = { .shape = {1, C, H, W}, .data = xf };
+        Tensor4D_Q8 w = { .shape = {OC, C, ks, ks}, .data = wd, .scale = 0.01f };
+        Tensor4D_F32 yo = { .shape = {1, OC, OH, OW}, .data = y };
+        Tensor4D_F32 yo_ref = { .shape = {1, OC, OH, OW}, .data = yr };
+        #endif
+
+        for (int a = MAX_QTYPE_LOG2; a >= 0; a--)
+        for (int b = MAX_QTYPE_LOG2; b >= 0; b--){
+            #ifdef USE_ALT_LAYOUT
+            if (a != 3 || b != 3) continue;
+            #endif
+            const qtype aq = 1 << a, wq = 1 << b;
+            char variant[16];
+            __pair_name(variant, sizeof(variant), aq, wq);
+            ConformRow* r = __new_row("conv", variant, OH * OW, C * ks * ks, OC);
+            r->judged = CONFORM_JUDGE_SPEED;
+
+            __conv_ctx ref = { &yo_ref, &x, &w, &bias, wq, aq, stride, pad, ref_table };
+            __conv_ctx dut = { &yo, &x, &w, &bias, wq, aq, stride, pad, MiCo_runtime.matmul_matrix };
+            r->ref_us = __time_median(__run_conv, &ref, t, cfg->reps);
+            r->median_us = __time_median(__run_conv, &dut, t, cfg->reps);
+            for (size_t i = 0; i < OC * OH * OW; i++){
+                if (memcmp(&y[i], &yr[i], sizeof(float)) != 0) r->mismatches++;
+            }
+        }
+        free(xf);
+        free(bf);
+        free(wd);
+        free(y);
+        free(yr);
+    }
+}
+
+#ifndef USE_ALT_LAYOUT
+// Streaming conv1d pushed in random hops against one full "valid"
+// MiCo_bitconv1d_f32 over the same input. The two quantize the activations
+// in different blocks, so only 8-bit activations are compared, within two
+// quantization steps of the output range.
+static void __check_conv_stream(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t groups = __rand_range(1, 2);
+        const size_t C = groups * __rand_range(1, 8);
+        const size_t OC = groups * __rand_range(1, 8);
+        const size_t ks = __rand_range(1, 5), stride = __rand_range(1, 3);
+        const size_t T = ks + __rand_range(0, 40);
+        const size_t hop = __rand_range(1, 8);
+        const size_t OL = (T - ks) / stride + 1;
+        const size_t aligned = (C / groups * ks + CONFORM_ALIGN - 1) / CONFORM_ALIGN * CONFORM_ALIGN;
+        float* xf = malloc(C * T * sizeof(float));
+        float* xs = malloc(C * hop * sizeof(float));
+        float* bf = malloc(OC * sizeof(float));
+        qbyte* wd = malloc(OC * aligned);
+        float* y = malloc(OC * OL * sizeof(float));
+        float* yr = malloc(OC * OL * sizeof(float));
+        float* ys = malloc(OC * hop * sizeof(float));
+        MiCo_assert(xf != NULL && xs != NULL && bf != NULL && wd != NULL && y != NULL &&
+            yr != NULL && ys != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(xf, C * T);
+        __fill_f32(bf, OC);
+        __fill_bytes(wd, OC * aligned);
+        Tensor1D_F32 bias = { .shape = {OC}, .data = bf };
+        Tensor3D_F32 x = { .shape = {1, C, T}, .data = xf };
+        Tensor3D_F32 yo_ref = { .shape = {1, OC, OL}, .data = yr };
+
+        for (int b = MAX_QTYPE_LOG2; b >= 0; b--){
+            const qtype wq = 1 << b;
+            Tensor3D_Q8 w = { .shape = {OC, C / groups, ks}, .data = wd, .scale = 0.01f, .wq = wq };
+            char variant[16];
+            __pair_name(variant, sizeof(variant), 8, wq);
+            ConformRow* r = __new_row("conv1d_stream", variant, OL, C / groups * ks, OC);
+            MiCo_bitconv1d_f32(&yo_ref, &x, &w, &bias, wq, 8, stride, 0, 1, groups, CONFORM_ALIGN);
+
+            MiCo_Conv1D_Stream s;
+            MiCo_conv1d_stream_init(&s, C, ks, stride, 1, hop);
+            size_t done = 0;
+            for (size_t t0 = 0; t0 < T && done <= OL; ){
+                size_t n = __rand_range(1, hop);
+                if (n > T - t0) n = T - t0;
+                for (size_t c = 0; c < C; c++){
+                    memcpy(xs + c * n, xf + c * T + t0, n * sizeof(float));
+                }
+                Tensor3D_F32 xt = { .shape = {1, C, n}, .data = xs };
+                Tensor3D_F32 yt = { .shape = {1, OC, hop}, .data = ys };
+                const size_t got = MiCo_bitconv1d_stream_f32(&yt, &xt, &s, &w, &bias, wq, 8,
+                    groups, CONFORM_ALIGN);
+                for (size_t oc = 0; oc < OC && done + got <= OL; oc++){
+                    memcpy(y + oc * OL + done, ys + oc * got, got * sizeof(float));
+                }
+                done += got;
+                t0 += n;
+            }
+            MiCo_conv1d_stream_free(&s);
+            if (done != OL){
+                if (cfg->verbose) fprintf(stderr, "  stream produced %zu of %zu frames\n", done, OL);
+                r->mismatches++;
+                continue;
+            }
+            const float tol = 2.0f / 127.0f * __absmax_f32(yr, OC * OL);
+            r->mismatches += __count_far(y, yr, OC * OL, tol, 0.f, cfg->verbose);
+        }
+        free(xf);
+        free(xs);
+        free(bf);
+        free(wd);
+        free(y);
+        free(yr);
+        free(ys);
+    }
+}
+#endif
+
+// Append n random timesteps to seq
+static void __kv_fill(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq, const int n){
+    float k[8], v[8];
+    for (int i = 0; i < n; i++){
+        __fill_f32(k, 8);
+        __fill_f32(v, 8);
+        MiCo_assert(MiCo_kv_seq_append(pool, seq, k, v) == 0, "[Conform] KV pool exhausted");
+    }
+}
+
+// Prefix cache bookkeeping: sequence B recomputes the last cached block of
+// prompt P (match never covers the last prompt token), then caches further
+// blocks chained to A's copy. While B lives that copy must not be evicted,
+// a later match must reach B's blocks, and once every sequence is gone the
+// whole cache must drain back into the pool.
+static void __check_prefix(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const int bs = (int)__rand_range(1, 8);
+        const int nb = (int)__rand_range(1, 6);
+        const int extra = (int)__rand_range(1, 3);
+        const int n_tok = (nb + extra) * bs + 1;
+        const int n_blocks = 2 * (nb + extra) + 2;
+        int* tokens = malloc(n_tok * sizeof(int));
+        MiCo_assert(tokens != NULL, "[Conform] failed to allocate buffers");
+        for (int i = 0; i < n_tok; i++) tokens[i] = (int)(__rand() >> 16);
+
+        MiCo_KV_Pool pool;
+        MiCo_KV_Prefix_Cache cache;
+        MiCo_KV_Seq a, b, c;
+        MiCo_kv_pool_init(&pool, n_blocks, bs, 8, 32);
+        MiCo_kv_prefix_init(&cache, &pool, n_blocks);
+        MiCo_kv_seq_init(&a, n_blocks);
+        MiCo_kv_seq_init(&b, n_blocks);
+        MiCo_kv_seq_init(&c, n_blocks);
+        ConformRow* r = __new_row("prefix", "fp32", n_tok, bs, nb);
+
+        __kv_fill(&pool, &a, nb * bs);
+        r->mismatches += MiCo_kv_prefix_insert(&cache, &a, tokens, nb * bs) != nb;
+        MiCo_kv_seq_release(&pool, &a);
+
+        const int matched = MiCo_kv_prefix_match(&cache, &b, tokens, nb * bs);
+        r->mismatches += matched != (nb - 1) * bs;
+        __kv_fill(&pool, &b, (nb + extra) * bs - matched);
+        r->mismatches += MiCo_kv_prefix_insert(&cache, &b, tokens, (nb + extra) * bs) != extra;
+        r->mismatches += MiCo_kv_prefix_evict(&cache, n_blocks) != 0;
+        r->mismatches += MiCo_kv_prefix_match(&cache, &c, tokens, n_tok) != (nb + extra) * bs;
+
+        MiCo_kv_seq_release(&pool, &b);
+        MiCo_kv_seq_release(&pool, &c);
+        r->mismatches += MiCo_kv_prefix_evict(&cache, n_blocks) != nb + extra;
+        r->mismatches += cache.n_entries != 0 || pool.n_free != n_blocks;
+        if (r->mismatches && cfg->verbose){
+            fprintf(stderr, "  prefix bs %d, %d + %d blocks: %d entries left, %d of %d blocks free\n",
+                bs, nb, extra, cache.n_entries, pool.n_free, n_blocks);
+        }
+        MiCo_kv_seq_free(&pool, &a);
+        MiCo_kv_seq_free(&pool, &b);
+        MiCo_kv_seq_free(&pool, &c);
+        MiCo_kv_prefix_free(&cache);
+        MiCo_kv_pool_free(&pool);
+        free(tokens);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Attention and fused-kernel checks
+// Each fused, cached or quantized kernel is compared against the plain
+// kernel it replaces. Results differ by summation order or by one extra
+// quantization, so they are compared within a tolerance and not timed.
+
+static float* __new_f32(const size_t n){
+    float* p = malloc((n ? n : 1) * sizeof(float));
+    MiCo_assert(p != NULL, "[Conform] failed to allocate buffers");
+    return p;
+}
+
+// GQA shape with head_size a multiple of 4 (whole 2-bit KV bytes, RoPE pairs)
+static MiCo_MHA_Config __rand_mha(const int seq_len, const int min_kv_mul){
+    const int n_kv_heads = (int)__rand_range(1, 3);
+    MiCo_MHA_Config c;
+    c.kv_mul = (int)__rand_range(min_kv_mul, 3);
+    c.n_heads = n_kv_heads * c.kv_mul;
+    c.head_size = 4 * (int)__rand_range(1, 8);
+    c.kv_dim = n_kv_heads * c.head_size;
+    c.seq_len = seq_len;
+    return c;
+}
+
+// Append timesteps [t0, t1) of contiguous K/V rows to seq
+static void __kv_append(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq, const float* k,
+    const float* v, const int t0, const int t1){
+    for (int t = t0; t < t1; t++){
+        MiCo_assert(MiCo_kv_seq_append(pool, seq, k + (size_t)t * pool->kv_dim,
+            v + (size_t)t * pool->kv_dim) == 0, "[Conform] KV pool exhausted");
+    }
+}
+
+// Paged attention against MiCo_multihead_attention_f32 / _kv8 on the same
+// rows stored contiguously. The free list is shuffled first, so logical
+// blocks land on scattered, out-of-order physical blocks. Sequence "prefix"
+// maps the blocks of the first one through the prefix cache and appends
+// the recomputed tail itself.
+static void __check_paged(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const int bs = (int)__rand_range(1, 8);
+        const int L = (int)__rand_range(2, 40);
+        const int pos = (int)__rand_range(0, L - 1);
+        const MiCo_MHA_Config mha = __rand_mha(L, 1);
+        const int dim = mha.n_heads * mha.head_size, kv_dim = mha.kv_dim;
+        const int n_blocks = 2 * ((L + bs - 1) / bs) + 2;
+        float* kf = __new_f32(L * kv_dim);
+        float* vf = __new_f32(L * kv_dim);
+        float* ks = __new_f32(L);
+        float* vs = __new_f32(L);
+        float* q = __new_f32(dim);
+        float* out = __new_f32(dim);
+        float* ref = __new_f32(dim);
+        float* att = __new_f32(mha.n_heads * L);
+        int8_t* k8 = malloc(L * kv_dim);
+        int8_t* v8 = malloc(L * kv_dim);
+        int* tokens = malloc(L * sizeof(int));
+        MiCo_assert(k8 != NULL && v8 != NULL && tokens != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(kf, L * kv_dim);
+        __fill_f32(vf, L * kv_dim);
+        __fill_f32(q, dim);
+        for (int t = 0; t < L; t++){
+            ks[t] = __FP32toQ8((qbyte*)(k8 + t * kv_dim), kf + t * kv_dim, kv_dim);
+            vs[t] = __FP32toQ8((qbyte*)(v8 + t * kv_dim), vf + t * kv_dim, kv_dim);
+            tokens[t] = (int)(__rand() >> 16);
+        }
+        Tensor2D_F32 qt = { .shape = {mha.n_heads, mha.head_size}, .data = q };
+        Tensor2D_F32 ot = { .shape = {mha.n_heads, mha.head_size}, .data = out };
+        Tensor2D_F32 rt = { .shape = {mha.n_heads, mha.head_size}, .data = ref };
+
+        for (int bits = 32; bits >= 8; bits -= 24){
+            if (bits == 32) MiCo_multihead_attention_f32(&rt, &qt, kf, vf, att, pos, &mha);
+            else MiCo_multihead_attention_f32_kv8(&rt, &qt, k8, v8, ks, vs, att, pos, &mha);
+
+            MiCo_KV_Pool pool;
+            MiCo_KV_Prefix_Cache cache;
+            MiCo_KV_Seq a, b;
+            MiCo_kv_pool_init(&pool, n_blocks, bs, kv_dim, bits);
+            for (int i = pool.n_free - 1; i > 0; i--){
+                const int j = (int)__rand_range(0, i);
+                const int blk = pool.free_list[i];
+                pool.free_list[i] = pool.free_list[j];
+                pool.free_list[j] = blk;
+            }
+            MiCo_kv_prefix_init(&cache, &pool, n_blocks);
+            MiCo_kv_seq_init(&a, n_blocks);
+            MiCo_kv_seq_init(&b, n_blocks);
+            __kv_append(&pool, &a, kf, vf, 0, L);
+            MiCo_kv_prefix_insert(&cache, &a, tokens, L);
+            __kv_append(&pool, &b, kf, vf, MiCo_kv_prefix_match(&cache, &b, tokens, L), L);
+
+            const MiCo_KV_Seq* seqs[2] = { &a, &b };
+            for (int s = 0; s < 2; s++){
+                char variant[16];
+                snprintf(variant, sizeof(variant), "%s%s", bits == 32 ? "fp32" : "kv8", s ? "_prefix" : "");
+                ConformRow* r = __new_row("paged", variant, pos + 1, bs, mha.n_heads);
+                if (bits == 32) MiCo_paged_attention_f32(&ot, &qt, &pool, seqs[s], att, pos, &mha);
+                else MiCo_paged_attention_f32_kv8(&ot, &qt, &pool, seqs[s], att, pos, &mha);
+                r->mismatches = __count_far(out, ref, dim, 1e-6f, 1e-4f, cfg->verbose);
+            }
+            MiCo_kv_seq_free(&pool, &a);
+            MiCo_kv_seq_free(&pool, &b);
+            MiCo_kv_prefix_free(&cache);
+            MiCo_kv_pool_free(&pool);
+        }
+        free(kf);
+        free(vf);
+        free(ks);
+        free(vs);
+        free(q);
+        free(out);
+        free(ref);
+        free(att);
+        free(k8);
+        free(v8);
+        free(tokens);
+    }
+}
+
+// Packed 4/2-bit KV attention against MiCo_multihead_attention_f32 on the
+// de-quantized cache, so only the packed dot/axpy arithmetic is compared.
+static void __check_kvq(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const int L = (int)__rand_range(1, 40);
+        const int pos = (int)__rand_range(0, L - 1);
+        const MiCo_MHA_Config mha = __rand_mha(L, 1);
+        const int dim = mha.n_heads * mha.head_size, kv_dim = mha.kv_dim;
+        const int group = mha.head_size % 8 == 0 ? mha.head_size / 2 : mha.head_size;
+        const int n_groups = kv_dim / group;
+        float* kf = __new_f32(L * kv_dim);
+        float* vf = __new_f32(L * kv_dim);
+        float* kd = __new_f32(L * kv_dim);
+        float* vd = __new_f32(L * kv_dim);
+        float* ks = __new_f32(L * n_groups);
+        float* vs = __new_f32(L * n_groups);
+        float* q = __new_f32(dim);
+        float* out = __new_f32(dim);
+        float* ref = __new_f32(dim);
+        float* att = __new_f32(mha.n_heads * L);
+        qbyte* kq = malloc(L * kv_dim / 2);
+        qbyte* vq = malloc(L * kv_dim / 2);
+        MiCo_assert(kq != NULL && vq != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(kf, L * kv_dim);
+        __fill_f32(vf, L * kv_dim);
+        __fill_f32(q, dim);
+        Tensor2D_F32 qt = { .shape = {mha.n_heads, mha.head_size}, .data = q };
+        Tensor2D_F32 ot = { .shape = {mha.n_heads, mha.head_size}, .data = out };
+        Tensor2D_F32 rt = { .shape = {mha.n_heads, mha.head_size}, .data = ref };
+
+        for (qtype bits = 4; bits >= 2; bits -= 2){
+            for (int t = 0; t < L; t++){
+                MiCo_kv_cache_store_q(kq, ks, kf + t * kv_dim, t, kv_dim, group, bits);
+                MiCo_kv_cache_store_q(vq, vs, vf + t * kv_dim, t, kv_dim, group, bits);
+            }
+            for (int i = 0; i < L * kv_dim; i++){
+                const qbyte kb = kq[i * bits / 8], vb = vq[i * bits / 8];
+                const int sh = i % (8 / bits);
+                const int8_t ki = bits == 4 ? SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(kb, sh), 4) :
+                    SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(kb, sh), 2);
+                const int8_t vi = bits == 4 ? SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(vb, sh), 4) :
+                    SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(vb, sh), 2);
+                kd[i] = ki * ks[i / group];
+                vd[i] = vi * vs[i / group];
+            }
+            char variant[16];
+            snprintf(variant, sizeof(variant), "Q%d", bits);
+            ConformRow* r = __new_row("kvq", variant, pos + 1, group, mha.n_heads);
+            MiCo_multihead_attention_f32(&rt, &qt, kd, vd, att, pos, &mha);
+            MiCo_multihead_attention_f32_kvq(&ot, &qt, kq, vq, ks, vs, att, pos, group, bits, &mha);
+            r->mismatches = __count_far(out, ref, dim, 1e-6f, 1e-4f, cfg->verbose);
+        }
+        free(kf);
+        free(vf);
+        free(kd);
+        free(vd);
+        free(ks);
+        free(vs);
+        free(q);
+        free(out);
+        free(ref);
+        free(att);
+        free(kq);
+        free(vq);
+    }
+}
+
+// Batched decode against one MiCo_multihead_attention_f32 per sequence
+static void __check_batched(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const int n_seqs = (int)__rand_range(1, 4);
+        const int L = (int)__rand_range(1, 32);
+        const MiCo_MHA_Config mha = __rand_mha(L, 1);
+        const int dim = mha.n_heads * mha.head_size, kv_dim = mha.kv_dim;
+        float* kc = __new_f32(n_seqs * L * kv_dim);
+        float* vc = __new_f32(n_seqs * L * kv_dim);
+        float* q = __new_f32(n_seqs * dim);
+        float* out = __new_f32(n_seqs * dim);
+        float* ref = __new_f32(n_seqs * dim);
+        float* att = __new_f32(n_seqs * mha.n_heads * L);
+        float* kcs[4];
+        float* vcs[4];
+        int pos[4];
+        __fill_f32(kc, n_seqs * L * kv_dim);
+        __fill_f32(vc, n_seqs * L * kv_dim);
+        __fill_f32(q, n_seqs * dim);
+        for (int s = 0; s < n_seqs; s++){
+            kcs[s] = kc + s * L * kv_dim;
+            vcs[s] = vc + s * L * kv_dim;
+            pos[s] = (int)__rand_range(0, L - 1);
+            Tensor2D_F32 qs = { .shape = {mha.n_heads, mha.head_size}, .data = q + s * dim };
+            Tensor2D_F32 rs = { .shape = {mha.n_heads, mha.head_size}, .data = ref + s * dim };
+            MiCo_multihead_attention_f32(&rs, &qs, kcs[s], vcs[s], att, pos[s], &mha);
+        }
+        ConformRow* r = __new_row("batched", "fp32", n_seqs, mha.head_size, mha.n_heads);
+        Tensor2D_F32 qt = { .shape = {n_seqs, dim}, .data = q };
+        Tensor2D_F32 ot = { .shape = {n_seqs, dim}, .data = out };
+        MiCo_multihead_attention_f32_batched(&ot, &qt, kcs, vcs, att, pos, &mha);
+        r->mismatches = __count_far(out, ref, n_seqs * dim, 1e-6f, 1e-4f, cfg->verbose);
+        free(kc);
+        free(vc);
+        free(q);
+        free(out);
+        free(ref);
+        free(att);
+    }
+}
+
+// Sink + sliding-window ring buffer against the plain kernels on a compact
+// cache holding only the attended positions, in order.
+static void __check_window(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        MiCo_MHA_Window win;
+        win.window = (int)__rand_range(1, 8);
+        win.n_sink = (int)__rand_range(0, 3);
+        const int rows = win.n_sink + win.window;
+        const int pos = (int)__rand_range(0, 3 * rows);
+        const MiCo_MHA_Config mha = __rand_mha(rows, 1);
+        const int dim = mha.n_heads * mha.head_size, kv_dim = mha.kv_dim;
+        float* kf = __new_f32((pos + 1) * kv_dim);
+        float* vf = __new_f32((pos + 1) * kv_dim);
+        float* kr = __new_f32(rows * kv_dim);
+        float* vr = __new_f32(rows * kv_dim);
+        float* kc = __new_f32(rows * kv_dim);
+        float* vc = __new_f32(rows * kv_dim);
+        float* krs = __new_f32(rows);
+        float* vrs = __new_f32(rows);
+        float* kcs = __new_f32(rows);
+        float* vcs = __new_f32(rows);
+        float* q = __new_f32(dim);
+        float* out = __new_f32(dim);
+        float* ref = __new_f32(dim);
+        float* att = __new_f32(mha.n_heads * rows);
+        int8_t* kr8 = malloc(rows * kv_dim);
+        int8_t* vr8 = malloc(rows * kv_dim);
+        int8_t* kc8 = malloc(rows * kv_dim);
+        int8_t* vc8 = malloc(rows * kv_dim);
+        MiCo_assert(kr8 != NULL && vr8 != NULL && kc8 != NULL && vc8 != NULL,
+            "[Conform] failed to allocate buffers");
+        __fill_f32(kf, (pos + 1) * kv_dim);
+        __fill_f32(vf, (pos + 1) * kv_dim);
+        __fill_f32(q, dim);
+
+        int len = 0;
+        for (int t = 0; t <= pos; t++){
+            float* kt = kf + t * kv_dim;
+            float* vt = vf + t * kv_dim;
+            const int slot = MiCo_window_slot(&win, t);
+            memcpy(kr + slot * kv_dim, kt, kv_dim * sizeof(float));
+            memcpy(vr + slot * kv_dim, vt, kv_dim * sizeof(float));
+            krs[slot] = __FP32toQ8((qbyte*)(kr8 + slot * kv_dim), kt, kv_dim);
+            vrs[slot] = __FP32toQ8((qbyte*)(vr8 + slot * kv_dim), vt, kv_dim);
+            if (t < win.n_sink || t > pos - win.window){
+                memcpy(kc + len * kv_dim, kt, kv_dim * sizeof(float));
+                memcpy(vc + len * kv_dim, vt, kv_dim * sizeof(float));
+                kcs[len] = __FP32toQ8((qbyte*)(kc8 + len * kv_dim), kt, kv_dim);
+                vcs[len] = __FP32toQ8((qbyte*)(vc8 + len * kv_dim), vt, kv_dim);
+                len++;
+            }
+        }
+        Tensor2D_F32 qt = { .shape = {mha.n_heads, mha.head_size}, .data = q };
+        Tensor2D_F32 ot = { .shape = {mha.n_heads, mha.head_size}, .data = out };
+        Tensor2D_F32 rt = { .shape = {mha.n_heads, mha.head_size}, .data = ref };
+        for (int v = 0; v < 2; v++){
+            ConformRow* r = __new_row("window", v ? "kv8" : "fp32", pos + 1, win.window, win.n_sink);
+            if (v == 0){
+                MiCo_multihead_attention_f32(&rt, &qt, kc, vc, att, len - 1, &mha);
+                MiCo_multihead_attention_f32_window(&ot, &qt, kr, vr, att, pos, &win, &mha);
+            } else {
+                MiCo_multihead_attention_f32_kv8(&rt, &qt, kc8, vc8, kcs, vcs, att, len - 1, &mha);
+                MiCo_multihead_attention_f32_kv8_window(&ot, &qt, kr8, vr8, krs, vrs, att, pos, &win, &mha);
+            }
+            r->mismatches = __count_far(out, ref, dim, 1e-6f, 1e-4f, cfg->verbose);
+        }
+        free(kf);
+        free(vf);
+        free(kr);
+        free(vr);
+        free(kc);
+        free(vc);
+        free(krs);
+        free(vrs);
+        free(kcs);
+        free(vcs);
+        free(q);
+        free(out);
+        free(ref);
+        free(att);
+        free(kr8);
+        free(vr8);
+        free(kc8);
+        free(vc8);
+    }
+}
+
+// Causal prefill, once over the whole prompt and once in chunks of a size
+// that leaves a partial last chunk, against one decode step per token over
+// the cache the prefill wrote. kv_mul >= 2, so query heads share KV heads.
+static void __check_prefill(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const int n_tok = (int)__rand_range(3, 40);
+        int chunk = (int)__rand_range(2, n_tok - 1);
+        while (n_tok % chunk == 0) chunk++;
+        const MiCo_MHA_Config mha = __rand_mha(n_tok, 2);
+        const int dim = mha.n_heads * mha.head_size, kv_dim = mha.kv_dim;
+        float* q = __new_f32(n_tok * dim);
+        float* k = __new_f32(n_tok * kv_dim);
+        float* v = __new_f32(n_tok * kv_dim);
+        float* kc = __new_f32(n_tok * kv_dim);
+        float* vc = __new_f32(n_tok * kv_dim);
+        float* out = __new_f32(n_tok * dim);
+        float* ref = __new_f32(n_tok * dim);
+        float* att = __new_f32(mha.n_heads * n_tok);
+        __fill_f32(q, n_tok * dim);
+        __fill_f32(k, n_tok * kv_dim);
+        __fill_f32(v, n_tok * kv_dim);
+
+        for (int chunked = 0; chunked < 2; chunked++){
+            const int c = chunked ? chunk : n_tok;
+            ConformRow* r = __new_row("prefill", chunked ? "chunked" : "fp32", n_tok, c, mha.n_heads);
+            memset(kc, 0, n_tok * kv_dim * sizeof(float));
+            memset(vc, 0, n_tok * kv_dim * sizeof(float));
+            for (int t0 = 0; t0 < n_tok; t0 += c){
+                const int n = n_tok - t0 < c ? n_tok - t0 : c;
+                Tensor2D_F32 qt = { .shape = {n, dim}, .data = q + t0 * dim };
+                Tensor2D_F32 kt = { .shape = {n, kv_dim}, .data = k + t0 * kv_dim };
+                Tensor2D_F32 vt = { .shape = {n, kv_dim}, .data = v + t0 * kv_dim };
+                Tensor2D_F32 ot = { .shape = {n, dim}, .data = out + t0 * dim };
+                MiCo_multihead_attention_f32_prefill(&ot, &qt, &kt, &vt, kc, vc, t0, &mha);
+            }
+            r->mismatches += memcmp(kc, k, n_tok * kv_dim * sizeof(float)) != 0;
+            r->mismatches += memcmp(vc, v, n_tok * kv_dim * sizeof(float)) != 0;
+            for (int t = 0; t < n_tok; t++){
+                Tensor2D_F32 qs = { .shape = {mha.n_heads, mha.head_size}, .data = q + t * dim };
+                Tensor2D_F32 rs = { .shape = {mha.n_heads, mha.head_size}, .data = ref + t * dim };
+                MiCo_multihead_attention_f32(&rs, &qs, kc, vc, att, t, &mha);
+            }
+            r->mismatches += __count_far(out, ref, n_tok * dim, 1e-6f, 1e-4f, cfg->verbose);
+        }
+        free(q);
+        free(k);
+        free(v);
+        free(kc);
+        free(vc);
+        free(out);
+        free(ref);
+        free(att);
+    }
+}
+
+// Tokens [i0, i0 + n) of every head of q/k [H, N, D] and v [H, N, M]
+static void __gather_tokens(float* qb, float* kb, float* vb, const float* q,
+    const float* k, const float* v, const size_t H, const size_t N, const size_t D,
+    const size_t M, const size_t i0, const size_t n){
+    for (size_t h = 0; h < H; h++){
+        memcpy(qb + h * n * D, q + (h * N + i0) * D, n * D * sizeof(float));
+        memcpy(kb + h * n * D, k + (h * N + i0) * D, n * D * sizeof(float));
+        memcpy(vb + h * n * M, v + (h * N + i0) * M, n * M * sizeof(float));
+    }
+}
+
+// Streaming linear attention, one token per step and in random chunks,
+// against MiCo_linear_attention_f32: token i of the causal form is the
+// last output of the plain kernel over tokens 0..i.
+static void __check_linattn(const ConformConfig* cfg){
+    const float eps = 1e-6f;
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t H = __rand_range(1, 3), D = __rand_range(1, 16);
+        const size_t M = __rand_range(1, 16), N = __rand_range(1, 24);
+        float* q = __new_f32(H * N * D);
+        float* k = __new_f32(H * N * D);
+        float* v = __new_f32(H * N * M);
+        float* qb = __new_f32(H * N * D);
+        float* kb = __new_f32(H * N * D);
+        float* vb = __new_f32(H * N * M);
+        float* yb = __new_f32(N * H * M);
+        float* out = __new_f32(N * H * M);
+        float* ref = __new_f32(N * H * M);
+        __fill_f32(q, H * N * D);
+        __fill_f32(k, H * N * D);
+        __fill_f32(v, H * N * M);
+
+        for (size_t i = 0; i < N; i++){
+            __gather_tokens(qb, kb, vb, q, k, v, H, N, D, M, 0, i + 1);
+            Tensor4D_F32 Q = { .shape = {1, H, i + 1, D}, .data = qb };
+            Tensor4D_F32 K = { .shape = {1, H, i + 1, D}, .data = kb };
+            Tensor4D_F32 V = { .shape = {1, H, i + 1, M}, .data = vb };
+            Tensor4D_F32 Y = { .shape = {1, i + 1, H, M}, .data = yb };
+            MiCo_linear_attention_f32(&Y, &Q, &K, &V, eps);
+            memcpy(ref + i * H * M, yb + i * H * M, H * M * sizeof(float));
+        }
+
+        MiCo_LinearAttn_State st;
+        MiCo_linear_attention_state_init(&st, H, D, M);
+        ConformRow* r = __new_row("linattn", "step", N, D, M);
+        for (size_t i = 0; i < N; i++){
+            __gather_tokens(qb, kb, vb, q, k, v, H, N, D, M, i, 1);
+            Tensor2D_F32 Q = { .shape = {H, D}, .data = qb };
+            Tensor2D_F32 K = { .shape = {H, D}, .data = kb };
+            Tensor2D_F32 V = { .shape = {H, M}, .data = vb };
+            Tensor2D_F32 Y = { .shape = {H, M}, .data = out + i * H * M };
+            MiCo_linear_attention_step_f32(&Y, &Q, &K, &V, &st, eps);
+        }
+        r->mismatches = __count_far(out, ref, N * H * M, 1e-6f, 1e-4f, cfg->verbose);
+
+        MiCo_linear_attention_state_reset(&st);
+        r = __new_row("linattn", "chunk", N, D, M);
+        for (size_t i0 = 0; i0 < N; ){
+            size_t c = __rand_range(1, 8);
+            if (c > N - i0) c = N - i0;
+            __gather_tokens(qb, kb, vb, q, k, v, H, N, D, M, i0, c);
+            Tensor3D_F32 Q = { .shape = {H, c, D}, .data = qb };
+            Tensor3D_F32 K = { .shape = {H, c, D}, .data = kb };
+            Tensor3D_F32 V = { .shape = {H, c, M}, .data = vb };
+            Tensor3D_F32 Y = { .shape = {c, H, M}, .data = out + i0 * H * M };
+            MiCo_linear_attention_chunk_f32(&Y, &Q, &K, &V, &st, eps);
+            i0 += c;
+        }
+        r->mismatches = __count_far(out, ref, N * H * M, 1e-6f, 1e-4f, cfg->verbose);
+        MiCo_linear_attention_state_free(&st);
+        free(q);
+        free(k);
+        free(v);
+        free(qb);
+        free(kb);
+        free(vb);
+        free(yb);
+        free(out);
+        free(ref);
+    }
+}
+
+#ifndef USE_ALT_LAYOUT
+// Quantized ViT attention against MiCo_ViT_attention_f32. Q, K and V are
+// each quantized once, so the outputs agree to a few steps of V's range.
+static void __check_bitattn(const ConformConfig* cfg){
+    static const qtype bits[][3] = { {8, 8, 8}, {8, 4, 8}, {8, 8, 4} };
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t H = __rand_range(1, 2), I = __rand_range(1, 8);
+        const size_t J = __rand_range(1, 16), F = __rand_range(1, 32);
+        const float scale = sqrtf((float)F);
+        float* q = __new_f32(H * I * F);
+        float* k = __new_f32(H * J * F);
+        float* v = __new_f32(H * J * F);
+        float* y = __new_f32(I * H * F);
+        float* ref = __new_f32(I * H * F);
+        __fill_f32(q, H * I * F);
+        __fill_f32(k, H * J * F);
+        __fill_f32(v, H * J * F);
+        Tensor4D_F32 Q = { .shape = {1, H, I, F}, .data = q };
+        Tensor4D_F32 K = { .shape = {1, H, J, F}, .data = k };
+        Tensor4D_F32 V = { .shape = {1, H, J, F}, .data = v };
+        Tensor4D_F32 Y = { .shape = {1, I, H, F}, .data = y };
+        Tensor4D_F32 R = { .shape = {1, I, H, F}, .data = ref };
+        MiCo_ViT_attention_f32(&R, &Q, &K, &V, scale);
+
+        for (size_t b = 0; b < sizeof(bits) / sizeof(bits[0]); b++){
+            const qtype aq = bits[b][0], kq = bits[b][1], vq = bits[b][2];
+            char variant[16];
+            snprintf(variant, sizeof(variant), "Q%dx%dx%d", aq, kq, vq);
+            ConformRow* r = __new_row("bitattn", variant, I, F, J);
+            MiCo_bitattention_f32(&Y, &Q, &K, &V, scale, aq, kq, vq, CONFORM_ALIGN);
+            const float tol = (kq == 8 && vq == 8 ? 0.01f : 0.1f) * __absmax_f32(v, H * J * F);
+            r->mismatches = __count_far(y, ref, I * H * F, tol, 0.f, cfg->verbose);
+        }
+        free(q);
+        free(k);
+        free(v);
+        free(y);
+        free(ref);
+    }
+}
+#endif
+
+// ToMe on tokens where r of the A tokens duplicate a random B token, so
+// exactly those r merge and the result is known. Attention with size
+// propagation over the merged tokens must then equal plain size-weighted
+// attention over the original ones.
+static void __check_tome(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t B = __rand_range(1, 2), N = __rand_range(4, 16), C = __rand_range(8, 16);
+        const int protect = __rand() & 1, with_size = __rand() & 1;
+        const size_t NA = (N + 1) / 2, NB = N / 2;
+        const size_t r_merge = __rand_range(1, NA - protect);
+        const size_t M = N - r_merge, I = __rand_range(1, 4);
+        float* x = __new_f32(B * N * C);
+        float* sz = __new_f32(B * N);
+        float* y = __new_f32(B * M * C);
+        float* so = __new_f32(B * M);
+        float* ey = __new_f32(B * M * C);
+        float* es = __new_f32(B * M);
+        float* qa = __new_f32(B * I * C);
+        float* ya = __new_f32(B * I * C);
+        float* yr = __new_f32(B * I * C);
+        int* dup = malloc(NA * sizeof(int));
+        size_t* cand = malloc(NA * sizeof(size_t));
+        MiCo_assert(dup != NULL && cand != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(x, B * N * C);
+        __fill_f32(qa, B * I * C);
+        for (size_t i = 0; i < B * N; i++) sz[i] = with_size ? (float)__rand_range(1, 3) : 1.0f;
+
+        for (size_t b = 0; b < B; b++){
+            float* xb = x + b * N * C;
+            const float* sb = sz + b * N;
+            size_t n_cand = 0;
+            for (size_t a = protect; a < NA; a++) cand[n_cand++] = a;
+            for (size_t a = 0; a < NA; a++) dup[a] = -1;
+            for (size_t t = 0; t < r_merge; t++){
+                const size_t p = t + __rand() % (n_cand - t);
+                const size_t a = cand[p];
+                cand[p] = cand[t];
+                dup[a] = (int)__rand_range(0, NB - 1);
+                memcpy(xb + 2 * a * C, xb + (2 * dup[a] + 1) * C, C * sizeof(float));
+            }
+            float* eyb = ey + b * M * C;
+            float* esb = es + b * M;
+            size_t m = 0;
+            for (size_t a = 0; a < NA; a++){
+                if (dup[a] >= 0) continue;
+                memcpy(eyb + m * C, xb + 2 * a * C, C * sizeof(float));
+                esb[m++] = sb[2 * a];
+            }
+            for (size_t j = 0; j < NB; j++){
+                memcpy(eyb + (m + j) * C, xb + (2 * j + 1) * C, C * sizeof(float));
+                esb[m + j] = sb[2 * j + 1];
+            }
+            for (size_t a = 0; a < NA; a++){
+                if (dup[a] >= 0) esb[m + dup[a]] += sb[2 * a];
+            }
+        }
+
+        Tensor3D_F32 X = { .shape = {B, N, C}, .data = x };
+        Tensor3D_F32 Y = { .shape = {B, M, C}, .data = y };
+        Tensor2D_F32 S = { .shape = {B, N}, .data = sz };
+        Tensor2D_F32 SO = { .shape = {B, M}, .data = so };
+        ConformRow* r = __new_row("tome", "merge", N, C, r_merge);
+        MiCo_tome_merge_f32(&Y, &SO, &X, &X, with_size ? &S : NULL, r_merge, protect);
+        r->mismatches = __count_far(y, ey, B * M * C, 1e-6f, 1e-5f, cfg->verbose);
+        r->mismatches += __count_far(so, es, B * M, 0.f, 0.f, cfg->verbose);
+
+        Tensor4D_F32 QA = { .shape = {B, 1, I, C}, .data = qa };
+        Tensor4D_F32 KO = { .shape = {B, 1, N, C}, .data = x };
+        Tensor4D_F32 KM = { .shape = {B, 1, M, C}, .data = y };
+        Tensor4D_F32 YA = { .shape = {B, I, 1, C}, .data = ya };
+        Tensor4D_F32 YR = { .shape = {B, I, 1, C}, .data = yr };
+        r = __new_row("tome", "prop", N, C, r_merge);
+        MiCo_ViT_attention_prop_f32(&YR, &QA, &KO, &KO, &S, sqrtf((float)C));
+        MiCo_ViT_attention_prop_f32(&YA, &QA, &KM, &KM, &SO, sqrtf((float)C));
+        r->mismatches = __count_far(ya, yr, B * I * C, 1e-6f, 1e-4f, cfg->verbose);
+        free(x);
+        free(sz);
+        free(y);
+        free(so);
+        free(ey);
+        free(es);
+        free(qa);
+        free(ya);
+        free(yr);
+        free(dup);
+        free(cand);
+    }
+}
+
+// Fused QKV projection against MiCo_bitlinear_f32 on the stacked weight
+// followed by a scalar RoPE; the K/V rows must land in the cache (the INT8
+// cache within one quantization step).
+static void __check_qkv(const ConformConfig* cfg){
+    const float theta = 10000.0f;
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t b = __rand_range(1, 4), n = __rand_range(1, 96);
+        const int pos0 = (int)__rand_range(0, 8);
+        const MiCo_MHA_Config mha = __rand_mha(pos0 + (int)b, 1);
+        const size_t dim = mha.n_heads * mha.head_size, kv_dim = mha.kv_dim;
+        const size_t m = dim + 2 * kv_dim, L = mha.seq_len;
+        const size_t aligned = (n + CONFORM_ALIGN - 1) / CONFORM_ALIGN * CONFORM_ALIGN;
+        float* x = __new_f32(b * n);
+        float* yr = __new_f32(b * m);
+        float* exp_qkv = __new_f32(b * m);
+        float* got = __new_f32(b * m);
+        float* q = __new_f32(b * dim);
+        float* kc = __new_f32(L * kv_dim);
+        float* vc = __new_f32(L * kv_dim);
+        float* ks = __new_f32(L);
+        float* vs = __new_f32(L);
+        qbyte* wd = malloc(m * aligned);
+        int8_t* k8 = malloc(L * kv_dim);
+        int8_t* v8 = malloc(L * kv_dim);
+        MiCo_assert(wd != NULL && k8 != NULL && v8 != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(x, b * n);
+        __fill_bytes(wd, m * aligned);
+        Tensor2D_F32 X = { .shape = {b, n}, .data = x };
+        Tensor2D_F32 YR = { .shape = {b, m}, .data = yr };
+        Tensor2D_F32 Q = { .shape = {b, dim}, .data = q };
+        Tensor1D_F32 no_bias = { .shape = {0}, .data = NULL };
+
+        for (int wb = MAX_QTYPE_LOG2; wb >= 0; wb--){
+            const qtype wq = 1 << wb;
+            #ifdef USE_ALT_LAYOUT
+            if (wb != 3) continue;
+            Tensor2D_Q8 W = { .shape = {aligned, m}, .data = wd, .scale = 0.01f, .wq = wq };
+            #else
+            Tensor2D_Q8 W = { .shape = {m, aligned}, .data = wd, .scale = 0.01f, .wq = wq };
+            #endif
+            MiCo_bitlinear_f32(&YR, &X, &W, &no_bias, wq, 8, CONFORM_ALIGN);
+            memcpy(exp_qkv, yr, b * m * sizeof(float));
+            for (size_t t = 0; t < b; t++){
+                float* row = exp_qkv + t * m;
+                for (size_t j = 0; j < dim + kv_dim; j += 2){
+                    const size_t i = (j % mha.head_size) / 2;
+                    const float freq = 1.0f / powf(theta, (float)(2 * i) / (float)mha.head_size);
+                    const float a = (pos0 + (int)t) * freq;
+                    const float x0 = row[j], x1 = row[j + 1];
+                    row[j] = x0 * cosf(a) - x1 * sinf(a);
+                    row[j + 1] = x0 * sinf(a) + x1 * cosf(a);
+                }
+            }
+            const float amax = __absmax_f32(exp_qkv, b * m);
+
+            for (int kv_bits = 32; kv_bits >= 8; kv_bits -= 24){
+                char variant[16], pair[8];
+                __pair_name(pair, sizeof(pair), 8, wq);
+                snprintf(variant, sizeof(variant), "%s%s", pair, kv_bits == 8 ? "_kv8" : "");
+                ConformRow* r = __new_row("qkv", variant, b, n, m);
+                MiCo_bitlinear_qkv_f32(&Q, &X, &W, NULL,
+                    kv_bits == 8 ? (void*)k8 : (void*)kc, kv_bits == 8 ? (void*)v8 : (void*)vc,
+                    ks, vs, (uint8_t)kv_bits, pos0, theta, &mha, wq, 8, CONFORM_ALIGN);
+                float step = 0.f;
+                for (size_t t = 0; t < b; t++){
+                    const size_t p = pos0 + t;
+                    float* g = got + t * m;
+                    memcpy(g, q + t * dim, dim * sizeof(float));
+                    for (size_t j = 0; j < kv_dim; j++){
+                        g[dim + j] = kv_bits == 8 ? k8[p * kv_dim + j] * ks[p] : kc[p * kv_dim + j];
+                        g[dim + kv_dim + j] = kv_bits == 8 ? v8[p * kv_dim + j] * vs[p] : vc[p * kv_dim + j];
+                    }
+                    if (kv_bits == 8){
+                        step = ks[p] > step ? ks[p] : step;
+                        step = vs[p] > step ? vs[p] : step;
+                    }
+                }
+                r->mismatches = __count_far(got, exp_qkv, b * m, 1e-5f * amax + 0.6f * step,
+                    1e-5f, cfg->verbose);
+            }
+        }
+        free(x);
+        free(yr);
+        free(exp_qkv);
+        free(got);
+        free(q);
+        free(kc);
+        free(vc);
+        free(ks);
+        free(vs);
+        free(wd);
+        free(k8);
+        free(v8);
+    }
+}
+
+#ifndef USE_ALT_LAYOUT
+// Fused top-k head against the full MiCo_bitlinear_f32 logits: the winners
+// must be the k largest logits with their values, and lse their
+// log-sum-exp. Ties within rounding may swap, so values are compared.
+static void __check_topk(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t b = __rand_range(1, 4), n = __rand_range(1, 128), m = __rand_range(1, 600);
+        const size_t k = __rand_range(1, m < 8 ? m : 8);
+        const size_t aligned = (n + CONFORM_ALIGN - 1) / CONFORM_ALIGN * CONFORM_ALIGN;
+        const int with_bias = __rand() & 1;
+        const float temp = 0.5f + (float)__rand_range(0, 3) * 0.5f;
+        float* x = __new_f32(b * n);
+        float* bf = __new_f32(m);
+        float* logits = __new_f32(b * m);
+        float* sorted = __new_f32(m);
+        float* val = __new_f32(b * k);
+        float* lse = __new_f32(b);
+        float* got = __new_f32(b * k);
+        float* ref = __new_f32(b * k);
+        size_t* idx = malloc(b * k * sizeof(size_t));
+        qbyte* wd = malloc(m * aligned);
+        qbyte* qd = malloc(MiCo_qact_size(b, n, 8, CONFORM_ALIGN));
+        MiCo_assert(idx != NULL && wd != NULL && qd != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(x, b * n);
+        __fill_f32(bf, m);
+        __fill_bytes(wd, m * aligned);
+        Tensor2D_F32 X = { .shape = {b, n}, .data = x };
+        Tensor2D_F32 Y = { .shape = {b, m}, .data = logits };
+        Tensor1D_F32 bias = { .shape = {with_bias ? m : 0}, .data = with_bias ? bf : NULL };
+        Tensor2D_Q8 qx = { .data = qd };
+        MiCo_2D_quant_act(&qx, &X, 8, CONFORM_ALIGN);
+
+        for (int wb = MAX_QTYPE_LOG2; wb >= 0; wb--){
+            const qtype wq = 1 << wb;
+            Tensor2D_Q8 W = { .shape = {m, aligned}, .data = wd, .scale = 0.01f, .wq = wq };
+            char variant[16];
+            __pair_name(variant, sizeof(variant), 8, wq);
+            ConformRow* r = __new_row("topk", variant, b, n, m);
+            MiCo_bitlinear_f32(&Y, &X, &W, &bias, wq, 8, CONFORM_ALIGN);
+            MiCo_bitlinear_topk_f32(idx, val, lse, &qx, &W, &bias, wq, k, temp);
+            const float amax = __absmax_f32(logits, b * m);
+            for (size_t i = 0; i < b; i++){
+                const float* li = logits + i * m;
+                // k largest by selection; the exact ordering of ties does not matter
+                memcpy(sorted, li, m * sizeof(float));
+                double mx = -INFINITY, sum = 0.0;
+                for (size_t j = 0; j < m; j++) mx = li[j] / temp > mx ? li[j] / temp : mx;
+                for (size_t j = 0; j < m; j++) sum += exp(li[j] / temp - mx);
+                for (size_t t = 0; t < k; t++){
+                    size_t best = t;
+                    for (size_t j = t + 1; j < m; j++) best = sorted[j] > sorted[best] ? j : best;
+                    const float s = sorted[t];
+                    sorted[t] = sorted[best];
+                    sorted[best] = s;
+                    ref[i * k + t] = sorted[t];
+                    // the winner's own logit, so a wrong index shows up too
+                    got[i * k + t] = idx[i * k + t] < m ? li[idx[i * k + t]] : NAN;
+                }
+                r->mismatches += __count_far(val + i * k, ref + i * k, k, 1e-5f * amax, 1e-5f, cfg->verbose);
+                r->mismatches += fabsf(lse[i] - (float)(mx + log(sum))) > 1e-3f * (1.0f + fabsf(lse[i]));
+            }
+            r->mismatches += __count_far(got, val, b * k, 1e-5f * amax, 1e-5f, cfg->verbose);
+        }
+        free(x);
+        free(bf);
+        free(logits);
+        free(sorted);
+        free(val);
+        free(lse);
+        free(got);
+        free(ref);
+        free(idx);
+        free(wd);
+        free(qd);
+    }
+}
+
+// One activation block against several weights, vs MiCo_bitlinear_q_f32
+// per weight; more than MICO_MULTI_ROWS rows so the row blocking is hit.
+static void __check_multi(const ConformConfig* cfg){
+    for (int cs = 0; cs < cfg->cases; cs++){
+        const size_t b = __rand_range(1, 20), n = __rand_range(1, 128);
+        const size_t n_w = __rand_range(1, 3);
+        const size_t aligned = (n + CONFORM_ALIGN - 1) / CONFORM_ALIGN * CONFORM_ALIGN;
+        float* x = __new_f32(b * n);
+        qbyte* qd = malloc(MiCo_qact_size(b, n, 8, CONFORM_ALIGN));
+        MiCo_assert(qd != NULL, "[Conform] failed to allocate buffers");
+        __fill_f32(x, b * n);
+        Tensor2D_F32 X = { .shape = {b, n}, .data = x };
+
+        for (int a = MAX_QTYPE_LOG2; a >= 0; a--){
+            const qtype aq = 1 << a;
+            Tensor2D_Q8 qx = { .data = qd };
+            MiCo_2D_quant_act(&qx, &X, aq, CONFORM_ALIGN);
+            Tensor2D_Q8 w[3];
+            Tensor1D_F32 bias[3];
+            Tensor2D_F32 y[3], yr[3];
+            const Tensor2D_Q8* wp[3];
+            const Tensor1D_F32* bp[3];
+            Tensor2D_F32* yp[3];
+            size_t total = 0;
+            for (size_t i = 0; i < n_w; i++){
+                const size_t m = __rand_range(1, 48);
+                w[i] = (Tensor2D_Q8){ .shape = {m, aligned}, .data = malloc(m * aligned),
+                    .scale = 0.01f, .wq = 1 << __rand_range(0, MAX_QTYPE_LOG2) };
+                bias[i] = (Tensor1D_F32){ .shape = {m}, .data = __new_f32(m) };
+                y[i] = (Tensor2D_F32){ .shape = {b, m}, .data = __new_f32(b * m) };
+                yr[i] = (Tensor2D_F32){ .shape = {b, m}, .data = __new_f32(b * m) };
+                MiCo_assert(w[i].data != NULL, "[Conform] failed to allocate buffers");
+                __fill_bytes(w[i].data, m * aligned);
+                __fill_f32(bias[i].data, m);
+                wp[i] = &w[i];
+                bp[i] = &bias[i];
+                yp[i] = &y[i];
+                total += m;
+            }
+            char variant[16];
+            snprintf(variant, sizeof(variant), "A%d", aq);
+            ConformRow* r = __new_row("multi", variant, b, n, total);
+            MiCo_bitlinear_multi_f32(yp, &qx, wp, bp, n_w);
+            for (size_t i = 0; i < n_w; i++){
+                MiCo_bitlinear_q_f32(&yr[i], &qx, &w[i], &bias[i], w[i].wq);
+                r->mismatches += __count_far(y[i].data, yr[i].data, b * w[i].shape[0],
+                    1e-6f, 1e-5f, cfg->verbose);
+                free(w[i].data);
+                free(bias[i].data);
+                free(y[i].data);
+                free(yr[i].data);
+            }
+        }
+        free(x);
+        free(qd);
+    }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Report
+
+static void __write_results(FILE* f){
+    fprintf(f, "backend,layout,check,variant,M,K,N,mismatches,median_us,ref_us\n");
+    for (int i = 0; i < n_rows; i++){
+        const ConformRow* r = &rows[i];
+        fprintf(f, "%s,%s,%s,%s,%zu,%zu,%zu,%zu,%.3f,%.3f\n",
+            MICO_BENCH_BACKEND, CONFORM_LAYOUT, r->check, r->variant,
+            r->m, r->k, r->n, r->mismatches, r->median_us, r->ref_us);
+    }
+}
+
+// MatMul and conv speed is judged against the oracle timed in the same run,
+// every case against a saved run when --baseline is given. Cases below --min-us are too short to
+// time reliably and only take part in the bit-exact check.
+static int __report(const ConformConfig* cfg){
+    int mismatched = 0, slow = 0;
+    for (int i = 0; i < n_rows; i++){
+        const ConformRow* r = &rows[i];
+        if (r->mismatches){
+            mismatched++;
+            fprintf(stderr, "MISMATCH   %-6s %-6s M=%-5zu K=%-5zu N=%-5zu: %zu values differ\n",
+                r->check, r->variant, r->m, r->k, r->n, r->mismatches);
+        }
+        if (r->judged && r->ref_us >= cfg->min_us && r->median_us > r->ref_us * (1.0 + cfg->threshold)){
+            slow++;
+            fprintf(stderr, "SLOWDOWN   %-6s %-6s M=%-5zu K=%-5zu N=%-5zu: %.2f us vs reference %.2f us\n",
+                r->check, r->variant, r->m, r->k, r->n, r->median_us, r->ref_us);
+        } else if (cfg->verbose){
+            fprintf(stderr, "  %-6s %-6s M=%-5zu K=%-5zu N=%-5zu  %10.2f us  ref %10.2f us  x%.2f\n",
+                r->check, r->variant, r->m, r->k, r->n, r->median_us, r->ref_us,
+                r->median_us > 0 ? r->ref_us / r->median_us : 0.0);
+        }
+    }
+    fprintf(stderr, "[Conform] backend %s, layout %s, seed %u: %d cases, %d mismatched, %d slower than reference (threshold %.0f%%)\n",
+        MICO_BENCH_BACKEND, CONFORM_LAYOUT, (unsigned)cfg->seed, n_rows, mismatched, slow,
+        cfg->threshold * 100.0);
+    return mismatched + slow;
+}
+
+// Cases match on (backend, layout, check, variant, M, K, N), which a fixed
+// seed reproduces; returns the number of cases slower than the baseline.
+static int __compare_baseline(const ConformConfig* cfg){
+    FILE* f = fopen(cfg->baseline, "r");
+    if (f == NULL){
+        fprintf(stderr, "[Conform] cannot open baseline %s\n", cfg->baseline);
+        return -1;
+    }
+    char line[256];
+    int matched = 0, regressions = 0;
+    while (fgets(line, sizeof(line), f)){
+        char backend[32], layout[16];
+        ConformRow b;
+        if (sscanf(line, "%31[^,],%15[^,],%15[^,],%15[^,],%zu,%zu,%zu,%zu,%lf,%lf",
+            backend, layout, b.check, b.variant, &b.m, &b.k, &b.n, &b.mismatches,
+            &b.median_us, &b.ref_us) != 10) continue;
+        if (strcmp(backend, MICO_BENCH_BACKEND) || strcmp(layout, CONFORM_LAYOUT)) continue;
+        for (int i = 0; i < n_rows; i++){
+            const ConformRow* r = &rows[i];
+            if (strcmp(r->check, b.check) || strcmp(r->variant, b.variant) ||
+                r->m != b.m || r->k != b.k || r->n != b.n) continue;
+            matched++;
+            if (b.median_us >= cfg->min_us && r->median_us > b.median_us * (1.0 + cfg->threshold)){
+                regressions++;
+                fprintf(stderr, "REGRESSION %-6s %-6s M=%-5zu K=%-5zu N=%-5zu: %.2f us -> %.2f us\n",
+                    r->check, r->variant, r->m, r->k, r->n, b.median_us, r->median_us);
+            }
+            break;
+        }
+    }
+    fclose(f);
+    fprintf(stderr, "[Conform] %d cases compared to baseline, %d regressions\n", matched, regressions);
+    return regressions;
+}
+
+static unsigned __parse_checks(const char* s){
+    unsigned mask = 0;
+    if (strstr(s, "all")) return ~0u;
+    if (strstr(s, "matmul")) mask |= CONFORM_MATMUL;
+    if (strstr(s, "quant")) mask |= CONFORM_QUANT;
+    if (strstr(s, "conv")) mask |= CONFORM_CONV;
+    if (strstr(s, "kv")) mask |= CONFORM_KV;
+    if (strstr(s, "attn")) mask |= CONFORM_ATTN;
+    if (strstr(s, "linear")) mask |= CONFORM_LINEAR;
+    return mask;
+}
+
+static void __usage(const char* prog){
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --seed N          random seed, default 1\n"
+        "  --cases N         random shapes per check, default 8\n"
+        "  --reps N          timed iterations per case, default 3\n"
+        "  --max M,K,N       largest MatMul shape, default 33,512,129\n"
+        "  --k-align N       K is a multiple of N, default 32\n"
+        "  --checks LIST     matmul,quant,conv,kv,attn,linear or all (default)\n"
+        "  --threshold F     allowed slowdown vs reference / baseline, default 0.25\n"
+        "  --min-us F        shortest reference time that is judged, default 20\n"
+        "  -o FILE           write per-case CSV to FILE\n"
+        "  --baseline FILE   also compare medians against a CSV of the same seed\n"
+        "  -v                print every case\n", prog);
+}
+
+int main(int argc, char** argv){
+    ConformConfig cfg = {
+        .seed = 1, .cases = 8, .reps = 3,
+        .max_m = 33, .max_k = 512, .max_n = 129, .k_align = CONFORM_ALIGN,
+        .checks = ~0u, .threshold = 0.25, .min_us = 20.0,
+        .out = NULL, .baseline = NULL, .verbose = 0
+    };
+
+    for (int i = 1; i < argc; i++){
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")){
+            __usage(argv[0]);
+            return 0;
+        } else if (!strcmp(a, "-v")){
+            cfg.verbose = 1;
+            continue;
+        }
+        if (v == NULL){
+            __usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (!strcmp(a, "--seed")) cfg.seed = (uint32_t)strtoul(v, NULL, 0);
+        else if (!strcmp(a, "--cases")) cfg.cases = atoi(v);
+        else if (!strcmp(a, "--reps")) cfg.reps = atoi(v);
+        else if (!strcmp(a, "--max")){
+            MiCo_assert(sscanf(v, "%zu,%zu,%zu", &cfg.max_m, &cfg.max_k, &cfg.max_n) == 3,
+                "[Conform] --max expects M,K,N");
+        }
+        else if (!strcmp(a, "--k-align")) cfg.k_align = (size_t)atoi(v);
+        else if (!strcmp(a, "--checks")) cfg.checks = __parse_checks(v);
+        else if (!strcmp(a, "--threshold")) cfg.threshold = atof(v);
+        else if (!strcmp(a, "--min-us")) cfg.min_us = atof(v);
+        else if (!strcmp(a, "-o")) cfg.out = v;
+        else if (!strcmp(a, "--baseline")) cfg.baseline = v;
+        else {
+            __usage(argv[0]);
+            return 2;
+        }
+    }
+    MiCo_assert(cfg.cases > 0 && cfg.reps > 0, "[Conform] invalid case or repetition count");
+    // 1-bit packing needs whole bytes per row
+    MiCo_assert(cfg.k_align > 0 && cfg.k_align % 8 == 0, "[Conform] --k-align must be a multiple of 8");
+    MiCo_assert(cfg.max_m > 0 && cfg.max_n > 0 && cfg.max_k >= cfg.k_align && cfg.max_k >= 8,
+        "[Conform] invalid --max shape");
+    rng_state = cfg.seed ? cfg.seed : 1;
+
+    double* t = malloc(cfg.reps * sizeof(double));
+    MiCo_assert(t != NULL, "[Conform] failed to allocate buffers");
+
+    fprintf(stderr, "[Conform] backend: %s, layout: %s, seed %u, %d cases, reps %d\n",
+        MICO_BENCH_BACKEND, CONFORM_LAYOUT, (unsigned)cfg.seed, cfg.cases, cfg.reps);
+    if (cfg.checks & CONFORM_MATMUL) __check_matmul(&cfg, t);
+    if (cfg.checks & CONFORM_QUANT) __check_quant(&cfg, t);
+    if (cfg.checks & CONFORM_CONV){
+        __check_conv(&cfg, t);
+        #ifndef USE_ALT_LAYOUT
+        __check_conv_stream(&cfg);
+        #endif
+    }
+    if (cfg.checks & CONFORM_KV){
+        __check_prefix(&cfg);
+        __check_paged(&cfg);
+    }
+    if (cfg.checks & CONFORM_ATTN){
+        __check_kvq(&cfg);
+        __check_batched(&cfg);
+        __check_window(&cfg);
+        __check_prefill(&cfg);
+        __check_linattn(&cfg);
+        #ifndef USE_ALT_LAYOUT
+        __check_bitattn(&cfg);
+        #endif
+        __check_tome(&cfg);
+    }
+    if (cfg.checks & CONFORM_LINEAR){
+        __check_qkv(&cfg);
+        #ifndef USE_ALT_LAYOUT
+        __check_topk(&cfg);
+        __check_multi(&cfg);
+        #endif
+    }
+    free(t);
+
+    if (cfg.out){
+        FILE* f = fopen(cfg.out, "w");
+        MiCo_assert(f != NULL, "[Conform] cannot open output file");
+        __write_results(f);
+        fclose(f);
+    }
+
+    int failures = __report(&cfg);
+    if (cfg.baseline){
+        const int regressions = __compare_baseline(&cfg);
+        failures += regressions != 0;
+    }
+    return failures != 0;
+}
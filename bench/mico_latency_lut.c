@@ -0,0 +1,320 @@
+// Latency lookup table generator for the mixed-precision search
+// Measures every (aq, wq) pair of the linked backend on a list of layer
+// shapes (linear, and conv with stride / padding / groups) and prints one
+// CSV row per shape and pair between MICO_LUT_BEGIN / MICO_LUT_END lines,
+// so the Python side can pick the table out of a host run or a SoC UART log.
+//
+// Latencies are in ticks of MiCo_trace_clock() (ns on host, cycles on the
+// SoC); the header line carries ticks_per_us. The shapes come from
+//   * a file given with --shapes (host only), one layer per line:
+//       linear <batch> <in_features> <out_features>
+//       conv   <in_c> <in_h> <in_w> <out_c> <kernel> <stride> <padding> <groups>
+//   * or a compiled-in table, -DMICO_LUT_SHAPES_HEADER="shapes.h" defining
+//       static const MiCo_LUT_Shape mico_lut_shapes[] = { ... };
+//   * or the small default table below.
+
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include "mico_runtime.h"
+
+#ifndef MICO_BENCH_BACKEND
+#define MICO_BENCH_BACKEND "default"
+#endif
+
+#ifdef USE_ALT_LAYOUT
+#define LUT_LAYOUT "alt"
+#else
+#define LUT_LAYOUT "default"
+#endif
+
+#ifndef MICO_IM2COL_BLOCK_ROWS
+#define MICO_IM2COL_BLOCK_ROWS 2
+#endif
+
+#ifndef MICO_LUT_ALIGN
+#define MICO_LUT_ALIGN 32
+#endif
+
+#ifndef MICO_LUT_MAX_SHAPES
+#define MICO_LUT_MAX_SHAPES 256
+#endif
+
+#ifndef MICO_LUT_MAX_REPS
+#define MICO_LUT_MAX_REPS 64
+#endif
+
+#define MICO_LUT_LINEAR 0
+#define MICO_LUT_CONV   1
+
+typedef struct {
+    int op;
+    // linear: batch, in_c = in_features, out_c = out_features
+    size_t batch, in_c, in_h, in_w, out_c;
+    size_t kernel, stride, padding, groups;
+} MiCo_LUT_Shape;
+
+#define LUT_LINEAR(b, k, n) { MICO_LUT_LINEAR, b, k, 1, 1, n, 1, 1, 0, 1 }
+#define LUT_CONV(c, h, w, oc, ks, s, p, g) { MICO_LUT_CONV, 1, c, h, w, oc, ks, s, p, g }
+
+#ifdef MICO_LUT_SHAPES_HEADER
+#include MICO_LUT_SHAPES_HEADER
+#else
+// LeNet / small CNN / MLP layers
+static const MiCo_LUT_Shape mico_lut_shapes[] = {
+    LUT_CONV(1, 28, 28, 6, 5, 1, 0, 1),
+    LUT_CONV(6, 12, 12, 16, 5, 1, 0, 1),
+    LUT_CONV(3, 32, 32, 32, 3, 1, 1, 1),
+    LUT_CONV(32, 16, 16, 32, 3, 1, 1, 32),
+    LUT_CONV(32, 16, 16, 64, 1, 1, 0, 1),
+    LUT_CONV(64, 16, 16, 64, 3, 2, 1, 1),
+    LUT_LINEAR(1, 256, 120),
+    LUT_LINEAR(1, 120, 84),
+    LUT_LINEAR(1, 84, 10),
+    LUT_LINEAR(16, 512, 512),
+};
+#endif
+
+#define MICO_LUT_DEFAULT_SHAPES (sizeof(mico_lut_shapes) / sizeof(mico_lut_shapes[0]))
+
+static MiCo_LUT_Shape lut_shapes[MICO_LUT_MAX_SHAPES];
+static size_t lut_n_shapes = 0;
+static uint32_t lut_seed = 0x1234567u;
+
+static void __fill_bytes(qbyte* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        lut_seed = lut_seed * 1664525u + 1013904223u;
+        p[i] = (qbyte)(lut_seed >> 24);
+    }
+}
+
+static void __fill_f32(float* p, const size_t n){
+    for (size_t i = 0; i < n; i++){
+        lut_seed = lut_seed * 1664525u + 1013904223u;
+        p[i] = (float)(lut_seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+    }
+}
+
+static size_t __align(const size_t n){
+    return (n + MICO_LUT_ALIGN - 1) / MICO_LUT_ALIGN * MICO_LUT_ALIGN;
+}
+
+// Insertion sort, no qsort on the SoC
+static void __sort(uint64_t* t, const int n){
+    for (int i = 1; i < n; i++){
+        const uint64_t v = t[i];
+        int j = i - 1;
+        while (j >= 0 && t[j] > v){
+            t[j + 1] = t[j];
+            j--;
+        }
+        t[j + 1] = v;
+    }
+}
+
+static size_t __out_h(const MiCo_LUT_Shape* s){
+    return (s->in_h + 2 * s->padding - s->kernel) / s->stride + 1;
+}
+
+static size_t __out_w(const MiCo_LUT_Shape* s){
+    return (s->in_w + 2 * s->padding - s->kernel) / s->stride + 1;
+}
+
+// Reduction size of one output, aligned as the weights are exported
+static size_t __k(const MiCo_LUT_Shape* s){
+    if (s->op == MICO_LUT_LINEAR) return __align(s->in_c);
+    return __align(s->in_c / s->groups * s->kernel * s->kernel);
+}
+
+static uint64_t __macs(const MiCo_LUT_Shape* s){
+    if (s->op == MICO_LUT_LINEAR) return (uint64_t)s->batch * __k(s) * s->out_c;
+    return (uint64_t)__out_h(s) * __out_w(s) * __k(s) * s->out_c;
+}
+
+// QBuffer bytes the layer quantizes into at aq (conv quantizes
+// MICO_IM2COL_BLOCK_ROWS output rows of im2col at a time)
+static size_t __qbuffer(const MiCo_LUT_Shape* s, const qtype aq){
+    const size_t rows = s->op == MICO_LUT_LINEAR ? s->batch : MICO_IM2COL_BLOCK_ROWS * __out_w(s);
+    return rows * __k(s) / (8 / aq);
+}
+
+static const char* __check(const MiCo_LUT_Shape* s){
+    if (s->op == MICO_LUT_CONV){
+        if (s->kernel == 0 || s->stride == 0 || s->groups == 0) return "invalid conv";
+        if (s->in_c % s->groups || s->out_c % s->groups) return "channels not divisible by groups";
+        if (s->in_h + 2 * s->padding < s->kernel || s->in_w + 2 * s->padding < s->kernel)
+            return "kernel larger than input";
+    }
+    if (s->batch == 0 || s->in_c == 0 || s->out_c == 0) return "empty shape";
+    if (__qbuffer(s, 8) >= QUANTIZE_BUFFER_SIZE) return "exceeds QUANTIZE_BUFFER_SIZE";
+    return NULL;
+}
+
+// Median and minimum ticks of one layer at (aq, wq)
+static void __measure(const MiCo_LUT_Shape* s, const qtype aq, const qtype wq,
+    const int warmup, const int reps, uint64_t* median, uint64_t* best){
+    const size_t K = __k(s);
+    const size_t wbytes = s->out_c * K * wq / 8;
+    qbyte* wd = MiCo_malloc(wbytes);
+    float* bias = MiCo_malloc(s->out_c * sizeof(float));
+    MiCo_assert(wd != NULL && bias != NULL, "[LUT] failed to allocate weights");
+    __fill_bytes(wd, wbytes);
+    __fill_f32(bias, s->out_c);
+    Tensor1D_F32 b = { .shape = {s->out_c}, .data = bias };
+
+    float *x, *y;
+    size_t x_size, y_size;
+    if (s->op == MICO_LUT_LINEAR){
+        x_size = s->batch * s->in_c;
+        y_size = s->batch * s->out_c;
+    } else {
+        x_size = s->in_c * s->in_h * s->in_w;
+        y_size = s->out_c * __out_h(s) * __out_w(s);
+    }
+    x = MiCo_malloc(x_size * sizeof(float));
+    y = MiCo_malloc(y_size * sizeof(float));
+    MiCo_assert(x != NULL && y != NULL, "[LUT] failed to allocate activations");
+    __fill_f32(x, x_size);
+
+    uint64_t t[MICO_LUT_MAX_REPS];
+    for (int r = 0; r < warmup + reps; r++){
+        // A reused quantization would hide the activation quant cost
+        MiCo_QX_Buffer_Global.src = NULL;
+        uint64_t t0;
+        if (s->op == MICO_LUT_LINEAR){
+            Tensor2D_F32 xt = { .shape = {s->batch, s->in_c}, .data = x };
+            Tensor2D_F32 yt = { .shape = {s->batch, s->out_c}, .data = y };
+            #ifdef USE_ALT_LAYOUT
+            Tensor2D_Q8 w = { .shape = {K, s->out_c}, .data = wd, .scale = 0.01f, .wq = wq };
+            #else
+            Tensor2D_Q8 w = { .shape = {s->out_c, K}, .data = wd, .scale = 0.01f, .wq = wq };
+            #endif
+            t0 = MiCo_trace_clock();
+            MiCo_bitlinear_f32(&yt, &xt, &w, &b, wq, aq, MICO_LUT_ALIGN);
+        } else {
+            #ifdef USE_ALT_LAYOUT
+            Tensor4D_F32 xt = { .shape = {1, s->in_h, s->in_w, s->in_c}, .data = x };
+            Tensor4D_F32 yt = { .shape = {1, __out_h(s), __out_w(s), s->out_c}, .data = y };
+            Tensor4D_Q8 w = { .shape = {s->kernel, s->kernel, s->in_c / s->groups, s->out_c},
+                .data = wd, .scale = 0.01f, .wq = wq };
+            #else
+            Tensor4D_F32 xt = { .shape = {1, s->in_c, s->in_h, s->in_w}, .data = x };
+            Tensor4D_F32 yt = { .shape = {1, s->out_c, __out_h(s), __out_w(s)}, .data = y };
+            Tensor4D_Q8 w = { .shape = {s->out_c, s->in_c / s->groups, s->kernel, s->kernel},
+                .data = wd, .scale = 0.01f, .wq = wq };
+            #endif
+            t0 = MiCo_trace_clock();
+            MiCo_bitconv2d_f32(&yt, &xt, &w, &b, wq, aq, s->stride, s->padding, 1,
+                s->groups, MICO_LUT_ALIGN);
+        }
+        const uint64_t dt = MiCo_trace_clock() - t0;
+        if (r >= warmup) t[r - warmup] = dt;
+    }
+    __sort(t, reps);
+    *median = t[reps / 2];
+    *best = t[0];
+
+    MiCo_free(wd);
+    MiCo_free(bias);
+    MiCo_free(x);
+    MiCo_free(y);
+}
+
+#ifdef USE_HOST
+// One layer per line, '#' starts a comment
+static size_t __read_shapes(const char* path){
+    FILE* f = fopen(path, "r");
+    MiCo_assert(f != NULL, "[LUT] cannot open shape file");
+    char line[256];
+    size_t n = 0;
+    while (fgets(line, sizeof(line), f)){
+        char op[16];
+        MiCo_LUT_Shape* s = &lut_shapes[n];
+        if (line[0] == '#' || sscanf(line, "%15s", op) != 1) continue;
+        MiCo_assert(n < MICO_LUT_MAX_SHAPES, "[LUT] too many shapes (MICO_LUT_MAX_SHAPES)");
+        if (!strcmp(op, "linear")){
+            const MiCo_LUT_Shape d = LUT_LINEAR(0, 0, 0);
+            *s = d;
+            MiCo_assert(sscanf(line, "%*s %zu %zu %zu", &s->batch, &s->in_c, &s->out_c) == 3,
+                "[LUT] expected: linear <batch> <in_features> <out_features>");
+        } else if (!strcmp(op, "conv")){
+            const MiCo_LUT_Shape d = LUT_CONV(0, 0, 0, 0, 0, 0, 0, 0);
+            *s = d;
+            MiCo_assert(sscanf(line, "%*s %zu %zu %zu %zu %zu %zu %zu %zu", &s->in_c, &s->in_h,
+                &s->in_w, &s->out_c, &s->kernel, &s->stride, &s->padding, &s->groups) == 8,
+                "[LUT] expected: conv <in_c> <in_h> <in_w> <out_c> <kernel> <stride> <padding> <groups>");
+        } else {
+            MiCo_assert(0, "[LUT] unknown layer type, expected linear or conv");
+        }
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+#endif
+
+int main(int argc, char** argv){
+    int warmup = 2, reps = 7;
+    const char* shapes = NULL;
+
+    #ifdef USE_HOST
+    for (int i = 1; i < argc; i++){
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (v != NULL && !strcmp(a, "--shapes")) shapes = v;
+        else if (v != NULL && !strcmp(a, "--warmup")) warmup = atoi(v);
+        else if (v != NULL && !strcmp(a, "--reps")) reps = atoi(v);
+        else {
+            fprintf(stderr, "Usage: %s [--shapes FILE] [--warmup N] [--reps N]\n", argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    #else
+    (void)argc;
+    (void)argv;
+    #endif
+    MiCo_assert(reps > 0 && reps <= MICO_LUT_MAX_REPS && warmup >= 0, "[LUT] invalid repetition count");
+
+    if (shapes != NULL){
+        #ifdef USE_HOST
+        lut_n_shapes = __read_shapes(shapes);
+        #endif
+    } else {
+        for (size_t i = 0; i < MICO_LUT_DEFAULT_SHAPES && i < MICO_LUT_MAX_SHAPES; i++){
+            lut_shapes[i] = mico_lut_shapes[i];
+        }
+        lut_n_shapes = MICO_LUT_DEFAULT_SHAPES;
+    }
+
+    printf("# MiCo latency LUT backend=%s layout=%s ticks_per_us=%ld warmup=%d reps=%d align=%d\n",
+        MICO_BENCH_BACKEND, LUT_LAYOUT, (long)MiCo_trace_ticks_per_us(), warmup, reps, MICO_LUT_ALIGN);
+    printf("MICO_LUT_BEGIN\n");
+    printf("layer,op,batch,in_c,in_h,in_w,out_c,kernel,stride,padding,groups,aq,wq,macs,median_ticks,min_ticks\n");
+    for (size_t l = 0; l < lut_n_shapes; l++){
+        const MiCo_LUT_Shape* s = &lut_shapes[l];
+        const char* skip = __check(s);
+        if (skip != NULL){
+            printf("# layer %ld skipped: %s\n", (long)l, skip);
+            continue;
+        }
+        for (int a = MAX_QTYPE_LOG2; a >= 0; a--)
+        for (int w = MAX_QTYPE_LOG2; w >= 0; w--){
+            const qtype aq = 1 << a, wq = 1 << w;
+            #ifdef USE_ALT_LAYOUT
+            // [K, N] weights are INT8 only
+            if (aq != 8 || wq != 8) continue;
+            #endif
+            uint64_t median, best;
+            __measure(s, aq, wq, warmup, reps, &median, &best);
+            printf("%ld,%s,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%d,%d,%ld,%ld,%ld\n", (long)l,
+                s->op == MICO_LUT_LINEAR ? "linear" : "conv",
+                (long)s->batch, (long)s->in_c, (long)s->in_h, (long)s->in_w, (long)s->out_c,
+                (long)s->kernel, (long)s->stride, (long)s->padding, (long)s->groups,
+                (int)aq, (int)wq, (long)__macs(s), (long)median, (long)best);
+        }
+    }
+    printf("MICO_LUT_END\n");
+    return 0;
+}
@@ -0,0 +1,341 @@
+// End-to-end model benchmark for MiCo-Lib
+// Runs a generated network (model.h from the MiCo-python codegen) over the
+// embedded samples of a test header (lenet_test_mnist.h, test_cifar10.h, ...)
+// and reports per-inference latency (p50 / p99), throughput, accuracy, peak
+// memory per kind and a per-region breakdown from the level-1 trace regions.
+// The backend and OPT set are chosen at build time (see bench/Makefile).
+//
+// The model is reached through the macros below, which match the codegen
+// output; override them with -D for a model with other names.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+
+#ifdef USE_HOST
+#include <time.h>
+#endif
+
+#ifndef MICO_MODEL_HEADER
+#define MICO_MODEL_HEADER "model.h"
+#endif
+#ifndef MICO_TEST_HEADER
+#define MICO_TEST_HEADER "lenet_test_mnist.h"
+#endif
+
+#include MICO_MODEL_HEADER
+#include MICO_TEST_HEADER
+
+#ifndef MICO_MODEL_T
+#define MICO_MODEL_T Model
+#endif
+#ifndef MICO_MODEL_INIT
+#define MICO_MODEL_INIT(m) model_init(m)
+#endif
+#ifndef MICO_MODEL_FORWARD
+#define MICO_MODEL_FORWARD(m) model_forward(m)
+#endif
+// float* input buffer and Tensor2D_F32* logits of the model
+#ifndef MICO_MODEL_INPUT
+#define MICO_MODEL_INPUT(m) ((m)->x.data)
+#endif
+#ifndef MICO_MODEL_OUTPUT
+#define MICO_MODEL_OUTPUT(m) (&(m)->output)
+#endif
+
+#ifndef MICO_MODEL_NAME
+#define MICO_MODEL_NAME "model"
+#endif
+#ifndef MICO_BENCH_BACKEND
+#define MICO_BENCH_BACKEND "default"
+#endif
+
+#define MODEL_MAX_REGIONS 256
+// Stack painted below main; a peak at this size means it was exceeded
+#ifndef MODEL_STACK_PAINT
+#ifdef USE_HOST
+#define MODEL_STACK_PAINT (256 * 1024)
+#else
+#define MODEL_STACK_PAINT (16 * 1024)
+#endif
+#endif
+
+#define MODEL_SAMPLES (sizeof(test_label) / sizeof(test_label[0]))
+#define MODEL_INPUT_SIZE (sizeof(test_input[0]) / sizeof(float))
+
+typedef struct {
+    const char* name;
+    int occurrence;     // n-th region of this name within one inference
+    uint64_t count;
+    uint64_t total;
+    uint64_t self;
+} ModelRegion;
+
+typedef struct {
+    int warmup, reps;
+    size_t samples;
+    const char* out[4];
+    int n_out;
+    int json;
+} ModelConfig;
+
+typedef struct {
+    size_t inferences;
+    size_t correct, labelled;
+    double p50_us, p99_us, mean_us;
+    size_t peak[MICO_MEM_N_KINDS + 1];
+    size_t qbuffer;
+    size_t stack;
+} ModelResult;
+
+static MICO_MODEL_T model;
+static ModelRegion regions[MODEL_MAX_REGIONS];
+static int n_regions = 0;
+
+static double __now_us(void){
+    #ifdef USE_HOST
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+    #else
+    return (double)MiCo_time();
+    #endif
+}
+
+static int __cmp_double(const void* a, const void* b){
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Fold the trace of one inference into the per-region totals; the ring is
+// reset after every inference so it never wraps. Regions are keyed by name
+// and occurrence, so two layers running the same op stay separate rows.
+static void __collect_regions(void){
+    static MiCo_Trace_Stat stats[MODEL_MAX_REGIONS];
+    const int n = MiCo_trace_regions(stats, MODEL_MAX_REGIONS);
+    for (int i = 0; i < n; i++){
+        int occurrence = 1;
+        for (int p = 0; p < i; p++){
+            occurrence += !strcmp(stats[p].name, stats[i].name);
+        }
+        int j = 0;
+        while (j < n_regions && (regions[j].occurrence != occurrence ||
+            strcmp(regions[j].name, stats[i].name))) j++;
+        if (j == n_regions){
+            if (n_regions == MODEL_MAX_REGIONS) continue;
+            regions[j].name = stats[i].name;
+            regions[j].occurrence = occurrence;
+            n_regions++;
+        }
+        regions[j].count += stats[i].count;
+        regions[j].total += stats[i].total;
+        regions[j].self += stats[i].self;
+    }
+    MiCo_trace_reset();
+}
+
+static int __infer(const size_t s){
+    memcpy(MICO_MODEL_INPUT(&model), test_input[s], MODEL_INPUT_SIZE * sizeof(float));
+    MICO_MODEL_FORWARD(&model);
+    size_t idx = 0;
+    Tensor2D_F32 logits = *MICO_MODEL_OUTPUT(&model);
+    logits.shape[0] = 1;
+    MiCo_argmax2d_f32(&idx, &logits);
+    return (int)idx;
+}
+
+static void __run(const ModelConfig* cfg, ModelResult* res, double* t){
+    for (int r = 0; r < cfg->warmup; r++){
+        __infer(r % cfg->samples);
+    }
+    MiCo_trace_reset();
+    MiCo_mem_reset_peak();
+
+    size_t n = 0;
+    for (int r = 0; r < cfg->reps; r++){
+        for (size_t s = 0; s < cfg->samples; s++){
+            const double t0 = __now_us();
+            const int pred = __infer(s);
+            t[n++] = __now_us() - t0;
+            __collect_regions();
+            // accuracy counts every sample once
+            if (r == 0){
+                res->labelled++;
+                res->correct += pred == test_label[s];
+            }
+        }
+    }
+    res->inferences = n;
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += t[i];
+    qsort(t, n, sizeof(double), __cmp_double);
+    size_t p99 = (size_t)ceil(0.99 * n);
+    p99 = p99 > 0 ? p99 - 1 : 0;
+    res->p50_us = n % 2 ? t[n / 2] : 0.5 * (t[n / 2 - 1] + t[n / 2]);
+    res->p99_us = t[p99];
+    res->mean_us = sum / n;
+    for (int k = 0; k <= MICO_MEM_N_KINDS; k++){
+        res->peak[k] = MiCo_mem_peak(k);
+    }
+    res->qbuffer = MiCo_mem_qbuffer_peak();
+    res->stack = MiCo_mem_stack_peak();
+}
+
+static double __accuracy(const ModelResult* r){
+    return r->labelled > 0 ? (double)r->correct / r->labelled : 0.0;
+}
+
+static double __us(const uint64_t ticks){
+    return (double)ticks / MiCo_trace_ticks_per_us();
+}
+
+// "name#occurrence", cut to fit the buffer
+static const char* __region_label(const ModelRegion* g, char* buf, const size_t size){
+    snprintf(buf, size, "%s#%d", g->name, g->occurrence);
+    return buf;
+}
+
+static void __print_report(const ModelResult* r){
+    fprintf(stderr, "[Model] %s on %s: %zu inferences\n", MICO_MODEL_NAME, MICO_BENCH_BACKEND, r->inferences);
+    fprintf(stderr, "[Model] latency p50 %.2f us, p99 %.2f us, mean %.2f us, %.1f inferences/s\n",
+        r->p50_us, r->p99_us, r->mean_us, r->mean_us > 0 ? 1e6 / r->mean_us : 0.0);
+    fprintf(stderr, "[Model] accuracy %.2f%% (%zu / %zu)\n", 100.0 * __accuracy(r), r->correct, r->labelled);
+    fprintf(stderr, "[Model] peak memory %zu bytes (weight %zu, activation %zu, workspace %zu, kv_cache %zu), "
+        "QBuffer %zu, stack %zu\n", r->peak[MICO_MEM_N_KINDS], r->peak[MICO_MEM_WEIGHT],
+        r->peak[MICO_MEM_ACT], r->peak[MICO_MEM_WORKSPACE], r->peak[MICO_MEM_KV], r->qbuffer, r->stack);
+    if (r->stack >= MODEL_STACK_PAINT){
+        fprintf(stderr, "[Model] stack use reached the painted %d bytes, raise MODEL_STACK_PAINT\n",
+            MODEL_STACK_PAINT);
+    }
+    if (n_regions == 0){
+        fprintf(stderr, "[Model] no per-region breakdown (build with TRACE=1 or higher)\n");
+        return;
+    }
+    fprintf(stderr, "[Model] %-24s %10s %14s %14s %7s\n", "region", "calls/inf", "total(us)/inf",
+        "self(us)/inf", "self%");
+    for (int i = 0; i < n_regions; i++){
+        const ModelRegion* g = &regions[i];
+        const double self = __us(g->self) / r->inferences;
+        char label[64];
+        fprintf(stderr, "[Model] %-24s %10.2f %14.2f %14.2f %7.1f\n", __region_label(g, label, sizeof(label)),
+            (double)g->count / r->inferences, __us(g->total) / r->inferences, self,
+            r->mean_us > 0 ? 100.0 * self / r->mean_us : 0.0);
+    }
+}
+
+static void __write_json(FILE* f, const ModelResult* r){
+    fprintf(f, "{\n  \"backend\": \"%s\", \"model\": \"%s\", \"dataset\": \"%s\",\n",
+        MICO_BENCH_BACKEND, MICO_MODEL_NAME, MICO_TEST_HEADER);
+    fprintf(f, "  \"inferences\": %zu, \"p50_us\": %.3f, \"p99_us\": %.3f, \"mean_us\": %.3f, "
+        "\"inferences_per_s\": %.3f,\n", r->inferences, r->p50_us, r->p99_us, r->mean_us,
+        r->mean_us > 0 ? 1e6 / r->mean_us : 0.0);
+    fprintf(f, "  \"accuracy\": %.4f, \"correct\": %zu, \"samples\": %zu,\n",
+        __accuracy(r), r->correct, r->labelled);
+    fprintf(f, "  \"memory\": {\"peak\": %zu, \"weight\": %zu, \"activation\": %zu, \"workspace\": %zu, "
+        "\"kv_cache\": %zu, \"qbuffer\": %zu, \"stack\": %zu},\n", r->peak[MICO_MEM_N_KINDS],
+        r->peak[MICO_MEM_WEIGHT], r->peak[MICO_MEM_ACT], r->peak[MICO_MEM_WORKSPACE],
+        r->peak[MICO_MEM_KV], r->qbuffer, r->stack);
+    fprintf(f, "  \"regions\": [\n");
+    for (int i = 0; i < n_regions; i++){
+        const ModelRegion* g = &regions[i];
+        fprintf(f, "    {\"name\": \"%s\", \"occurrence\": %d, \"calls_per_inference\": %.3f, \"total_us\": %.3f, \"self_us\": %.3f}%s\n",
+            g->name, g->occurrence, (double)g->count / r->inferences, __us(g->total) / r->inferences,
+            __us(g->self) / r->inferences, i + 1 < n_regions ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+// One summary row per run; the header is only written to a new file so
+// runs of several models and backends collect into one table.
+static void __write_csv(FILE* f, const int header, const ModelResult* r){
+    if (header){
+        fprintf(f, "backend,model,dataset,inferences,p50_us,p99_us,mean_us,inferences_per_s,accuracy,"
+            "peak_bytes,weight_bytes,activation_bytes,workspace_bytes,kv_cache_bytes,qbuffer_bytes,stack_bytes\n");
+    }
+    fprintf(f, "%s,%s,%s,%zu,%.3f,%.3f,%.3f,%.3f,%.4f,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n",
+        MICO_BENCH_BACKEND, MICO_MODEL_NAME, MICO_TEST_HEADER, r->inferences,
+        r->p50_us, r->p99_us, r->mean_us, r->mean_us > 0 ? 1e6 / r->mean_us : 0.0, __accuracy(r),
+        r->peak[MICO_MEM_N_KINDS], r->peak[MICO_MEM_WEIGHT], r->peak[MICO_MEM_ACT],
+        r->peak[MICO_MEM_WORKSPACE], r->peak[MICO_MEM_KV], r->qbuffer, r->stack);
+}
+
+static void __usage(const char* prog){
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --samples N       embedded samples to run, default all (%zu)\n"
+        "  --warmup N        warmup inferences, default 3\n"
+        "  --reps N          passes over the samples, default 5\n"
+        "  --json            JSON to stdout instead of CSV\n"
+        "  -o FILE           write results to FILE, JSON if it ends in .json;\n"
+        "                    a CSV file is appended to. May be given more than once\n",
+        prog, (size_t)MODEL_SAMPLES);
+}
+
+int main(int argc, char** argv){
+    MiCo_mem_stack_paint(MODEL_STACK_PAINT);
+
+    ModelConfig cfg = {
+        .warmup = 3, .reps = 5, .samples = MODEL_SAMPLES,
+        .n_out = 0, .json = 0
+    };
+    for (int i = 1; i < argc; i++){
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")){
+            __usage(argv[0]);
+            return 0;
+        } else if (!strcmp(a, "--json")){
+            cfg.json = 1;
+            continue;
+        }
+        if (v == NULL){
+            __usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (!strcmp(a, "--samples")) cfg.samples = (size_t)atol(v);
+        else if (!strcmp(a, "--warmup")) cfg.warmup = atoi(v);
+        else if (!strcmp(a, "--reps")) cfg.reps = atoi(v);
+        else if (!strcmp(a, "-o")){
+            MiCo_assert(cfg.n_out < 4, "[Model] too many output files");
+            cfg.out[cfg.n_out++] = v;
+        }
+        else {
+            __usage(argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.samples > MODEL_SAMPLES) cfg.samples = MODEL_SAMPLES;
+    MiCo_assert(cfg.samples > 0 && cfg.reps > 0 && cfg.warmup >= 0, "[Model] invalid sample or repetition count");
+
+    MICO_MODEL_INIT(&model);
+
+    double* t = malloc(cfg.samples * cfg.reps * sizeof(double));
+    MiCo_assert(t != NULL, "[Model] failed to allocate buffers");
+    ModelResult res;
+    memset(&res, 0, sizeof(res));
+    __run(&cfg, &res, t);
+    free(t);
+
+    __print_report(&res);
+    if (cfg.n_out == 0){
+        if (cfg.json) __write_json(stdout, &res);
+        else __write_csv(stdout, 1, &res);
+    }
+    for (int i = 0; i < cfg.n_out; i++){
+        const size_t len = strlen(cfg.out[i]);
+        const int json = len >= 5 && !strcmp(cfg.out[i] + len - 5, ".json");
+        FILE* f = fopen(cfg.out[i], json ? "w" : "a");
+        MiCo_assert(f != NULL, "[Model] cannot open output file");
+        if (json) __write_json(f, &res);
+        else __write_csv(f, ftell(f) == 0, &res);
+        fclose(f);
+    }
+    return 0;
+}
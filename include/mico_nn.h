@@ -73,6 +73,33 @@ void MiCo_bitlinear3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
     const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias,
     const qtype wq, const qtype aq, const size_t align);
 
+// Pre-quantized activation handles: quantize once, reuse across layers
+size_t MiCo_qact_size(const size_t rows, const size_t cols,
+    const qtype aq, const size_t align);
+void MiCo_2D_quant_act(Tensor2D_Q8 *qx, const Tensor2D_F32 *x,
+    const qtype aq, const size_t align);
+void MiCo_4D_quant_act_pw(Tensor2D_Q8 *qx, const Tensor4D_F32 *x,
+    const qtype aq, const size_t align);
+
+void MiCo_bitlinear_q_f32(Tensor2D_F32 *y, const Tensor2D_Q8 *qx,
+    const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias, const qtype wq);
+void MiCo_bitlinear_multi_f32(Tensor2D_F32 *const *ys, const Tensor2D_Q8 *qx,
+    const Tensor2D_Q8 *const *weights, const Tensor1D_F32 *const *biases,
+    const size_t n_weights);
+
+// Fused classifier / LM head: running top-k (and log-sum-exp) per row
+void MiCo_bitlinear_topk_f32(size_t *top_idx, float *top_val, float *lse,
+    const Tensor2D_Q8 *qx, const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias,
+    const qtype wq, const size_t k, const float temperature);
+
+// Fused QKV projection with RoPE, writes K/V into the cache
+void MiCo_bitlinear_qkv_f32(Tensor2D_F32 *q, const Tensor2D_F32 *x,
+    const Tensor2D_Q8 *w_qkv, const float *w_scales,
+    void *key_cache, void *value_cache, float *key_scales, float *value_scales,
+    const uint8_t kv_bits, const int pos0, const float rope_theta,
+    const MiCo_MHA_Config *cfg,
+    const qtype wq, const qtype aq, const size_t align);
+
 // Convolution Functions
 void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const Tensor4D_Q8 *weight, const Tensor1D_F32 *bias, 
@@ -80,6 +107,9 @@ void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
     const size_t stride, const size_t padding, 
     const size_t dilation, const size_t groups, const size_t align);
 
+void MiCo_bitconv2d_pw_q_f32(Tensor4D_F32 *y, const Tensor2D_Q8 *qx,
+    const Tensor4D_Q8 *weight, const Tensor1D_F32 *bias, const qtype wq);
+
 // 1D Convolution Functions
 void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, 
     const Tensor3D_Q8 *weight, const Tensor1D_F32 *bias, 
@@ -87,4 +117,53 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
     const size_t stride, const size_t padding, 
     const size_t dilation, const size_t groups, const size_t align);
 
+// Attention Functions
+void MiCo_bitattention_f32(Tensor4D_F32 *y, const Tensor4D_F32 *q,
+    const Tensor4D_F32 *k, const Tensor4D_F32 *v, const float scale,
+    const qtype aq, const qtype kq, const qtype vq, const size_t align);
+
+// Streaming 1D Convolution
+typedef struct {
+    size_t channels;         // input channels
+    size_t kernel;           // kernel length
+    size_t stride;
+    size_t dilation;
+    size_t hist;             // (kernel - 1) * dilation frames kept between pushes
+    size_t max_hop;          // max new frames per push
+    size_t len;              // frames currently buffered
+    size_t skip;             // frames to drop before the next output (stride phase)
+    float *buf;              // [channels, hist + max_hop]
+} MiCo_Conv1D_Stream;
+
+void MiCo_conv1d_stream_init(MiCo_Conv1D_Stream *s, const size_t channels,
+    const size_t kernel, const size_t stride, const size_t dilation,
+    const size_t max_hop);
+void MiCo_conv1d_stream_reset(MiCo_Conv1D_Stream *s);
+void MiCo_conv1d_stream_free(MiCo_Conv1D_Stream *s);
+size_t MiCo_bitconv1d_stream_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
+    MiCo_Conv1D_Stream *s, const Tensor3D_Q8 *weight, const Tensor1D_F32 *bias,
+    const qtype wq, const qtype aq, const size_t groups, const size_t align);
+
+// Quantized KV-Cache Attention Functions
+void MiCo_kv_cache_store_q(qbyte* cache, float* scales, const float* x,
+    const int pos, const int kv_dim, const int group_size, const qtype bits);
+float MiCo_kvq_dot_f32(const float* q, const qbyte* k,
+    const int n, const qtype bits);
+void MiCo_kvq_axpy_f32(float* y, const float a, const qbyte* v,
+    const int n, const qtype bits);
+
+void MiCo_multihead_attention_f32_kvq(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    qbyte* key_cache,              // packed key cache buffer
+    qbyte* value_cache,            // packed value cache buffer
+    float* key_scales,             // [seq_len, kv_dim / group_size] key scales
+    float* value_scales,           // [seq_len, kv_dim / group_size] value scales
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current position
+    const int group_size,          // elements sharing one scale
+    const qtype kv_bits,           // KV cache bit-width (4 or 2)
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
 #endif // __MICO_NN_H
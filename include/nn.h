@@ -186,7 +186,13 @@ void MiCo_print_tensor3d_f32(const Tensor3D_F32 *x);
 void MiCo_print_tensor4d_f32(const Tensor4D_F32 *x);
 
 // Allocate Functions
+// All library allocations are accounted by kind (MICO_MEM_* in profile.h);
+// MiCo_alloc / MiCo_malloc / MiCo_calloc count as workspace.
+// Blocks from any of them are released with MiCo_free.
 void* MiCo_alloc(const size_t size, const int align);
+void* MiCo_alloc_kind(const size_t size, const int align, const int kind);
+void* MiCo_malloc(const size_t size);
+void* MiCo_calloc(const size_t count, const size_t size);
 void MiCo_free(void *ptr);
 
 // MatMul Functions
@@ -260,7 +266,150 @@ void MiCo_multihead_attention_f32_kv8(
     const MiCo_MHA_Config* cfg     // MHA configuration
 );
 
+void MiCo_multihead_attention_f32_batched(
+    Tensor2D_F32* output,           // [n_seqs, n_heads * head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_seqs, n_heads * head_size] - query vectors
+    float* const* key_caches,      // [n_seqs] key cache of each sequence
+    float* const* value_caches,    // [n_seqs] value cache of each sequence
+    float* att_buffer,             // [n_seqs, n_heads, seq_len] - attention scores buffer
+    const int* pos,                // [n_seqs] current position of each sequence
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
+void MiCo_multihead_attention_f32_prefill(
+    Tensor2D_F32* output,           // [n_tok, n_heads * head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_tok, n_heads * head_size] - query vectors
+    const Tensor2D_F32* key,       // [n_tok, kv_dim] - keys of the chunk
+    const Tensor2D_F32* value,     // [n_tok, kv_dim] - values of the chunk
+    float* key_cache,              // [seq_len, kv_dim] key cache buffer
+    float* value_cache,            // [seq_len, kv_dim] value cache buffer
+    const int pos0,                // position of the first chunk token
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
+// Sliding-Window Attention
+typedef struct MHA_Window
+{
+    int window;              // ring buffer positions for recent tokens
+    int n_sink;              // attention-sink tokens pinned at the start
+} MiCo_MHA_Window;
+
+int MiCo_window_slot(const MiCo_MHA_Window* win, const int pos);
+
+void MiCo_multihead_attention_f32_window(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    float* key_cache,              // [n_sink + window, kv_dim] key ring buffer
+    float* value_cache,            // [n_sink + window, kv_dim] value ring buffer
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current (unbounded) position
+    const MiCo_MHA_Window* win,    // window configuration
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
+void MiCo_multihead_attention_f32_kv8_window(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    int8_t* key_cache,             // [n_sink + window, kv_dim] key ring buffer
+    int8_t* value_cache,           // [n_sink + window, kv_dim] value ring buffer
+    float* key_scales,             // [n_sink + window] key scales
+    float* value_scales,           // [n_sink + window] value scales
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current (unbounded) position
+    const MiCo_MHA_Window* win,    // window configuration
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
+// Paged KV Cache
+typedef struct KV_Pool
+{
+    int n_blocks;            // number of blocks in the pool
+    int block_size;          // timesteps per block
+    int kv_dim;              // key-value dimension
+    uint8_t kv_bits;         // storage precision (32 for FP32, 8 for INT8)
+    void* key_blocks;        // [n_blocks, block_size, kv_dim]
+    void* value_blocks;      // [n_blocks, block_size, kv_dim]
+    float* key_scales;       // [n_blocks, block_size] (INT8 only)
+    float* value_scales;     // [n_blocks, block_size] (INT8 only)
+    int* free_list;          // stack of free block ids
+    int n_free;              // number of free blocks
+    int* ref_count;          // [n_blocks] owners of each block (sequences + prefix cache)
+} MiCo_KV_Pool;
+
+typedef struct KV_Seq
+{
+    int* block_table;        // logical block -> physical block
+    int max_blocks;          // capacity of the block table
+    int n_blocks;            // blocks currently mapped
+    int len;                 // timesteps stored
+} MiCo_KV_Seq;
+
+void MiCo_kv_pool_init(MiCo_KV_Pool* pool, const int n_blocks,
+    const int block_size, const int kv_dim, const uint8_t kv_bits);
+void MiCo_kv_pool_free(MiCo_KV_Pool* pool);
+int MiCo_kv_pool_alloc_block(MiCo_KV_Pool* pool);
+void MiCo_kv_pool_retain_block(MiCo_KV_Pool* pool, const int block);
+void MiCo_kv_pool_release_block(MiCo_KV_Pool* pool, const int block);
+
+void MiCo_kv_seq_init(MiCo_KV_Seq* seq, const int max_blocks);
+void MiCo_kv_seq_release(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq);
+void MiCo_kv_seq_free(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq);
+int MiCo_kv_seq_append(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq,
+    const float* key, const float* value);
+
+// Prefix KV Cache
+typedef struct KV_Prefix_Entry
+{
+    uint64_t hash;           // chained hash of all tokens up to the end of the block
+    int block;               // physical block id, -1 for an empty slot
+    int parent;              // block of the previous prefix block, -1 at depth 0
+    int depth;               // block index within the prefix
+    uint64_t last_used;      // LRU stamp
+} MiCo_KV_Prefix_Entry;
+
+typedef struct KV_Prefix_Cache
+{
+    MiCo_KV_Pool* pool;      // pool the cached blocks live in
+    int capacity;            // max cached blocks (memory cap)
+    int n_entries;           // blocks currently cached
+    int table_size;          // hash table slots, power of two
+    MiCo_KV_Prefix_Entry* table;
+    int* tokens;             // [pool->n_blocks, block_size] token ids of cached blocks
+    int* children;           // [pool->n_blocks] cached blocks chained to each block
+    uint64_t clock;          // LRU clock
+} MiCo_KV_Prefix_Cache;
+
+void MiCo_kv_prefix_init(MiCo_KV_Prefix_Cache* cache, MiCo_KV_Pool* pool, const int capacity);
+void MiCo_kv_prefix_free(MiCo_KV_Prefix_Cache* cache);
+int MiCo_kv_prefix_match(MiCo_KV_Prefix_Cache* cache, MiCo_KV_Seq* seq,
+    const int* tokens, const int n_tokens);
+int MiCo_kv_prefix_insert(MiCo_KV_Prefix_Cache* cache, const MiCo_KV_Seq* seq,
+    const int* tokens, const int n_tokens);
+int MiCo_kv_prefix_evict(MiCo_KV_Prefix_Cache* cache, const int n_blocks);
+
+void MiCo_paged_attention_f32(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    const MiCo_KV_Pool* pool,      // FP32 block pool
+    const MiCo_KV_Seq* seq,        // block table of this sequence
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current position
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
+void MiCo_paged_attention_f32_kv8(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    const MiCo_KV_Pool* pool,      // INT8 block pool
+    const MiCo_KV_Seq* seq,        // block table of this sequence
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current position
+    const MiCo_MHA_Config* cfg     // MHA configuration
+);
+
 // Softmax Function
+float MiCo_fast_expf(float x);
+void MiCo_softmax_f32(float* dst, const float* src, const size_t n);
 void softmax(float* x, int size);
 void MiCo_softmax2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const int dim);
 void MiCo_softmax3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const int dim);
@@ -284,6 +433,39 @@ void MiCo_linear_attention_f32(
     const float eps
 );
 
+// Streaming Linear Attention
+typedef struct LinearAttn_State
+{
+    size_t n_heads;          // number of heads
+    size_t head_dim;         // query/key dimension D
+    size_t value_dim;        // value dimension M
+    float* context;          // [n_heads, D, M] running sum of phi(k)^T v
+    float* k_sum;            // [n_heads, D] running sum of phi(k)
+} MiCo_LinearAttn_State;
+
+void MiCo_linear_attention_state_init(MiCo_LinearAttn_State *state,
+    const size_t n_heads, const size_t head_dim, const size_t value_dim);
+void MiCo_linear_attention_state_reset(MiCo_LinearAttn_State *state);
+void MiCo_linear_attention_state_free(MiCo_LinearAttn_State *state);
+
+void MiCo_linear_attention_step_f32(
+    Tensor2D_F32 *y,                // [n_heads, M]
+    const Tensor2D_F32 *q,          // [n_heads, D]
+    const Tensor2D_F32 *k,          // [n_heads, D]
+    const Tensor2D_F32 *v,          // [n_heads, M]
+    MiCo_LinearAttn_State *state,
+    const float eps
+);
+
+void MiCo_linear_attention_chunk_f32(
+    Tensor3D_F32 *y,                // [C, n_heads, M]
+    const Tensor3D_F32 *q,          // [n_heads, C, D]
+    const Tensor3D_F32 *k,          // [n_heads, C, D]
+    const Tensor3D_F32 *v,          // [n_heads, C, M]
+    MiCo_LinearAttn_State *state,
+    const float eps
+);
+
 void MiCo_ViT_attention_f32(
     Tensor4D_F32 *y,
     const Tensor4D_F32 *q,
@@ -292,6 +474,26 @@ void MiCo_ViT_attention_f32(
     const float scale
 );
 
+void MiCo_ViT_attention_prop_f32(
+    Tensor4D_F32 *y,
+    const Tensor4D_F32 *q,
+    const Tensor4D_F32 *k,
+    const Tensor4D_F32 *v,
+    const Tensor2D_F32 *size,       // [B, J] token sizes after merging
+    const float scale
+);
+
+// Token Merging (ToMe)
+void MiCo_tome_merge_f32(
+    Tensor3D_F32 *y,                // [B, N - r, C]
+    Tensor2D_F32 *size_out,         // [B, N - r]
+    const Tensor3D_F32 *x,          // [B, N, C]
+    const Tensor3D_F32 *metric,     // [B, N, D]
+    const Tensor2D_F32 *size,       // [B, N] or NULL
+    const size_t r,
+    const int protect_cls
+);
+
 void MiCo_einsum_bkn_bnd_bd_f32(
     Tensor2D_F32 *y,
     const Tensor3D_F32 *a,
@@ -1,6 +1,9 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 long int MiCo_time();
 void MiCo_print_profilers();
 void MiCo_reset_profilers();
@@ -11,4 +14,262 @@ extern long IM2COL_TIMER;
 extern long SOFTMAX_TIMER;
 extern long ATTN_TIMER;
 
-#endif // PROFILE_H
\ No newline at end of file
+// Hierarchical tracing
+// Regions are recorded as begin/end events into a per-thread ring buffer.
+// MICO_TRACE_LEVEL selects what is compiled in (set TRACE=<n> in make):
+//   0: nothing (default), 1: layers / ops, 2: + phases, 3: + inner kernels
+// A region whose level is above MICO_TRACE_LEVEL expands to nothing.
+// MICO_PERF (PERF=1) implies level 2 unless a level is given,
+// MICO_MEM (MEM=1) and MICO_CACHESIM (CACHESIM=1) imply level 1.
+#ifndef MICO_TRACE_LEVEL
+#ifdef MICO_PERF
+#define MICO_TRACE_LEVEL 2
+#elif defined(MICO_MEM) || defined(MICO_CACHESIM)
+#define MICO_TRACE_LEVEL 1
+#else
+#define MICO_TRACE_LEVEL 0
+#endif
+#endif
+
+#define MICO_TRACE_LAYER  1
+#define MICO_TRACE_PHASE  2
+#define MICO_TRACE_KERNEL 3
+
+#ifndef MICO_TRACE_RING_SIZE
+#define MICO_TRACE_RING_SIZE 4096   // events per thread
+#endif
+
+#ifndef MICO_TRACE_MAX_THREADS
+#ifdef USE_HOST
+#define MICO_TRACE_MAX_THREADS 64
+#else
+#define MICO_TRACE_MAX_THREADS 1
+#endif
+#endif
+
+typedef struct {
+    uint64_t ts;        // ticks of MiCo_trace_clock()
+    const char* name;   // region name (string literal), NULL for an end event
+} MiCo_Trace_Event;
+
+// Per region name totals in ticks; self excludes nested regions
+typedef struct {
+    const char* name;
+    uint32_t count;
+    uint64_t total;
+    uint64_t self;
+} MiCo_Trace_Stat;
+
+// Byte sink for the binary dump, e.g. a UART writer on the SoC
+typedef void (*MiCo_Trace_Writer)(const uint8_t* data, size_t n, void* ctx);
+
+uint64_t MiCo_trace_clock();
+uint32_t MiCo_trace_ticks_per_us();
+void MiCo_trace_begin(const char* name);
+void MiCo_trace_end();
+void MiCo_trace_reset();
+void MiCo_trace_print_summary();
+int MiCo_trace_stats(MiCo_Trace_Stat* stats, const int max);
+int MiCo_trace_regions(MiCo_Trace_Stat* regions, const int max);
+size_t MiCo_trace_dump_binary(MiCo_Trace_Writer write, void* ctx);
+#ifdef USE_HOST
+int MiCo_trace_dump_chrome(const char* path);
+int MiCo_trace_binary_to_chrome(const char* bin_path, const char* json_path);
+#endif
+
+#define MiCo_TRACE_BEGIN(level, name) \
+    do { if ((level) <= MICO_TRACE_LEVEL) MiCo_trace_begin(name); } while (0)
+#define MiCo_TRACE_END(level) \
+    do { if ((level) <= MICO_TRACE_LEVEL) MiCo_trace_end(); } while (0)
+
+// Region closed automatically at the end of the enclosing block (GCC/Clang)
+#define __MICO_TRACE_CAT2(a, b) a##b
+#define __MICO_TRACE_CAT(a, b) __MICO_TRACE_CAT2(a, b)
+static inline void __mico_trace_scope_end(const int* active){
+    if (*active) MiCo_trace_end();
+}
+#define MiCo_TRACE_SCOPE(level, name) \
+    __attribute__((cleanup(__mico_trace_scope_end))) const int \
+    __MICO_TRACE_CAT(__mico_trace_, __LINE__) = \
+    ((level) <= MICO_TRACE_LEVEL ? (MiCo_trace_begin(name), 1) : 0)
+
+// Hardware counters per trace region (Linux perf_event_open, -DMICO_PERF)
+// MICO_PERF_HW counts cycles, instructions, L1D / LLC and branch misses.
+// MICO_PERF_INSTR counts user-space instructions only, which is stable on
+// noisy shared machines; it is also the fallback when HW mode cannot open.
+// The mode defaults to $MICO_PERF_MODE ("hw" or "instr").
+enum {
+    MICO_PERF_CYCLES,
+    MICO_PERF_INSTRUCTIONS,
+    MICO_PERF_L1D_MISSES,
+    MICO_PERF_LLC_MISSES,
+    MICO_PERF_BRANCH_MISSES,
+    MICO_PERF_N_COUNTERS
+};
+
+#define MICO_PERF_OFF   0
+#define MICO_PERF_HW    1
+#define MICO_PERF_INSTR 2
+
+void MiCo_perf_set_mode(const int mode);
+int MiCo_perf_mode();
+void MiCo_perf_reset();
+void MiCo_perf_print_report();
+int MiCo_perf_dump_csv(const char* path);
+
+void __MiCo_perf_begin(const char* name);
+void __MiCo_perf_end();
+void __MiCo_perf_macs(const uint64_t macs);
+
+// MACs of a kernel call, charged to the innermost open region
+#if defined(MICO_PERF) && MICO_TRACE_LEVEL > 0
+#define MiCo_PERF_MACS(n) __MiCo_perf_macs((uint64_t)(n))
+#else
+#define MiCo_PERF_MACS(n) ((void)0)
+#endif
+
+// Roofline report per op call (-DMICO_ROOFLINE, ROOFLINE=1 in make)
+// Every instrumented op records its MACs at (aq, wq) and the minimum bytes
+// it has to move (packed weights, activations, outputs). The report puts
+// the measured time next to the attainable rate
+//   min(peak[aq][wq], MACs / bytes * bandwidth)
+// where the peaks come from a MatMul probe per precision pair and the
+// bandwidth from a STREAM triad probe. Bit width 32 stands for FP32.
+// Only the outermost op is recorded, e.g. bitlinear_f32 and not the
+// bitlinear_q_f32 it calls.
+#ifndef MICO_ROOFLINE_MAX_RECORDS
+#ifdef USE_HOST
+#define MICO_ROOFLINE_MAX_RECORDS 4096
+#else
+#define MICO_ROOFLINE_MAX_RECORDS 256
+#endif
+#endif
+
+uint64_t MiCo_roofline_enter();
+void MiCo_roofline_exit(const char* op, const uint64_t macs, const int aq, const int wq,
+    const uint64_t bytes, const uint64_t t0);
+void MiCo_roofline_probe();
+void MiCo_roofline_reset();
+void MiCo_roofline_print();
+
+// Bytes of n elements at the given bit width
+#define MICO_RL_BYTES(n, bits) ((uint64_t)(n) * (uint64_t)(bits) / 8)
+
+#ifdef MICO_ROOFLINE
+#define MiCo_ROOFLINE_BEGIN() const uint64_t __mico_rl_t0 = MiCo_roofline_enter()
+#define MiCo_ROOFLINE_END(op, macs, aq, wq, bytes) \
+    MiCo_roofline_exit(op, (uint64_t)(macs), aq, wq, (uint64_t)(bytes), __mico_rl_t0)
+#else
+#define MiCo_ROOFLINE_BEGIN()
+#define MiCo_ROOFLINE_END(op, macs, aq, wq, bytes) ((void)0)
+#endif
+
+// Memory accounting
+// Current and peak bytes per kind (MICO_MEM_WEIGHT ... MICO_MEM_KV, or
+// MICO_MEM_ALL) cover every library allocation plus the static buffers
+// added with MiCo_mem_register. MiCo_mem_qbuffer_peak is the largest
+// MiCo_QBuffer use, i.e. the smallest QUANTIZE_BUFFER_SIZE that works.
+// Call MiCo_mem_stack_paint(bytes) early in main to measure stack depth.
+// With -DMICO_MEM (MEM=1) every trace region records the bytes allocated
+// above its entry level, per region name.
+enum {
+    MICO_MEM_WEIGHT,
+    MICO_MEM_ACT,
+    MICO_MEM_WORKSPACE,
+    MICO_MEM_KV,
+    MICO_MEM_N_KINDS
+};
+#define MICO_MEM_ALL MICO_MEM_N_KINDS
+
+#ifndef MICO_MEM_MAX_LAYERS
+#define MICO_MEM_MAX_LAYERS 64
+#endif
+
+typedef struct {
+    const char* name;
+    uint32_t calls;
+    size_t peak[MICO_MEM_N_KINDS + 1];  // per kind and total, above entry
+    size_t qbuffer;                     // largest QBuffer use inside
+} MiCo_Mem_Layer;
+
+void MiCo_mem_register(const int kind, const size_t bytes);
+void MiCo_mem_release(const int kind, const size_t bytes);
+size_t MiCo_mem_current(const int kind);
+size_t MiCo_mem_peak(const int kind);
+void MiCo_mem_reset_peak();
+void MiCo_mem_qbuffer_use(const size_t bytes);
+size_t MiCo_mem_qbuffer_peak();
+void MiCo_mem_stack_paint(const size_t bytes);
+size_t MiCo_mem_stack_peak();
+int MiCo_mem_layers(const MiCo_Mem_Layer** layers);
+void MiCo_mem_reset_layers();
+void MiCo_mem_print_report();
+
+void __MiCo_mem_begin(const char* name);
+void __MiCo_mem_end();
+
+// Data-cache simulation (-DMICO_CACHESIM, CACHESIM=1 in make)
+// The im2col, activation quantization and MatMul kernels emit the addresses
+// they touch into a set-associative LRU cache model. Quantization and MatMul
+// are replaced per target, so their traces replay the loop order of the
+// generic kernels at the dispatch point. Counts are kept per access kind and,
+// per trace region name, inclusive of nested regions. The model is meant for
+// single-threaded host runs; the default geometry is the VexiiRiscv data
+// cache of doc/Survey_On_Im2Col_Blocks.md (2 ways, 64 sets, 64 B lines),
+// and on host $MICO_CACHE overrides it, e.g. "4x64x64" or "2x128x32,wt,nwa".
+enum {
+    MICO_CACHE_IM2COL,
+    MICO_CACHE_QUANT,
+    MICO_CACHE_MATMUL,
+    MICO_CACHE_N_KINDS
+};
+
+#ifndef MICO_CACHE_MAX_LAYERS
+#define MICO_CACHE_MAX_LAYERS 64
+#endif
+
+typedef struct {
+    uint32_t ways;
+    uint32_t sets;          // power of two
+    uint32_t line;          // bytes, power of two
+    int write_back;         // 0: write-through
+    int write_allocate;     // 0: write misses go around the cache
+} MiCo_Cache_Config;
+
+typedef struct {
+    uint64_t reads;         // lines touched by loads
+    uint64_t writes;        // lines touched by stores
+    uint64_t read_misses;
+    uint64_t write_misses;
+    uint64_t mem_writes;    // dirty lines evicted (write-back) or stores passed through
+} MiCo_Cache_Counts;
+
+typedef struct {
+    const char* name;
+    uint32_t occurrence;    // n-th region of this name within one inference
+    uint32_t calls;
+    MiCo_Cache_Counts kind[MICO_CACHE_N_KINDS];
+} MiCo_Cache_Layer;
+
+int MiCo_cache_config(const MiCo_Cache_Config* cfg);
+MiCo_Cache_Config MiCo_cache_get_config();
+void MiCo_cache_flush();
+void MiCo_cache_reset();
+void MiCo_cache_next_inference();
+const MiCo_Cache_Counts* MiCo_cache_counts(const int kind);
+int MiCo_cache_layers(const MiCo_Cache_Layer** layers);
+void MiCo_cache_print_report();
+
+void __MiCo_cache_access(const int kind, const void* addr, const size_t bytes, const int is_write);
+void __MiCo_cache_begin(const char* name);
+void __MiCo_cache_end();
+
+#ifdef MICO_CACHESIM
+#define MiCo_CACHE_READ(kind, addr, bytes) __MiCo_cache_access(kind, addr, bytes, 0)
+#define MiCo_CACHE_WRITE(kind, addr, bytes) __MiCo_cache_access(kind, addr, bytes, 1)
+#else
+#define MiCo_CACHE_READ(kind, addr, bytes) ((void)0)
+#define MiCo_CACHE_WRITE(kind, addr, bytes) ((void)0)
+#endif
+
+#endif // PROFILE_H
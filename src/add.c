@@ -1,7 +1,9 @@
 #include "nn.h"
+#include "profile.h"
 
 // Adding Functions
 void MiCo_add4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x1, const Tensor4D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "add4d_f32");
     int data_size = y->shape[1] * y->shape [2] * y->shape[3];
 
     MiCo_assert(x1->shape[1] == x2->shape[1], "[Add4D] Channel Size Mismatched!");
@@ -16,6 +18,7 @@ void MiCo_add4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x1, const Tensor4D_F32
 }
 
 void MiCo_add2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x1, const Tensor2D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "add2d_f32");
 
     MiCo_assert(x1->shape[1] == x2->shape[1], "[Add2D] Size Mismatched!");
 
@@ -27,6 +30,7 @@ void MiCo_add2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x1, const Tensor2D_F32
 }
 
 void MiCo_add3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x1, const Tensor3D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "add3d_f32");
     MiCo_assert(x1->shape[0] == x2->shape[0], "[Add3D] Batch Size Mismatched!");
     MiCo_assert(x1->shape[1] == x2->shape[1], "[Add3D] Seq Size Mismatched!");
     MiCo_assert(x1->shape[2] == x2->shape[2], "[Add3D] Feature Size Mismatched!");
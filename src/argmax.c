@@ -1,6 +1,8 @@
 #include "nn.h"
+#include "profile.h"
 
 void MiCo_argmax2d_f32(size_t *idx, const Tensor2D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "argmax2d_f32");
 
     for (size_t i = 0; i < x->shape[0]; i++){
         float max = -FLOAT_MAX;
@@ -0,0 +1,383 @@
+#include "profile.h"
+
+#ifdef RISCV_VEXII
+#include "sim_stdlib.h"
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+// Trace-driven data-cache model.
+// Every access is split into the lines it touches, each counted as one
+// access and looked up in a set-associative cache with LRU replacement.
+// Lines are tagged with their full line address, so any geometry up to
+// MICO_CACHE_MAX_LINES lines can be simulated from one build. A write-back
+// eviction of a dirty line is charged to the access that causes it. The
+// model has no locking and must only be fed from one thread.
+
+#ifndef MICO_CACHE_MAX_LINES
+#define MICO_CACHE_MAX_LINES 8192
+#endif
+
+static MiCo_Cache_Config cache_cfg = {
+    .ways = 2, .sets = 64, .line = 64, .write_back = 1, .write_allocate = 1
+};
+
+static int __cache_valid(const MiCo_Cache_Config* cfg){
+    return cfg->ways > 0 && cfg->sets > 0 && cfg->line > 0 &&
+        (cfg->sets & (cfg->sets - 1)) == 0 && (cfg->line & (cfg->line - 1)) == 0 &&
+        (uint64_t)cfg->ways * cfg->sets <= MICO_CACHE_MAX_LINES;
+}
+
+#ifdef MICO_CACHESIM
+
+#define MICO_CACHE_MAX_DEPTH 64
+
+static const char* cache_kind_names[MICO_CACHE_N_KINDS] = {
+    "im2col", "quant", "matmul"
+};
+
+typedef struct {
+    uintptr_t tag;      // line address
+    uint64_t stamp;     // last use, 0 when invalid
+    uint8_t dirty;
+} __cache_way;
+
+typedef struct {
+    const char* name;
+    uint32_t occurrence;
+    MiCo_Cache_Counts entry[MICO_CACHE_N_KINDS];
+} __cache_frame;
+
+// Regions opened per name since the last reset / next inference
+typedef struct {
+    const char* name;
+    uint32_t opened;
+} __cache_seen;
+
+static __cache_way cache_ways[MICO_CACHE_MAX_LINES];
+static uint64_t cache_clock = 0;
+static uint32_t cache_line_shift = 6;
+static int cache_ready = 0;
+
+static MiCo_Cache_Counts cache_counts[MICO_CACHE_N_KINDS];
+static MiCo_Cache_Layer cache_layers[MICO_CACHE_MAX_LAYERS];
+static int cache_n_layers = 0;
+static __cache_frame cache_stack[MICO_CACHE_MAX_DEPTH];
+static int cache_depth = 0;
+static __cache_seen cache_seen[MICO_CACHE_MAX_LAYERS];
+static int cache_n_seen = 0;
+
+static int __cache_streq(const char* a, const char* b){
+    while (*a && *a == *b){
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+#ifdef USE_HOST
+// "<ways>x<sets>x<line>[,wt][,nwa]"
+static void __cache_parse_env(){
+    const char* env = getenv("MICO_CACHE");
+    if (env == NULL || *env == '\0') return;
+    MiCo_Cache_Config cfg = cache_cfg;
+    char* end;
+    cfg.ways = (uint32_t)strtoul(env, &end, 10);
+    if (*end == 'x') cfg.sets = (uint32_t)strtoul(end + 1, &end, 10);
+    if (*end == 'x') cfg.line = (uint32_t)strtoul(end + 1, &end, 10);
+    while (*end == ','){
+        end++;
+        if (!strncmp(end, "wt", 2)) cfg.write_back = 0;
+        else if (!strncmp(end, "wb", 2)) cfg.write_back = 1;
+        else if (!strncmp(end, "nwa", 3)) cfg.write_allocate = 0;
+        else if (!strncmp(end, "wa", 2)) cfg.write_allocate = 1;
+        while (*end && *end != ',') end++;
+    }
+    if (__cache_valid(&cfg)) cache_cfg = cfg;
+    else printf("[Cache] ignoring invalid MICO_CACHE=%s\n", env);
+}
+#endif
+
+static void __cache_geometry(){
+    cache_line_shift = 0;
+    while ((1u << cache_line_shift) < cache_cfg.line) cache_line_shift++;
+    cache_ready = 1;
+    MiCo_cache_flush();
+}
+
+static void __cache_init(){
+    if (cache_ready) return;
+    #ifdef USE_HOST
+    __cache_parse_env();
+    #endif
+    __cache_geometry();
+}
+
+static void __cache_line(MiCo_Cache_Counts* c, const uintptr_t ln, const int is_write){
+    __cache_way* set = &cache_ways[(ln & (cache_cfg.sets - 1)) * cache_cfg.ways];
+    uint32_t victim = 0;
+    cache_clock++;
+    if (is_write) c->writes++;
+    else c->reads++;
+    for (uint32_t i = 0; i < cache_cfg.ways; i++){
+        if (set[i].stamp != 0 && set[i].tag == ln){
+            set[i].stamp = cache_clock;
+            if (is_write){
+                if (cache_cfg.write_back) set[i].dirty = 1;
+                else c->mem_writes++;
+            }
+            return;
+        }
+        if (set[i].stamp < set[victim].stamp) victim = i;
+    }
+
+    if (is_write) c->write_misses++;
+    else c->read_misses++;
+    // a store that does not allocate, or writes through, goes to memory
+    if (is_write && (!cache_cfg.write_back || !cache_cfg.write_allocate)) c->mem_writes++;
+    if (is_write && !cache_cfg.write_allocate) return;
+
+    __cache_way* w = &set[victim];
+    if (w->stamp != 0 && w->dirty) c->mem_writes++;
+    w->tag = ln;
+    w->stamp = cache_clock;
+    w->dirty = is_write && cache_cfg.write_back;
+}
+
+void __MiCo_cache_access(const int kind, const void* addr, const size_t bytes, const int is_write){
+    if (bytes == 0) return;
+    __cache_init();
+    MiCo_Cache_Counts* c = &cache_counts[kind];
+    const uintptr_t first = (uintptr_t)addr >> cache_line_shift;
+    const uintptr_t last = ((uintptr_t)addr + bytes - 1) >> cache_line_shift;
+    for (uintptr_t ln = first; ln <= last; ln++){
+        __cache_line(c, ln, is_write);
+    }
+}
+
+// Regions are keyed by name and occurrence within one inference, so
+// layers running the same op get separate rows
+static uint32_t __cache_occurrence(const char* name){
+    int i = 0;
+    while (i < cache_n_seen && cache_seen[i].name != name &&
+        !__cache_streq(cache_seen[i].name, name)) i++;
+    if (i == cache_n_seen){
+        if (cache_n_seen == MICO_CACHE_MAX_LAYERS) return 0;
+        cache_seen[i].name = name;
+        cache_seen[i].opened = 0;
+        cache_n_seen++;
+    }
+    return ++cache_seen[i].opened;
+}
+
+void __MiCo_cache_begin(const char* name){
+    if (cache_depth < MICO_CACHE_MAX_DEPTH){
+        __cache_frame* f = &cache_stack[cache_depth];
+        f->name = name;
+        f->occurrence = __cache_occurrence(name);
+        memcpy(f->entry, cache_counts, sizeof(cache_counts));
+    }
+    cache_depth++;
+}
+
+void __MiCo_cache_end(){
+    if (cache_depth == 0) return;
+    cache_depth--;
+    if (cache_depth >= MICO_CACHE_MAX_DEPTH) return;
+    const __cache_frame* f = &cache_stack[cache_depth];
+    if (f->occurrence == 0) return;
+    int i = 0;
+    while (i < cache_n_layers && (cache_layers[i].occurrence != f->occurrence ||
+        (cache_layers[i].name != f->name && !__cache_streq(cache_layers[i].name, f->name)))) i++;
+    if (i == cache_n_layers){
+        if (cache_n_layers == MICO_CACHE_MAX_LAYERS) return;
+        memset(&cache_layers[i], 0, sizeof(MiCo_Cache_Layer));
+        cache_layers[i].name = f->name;
+        cache_layers[i].occurrence = f->occurrence;
+        cache_n_layers++;
+    }
+    MiCo_Cache_Layer* l = &cache_layers[i];
+    l->calls++;
+    for (int k = 0; k < MICO_CACHE_N_KINDS; k++){
+        const MiCo_Cache_Counts* e = &f->entry[k];
+        const MiCo_Cache_Counts* c = &cache_counts[k];
+        l->kind[k].reads += c->reads - e->reads;
+        l->kind[k].writes += c->writes - e->writes;
+        l->kind[k].read_misses += c->read_misses - e->read_misses;
+        l->kind[k].write_misses += c->write_misses - e->write_misses;
+        l->kind[k].mem_writes += c->mem_writes - e->mem_writes;
+    }
+}
+
+int MiCo_cache_config(const MiCo_Cache_Config* cfg){
+    if (!__cache_valid(cfg)) return -1;
+    // An explicit geometry wins over $MICO_CACHE
+    cache_cfg = *cfg;
+    __cache_geometry();
+    MiCo_cache_reset();
+    return 0;
+}
+
+MiCo_Cache_Config MiCo_cache_get_config(){
+    __cache_init();
+    return cache_cfg;
+}
+
+void MiCo_cache_flush(){
+    memset(cache_ways, 0, sizeof(cache_ways));
+    cache_clock = 0;
+}
+
+void MiCo_cache_reset(){
+    __cache_init();
+    MiCo_cache_flush();
+    memset(cache_counts, 0, sizeof(cache_counts));
+    cache_n_layers = 0;
+    cache_n_seen = 0;
+    // Open regions restart from zero
+    for (int d = 0; d < cache_depth && d < MICO_CACHE_MAX_DEPTH; d++){
+        memset(cache_stack[d].entry, 0, sizeof(cache_counts));
+    }
+}
+
+void MiCo_cache_next_inference(){
+    cache_n_seen = 0;
+}
+
+const MiCo_Cache_Counts* MiCo_cache_counts(const int kind){
+    return &cache_counts[kind];
+}
+
+int MiCo_cache_layers(const MiCo_Cache_Layer** layers){
+    *layers = cache_layers;
+    return cache_n_layers;
+}
+
+static uint64_t __cache_accesses(const MiCo_Cache_Counts* c){
+    return c->reads + c->writes;
+}
+
+static uint64_t __cache_misses(const MiCo_Cache_Counts* c){
+    return c->read_misses + c->write_misses;
+}
+
+static double __cache_rate(const uint64_t misses, const uint64_t accesses){
+    return accesses ? 100.0 * (double)misses / (double)accesses : 0.0;
+}
+
+// "name#occurrence" left-aligned in width columns
+// (the simulator printf does not return the length, so it is counted here)
+static void __cache_print_label(const MiCo_Cache_Layer* l, const int width){
+    int n = 1;
+    while (l->name[n - 1]) n++;
+    for (uint32_t v = l->occurrence; v > 0; v /= 10) n++;
+    printf("%s#%lu", l->name, (unsigned long)l->occurrence);
+    for (; n < width; n++) printf(" ");
+}
+
+void MiCo_cache_print_report(){
+    __cache_init();
+    printf("[Cache] %lu ways x %lu sets x %lu B = %lu B, %s, %s\n",
+        (unsigned long)cache_cfg.ways, (unsigned long)cache_cfg.sets,
+        (unsigned long)cache_cfg.line,
+        (unsigned long)cache_cfg.ways * cache_cfg.sets * cache_cfg.line,
+        cache_cfg.write_back ? "write-back" : "write-through",
+        cache_cfg.write_allocate ? "write-allocate" : "no-write-allocate");
+    printf("[Cache] %-10s %12s %12s %12s %12s %8s %12s\n", "kind", "reads", "writes",
+        "read_miss", "write_miss", "miss%", "mem_writes");
+    MiCo_Cache_Counts t = { 0 };
+    for (int k = 0; k < MICO_CACHE_N_KINDS; k++){
+        const MiCo_Cache_Counts* c = &cache_counts[k];
+        printf("[Cache] %-10s %12lu %12lu %12lu %12lu %8.2f %12lu\n", cache_kind_names[k],
+            (unsigned long)c->reads, (unsigned long)c->writes,
+            (unsigned long)c->read_misses, (unsigned long)c->write_misses,
+            __cache_rate(__cache_misses(c), __cache_accesses(c)), (unsigned long)c->mem_writes);
+        t.reads += c->reads;
+        t.writes += c->writes;
+        t.read_misses += c->read_misses;
+        t.write_misses += c->write_misses;
+        t.mem_writes += c->mem_writes;
+    }
+    printf("[Cache] %-10s %12lu %12lu %12lu %12lu %8.2f %12lu\n", "total",
+        (unsigned long)t.reads, (unsigned long)t.writes,
+        (unsigned long)t.read_misses, (unsigned long)t.write_misses,
+        __cache_rate(__cache_misses(&t), __cache_accesses(&t)), (unsigned long)t.mem_writes);
+
+    if (cache_n_layers == 0) return;
+    printf("[Cache] per region, misses inclusive of nested regions:\n");
+    printf("[Cache] %-28s %8s %12s %12s %8s %10s %10s %10s %12s\n", "region", "calls",
+        "accesses", "misses", "miss%", "im2col", "quant", "matmul", "mem_writes");
+    for (int i = 0; i < cache_n_layers; i++){
+        const MiCo_Cache_Layer* l = &cache_layers[i];
+        uint64_t acc = 0, miss = 0, mw = 0;
+        for (int k = 0; k < MICO_CACHE_N_KINDS; k++){
+            acc += __cache_accesses(&l->kind[k]);
+            miss += __cache_misses(&l->kind[k]);
+            mw += l->kind[k].mem_writes;
+        }
+        if (acc == 0) continue;
+        printf("[Cache] ");
+        __cache_print_label(l, 28);
+        printf(" %8lu %12lu %12lu %8.2f %10lu %10lu %10lu %12lu\n",
+            (unsigned long)l->calls, (unsigned long)acc, (unsigned long)miss,
+            __cache_rate(miss, acc),
+            (unsigned long)__cache_misses(&l->kind[MICO_CACHE_IM2COL]),
+            (unsigned long)__cache_misses(&l->kind[MICO_CACHE_QUANT]),
+            (unsigned long)__cache_misses(&l->kind[MICO_CACHE_MATMUL]),
+            (unsigned long)mw);
+    }
+}
+
+#else
+
+void __MiCo_cache_access(const int kind, const void* addr, const size_t bytes, const int is_write){
+    (void)kind;
+    (void)addr;
+    (void)bytes;
+    (void)is_write;
+}
+
+void __MiCo_cache_begin(const char* name){
+    (void)name;
+}
+
+void __MiCo_cache_end(){
+}
+
+int MiCo_cache_config(const MiCo_Cache_Config* cfg){
+    if (!__cache_valid(cfg)) return -1;
+    cache_cfg = *cfg;
+    return 0;
+}
+
+MiCo_Cache_Config MiCo_cache_get_config(){
+    return cache_cfg;
+}
+
+void MiCo_cache_flush(){
+}
+
+void MiCo_cache_reset(){
+}
+
+void MiCo_cache_next_inference(){
+}
+
+const MiCo_Cache_Counts* MiCo_cache_counts(const int kind){
+    static const MiCo_Cache_Counts zero;
+    (void)kind;
+    return &zero;
+}
+
+int MiCo_cache_layers(const MiCo_Cache_Layer** layers){
+    *layers = NULL;
+    return 0;
+}
+
+void MiCo_cache_print_report(){
+    printf("[Cache] cache simulation is disabled (build with CACHESIM=1)\n");
+}
+
+#endif // MICO_CACHESIM
@@ -1,6 +1,8 @@
 #include "nn.h"
+#include "profile.h"
 
 void MiCo_concat4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x1, const Tensor4D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "concat4d_f32");
 
     MiCo_assert(x1->shape[0] == x2->shape[0], "[Concat4D] Batch Size Mismatched!");
     MiCo_assert(y->shape[1] == x1->shape[1] + x2->shape[1], "[Concat4D] Channel Size Mismatched!");
@@ -34,6 +36,7 @@ void MiCo_concat4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x1, const Tensor4D_F
 }
 
 void MiCo_concat2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x1, const Tensor2D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "concat2d_f32");
 
     MiCo_assert(x1->shape[0] == x2->shape[0], "[Concat2D] Batch Size Mismatched!");
     MiCo_assert(y->shape[1] == x1->shape[1] + x2->shape[1], "[Concat2D] Out Size Mismatched!");
@@ -57,6 +60,7 @@ void MiCo_concat2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x1, const Tensor2D_F
 }
 
 void MiCo_concat3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x1, const Tensor3D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "concat3d_f32");
     MiCo_assert(x1->shape[0] == x2->shape[0], "[Concat3D] Batch Size Mismatched!");
     MiCo_assert(x1->shape[2] == x2->shape[2], "[Concat3D] Feature Size Mismatched!");
     MiCo_assert(y->shape[1] == x1->shape[1] + x2->shape[1], "[Concat3D] Seq Size Mismatched!");
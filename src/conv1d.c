@@ -1,9 +1,11 @@
 #include "nn.h"
+#include "profile.h"
 
 // Convolution Functions with Layout NCL (Batch, Channels, Length)
 __attribute__((weak)) void MiCo_conv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, 
     const Tensor3D_F32* weight, const Tensor1D_F32* bias, 
     const size_t stride, const size_t padding, const size_t dilation, const size_t groups){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "conv1d_f32");
     // dilation is not implemented yet
     size_t batch_size = x->shape[0];
 
@@ -24,6 +26,7 @@ __attribute__((weak)) void MiCo_conv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *
     size_t in_c_per_group = in_c / groups;
     size_t out_c_per_group = out_c / groups;
 
+    MiCo_ROOFLINE_BEGIN();
     // Initialize Output Tensor
     if (bias->shape[0] == 0){
         for (size_t i = 0; i < batch_size * out_c * out_l; i++) {
@@ -60,4 +63,6 @@ __attribute__((weak)) void MiCo_conv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *
             }
         }
     }
+    MiCo_ROOFLINE_END("conv1d_f32", batch_size * out_c * out_l * in_c_per_group * k_l, 32, 32,
+        4 * (batch_size * in_c * in_l + out_c * in_c_per_group * k_l + batch_size * out_c * out_l));
 }
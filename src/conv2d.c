@@ -1,4 +1,5 @@
 #include "nn.h"
+#include "profile.h"
 
 #ifdef USE_ALT_LAYOUT
 // NHWC Layout: N, H, W, C
@@ -14,6 +15,7 @@
 __attribute__((weak)) void MiCo_conv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const Tensor4D_F32* weight, const Tensor1D_F32* bias, 
     const size_t stride, const size_t padding, const size_t dilation, const size_t groups){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "conv2d_f32");
     // dilation is not implemented yet
     size_t batch_size = x->shape[0];
 
@@ -58,6 +60,7 @@ __attribute__((weak)) void MiCo_conv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *
         "[Conv2D] Group Mismatched!");
     #endif
     size_t in_c_per_group = in_c / groups;
+    MiCo_ROOFLINE_BEGIN();
     size_t out_c_per_group = out_c / groups;
 
     // Initialize Output Tensor
@@ -120,4 +123,8 @@ __attribute__((weak)) void MiCo_conv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *
             }
         }
     }
+    MiCo_ROOFLINE_END("conv2d_f32",
+        batch_size * out_c * out_h * out_w * in_c_per_group * kernel_size, 32, 32,
+        4 * (batch_size * in_c * in_h * in_w + out_c * in_c_per_group * kernel_size +
+        batch_size * out_c * out_h * out_w));
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "nn.h"
+#include "profile.h"
 #include <string.h>
 
 void MiCo_flatten2d_f32(Tensor2D_F32 *y, const Tensor4D_F32 *x){
@@ -8,6 +9,7 @@ void MiCo_flatten2d_f32(Tensor2D_F32 *y, const Tensor4D_F32 *x){
 }
 
 void MiCo_NHWC2NCHW_flatten_f32(Tensor2D_F32 *y, const Tensor4D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "NHWC2NCHW_flatten_f32");
     const size_t N = x->shape[0];
     const size_t H = x->shape[1];
     const size_t W = x->shape[2];
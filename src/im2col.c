@@ -1,4 +1,5 @@
 #include "nn.h"
+#include "profile.h"
 #include <string.h>
 
 // Reference: github.com/pjreddie/darknet
@@ -90,9 +91,11 @@ void im2col_block_T(const float* data_im, const int channels,
                 
                 if (h_pad >= 0 && h_pad < height && w_pad >= 0 && w_pad < width) {
                     data_col[out_idx] = data_im[(c_im * height + h_pad) * width + w_pad];
+                    MiCo_CACHE_READ(MICO_CACHE_IM2COL, &data_im[(c_im * height + h_pad) * width + w_pad], sizeof(float));
                 } else {
                     data_col[out_idx] = 0;
                 }
+                MiCo_CACHE_WRITE(MICO_CACHE_IM2COL, &data_col[out_idx], sizeof(float));
             }
         }
     }
@@ -239,9 +242,11 @@ void im2col_block_T_NHWC_grouped(const float* data_im, const int channels_per_gr
                             // NHWC with groups: use total_channels as stride, ic as local channel offset
                             // data_im already points to the start of the channel group
                             data_col[out_idx] = data_im[(h_pad * width + w_pad) * total_channels + ic];
+                            MiCo_CACHE_READ(MICO_CACHE_IM2COL, &data_im[(h_pad * width + w_pad) * total_channels + ic], sizeof(float));
                         } else {
                             data_col[out_idx] = 0;
                         }
+                        MiCo_CACHE_WRITE(MICO_CACHE_IM2COL, &data_col[out_idx], sizeof(float));
                     }
                 }
             }
@@ -47,7 +47,7 @@ void MiCo_conv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
         }
     }
     
-    float* col = malloc(in_c_per_group * kernel_size * out_h * out_w * sizeof(float));
+    float* col = MiCo_malloc(in_c_per_group * kernel_size * out_h * out_w * sizeof(float));
     for (size_t b = 0; b < batch_size; b++){
         for (size_t g = 0; g < groups; g++) {
             // Get the input data for the current group
@@ -66,5 +66,5 @@ void MiCo_conv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
             MiCo_MatMul_f32(out_group, w_group, col, out_c_per_group, in_c_per_group * kernel_size, out_h * out_w);
         }
     }
-    free(col);
+    MiCo_free(col);
 }
\ No newline at end of file
@@ -0,0 +1,513 @@
+#include "nn.h"
+#include "mico_quant.h"
+#include "profile.h"
+
+extern long ATTN_TIMER;
+
+// Query bit-width of the INT8 paged kernel in the roofline report
+#ifdef USE_INT8_Q
+#define KV_RL_QBITS 8
+#else
+#define KV_RL_QBITS 32
+#endif
+
+// Paged KV Cache
+// The pool owns n_blocks fixed-size blocks of block_size timesteps each.
+// Sequences grow one block at a time through their block table, so the
+// cache is sized by the tokens actually in flight rather than by
+// seq_len for every request.
+
+void MiCo_kv_pool_init(MiCo_KV_Pool* pool, const int n_blocks,
+    const int block_size, const int kv_dim, const uint8_t kv_bits){
+    MiCo_assert(kv_bits == 32 || kv_bits == 8, "[KVPool] only FP32 and INT8 KV cache is supported");
+    MiCo_assert(n_blocks > 0 && block_size > 0, "[KVPool] invalid pool geometry");
+
+    const size_t elem_size = kv_bits / 8;
+    const size_t pool_bytes = (size_t)n_blocks * block_size * kv_dim * elem_size;
+
+    pool->n_blocks = n_blocks;
+    pool->block_size = block_size;
+    pool->kv_dim = kv_dim;
+    pool->kv_bits = kv_bits;
+    pool->key_blocks = MiCo_alloc_kind(pool_bytes, MICO_ALIGN, MICO_MEM_KV);
+    pool->value_blocks = MiCo_alloc_kind(pool_bytes, MICO_ALIGN, MICO_MEM_KV);
+    pool->key_scales = NULL;
+    pool->value_scales = NULL;
+    if (kv_bits == 8){
+        pool->key_scales = (float*)MiCo_alloc_kind((size_t)n_blocks * block_size * sizeof(float), 0, MICO_MEM_KV);
+        pool->value_scales = (float*)MiCo_alloc_kind((size_t)n_blocks * block_size * sizeof(float), 0, MICO_MEM_KV);
+        MiCo_assert(pool->key_scales != NULL && pool->value_scales != NULL,
+            "[KVPool] failed to allocate scales");
+    }
+    pool->free_list = (int*)MiCo_alloc_kind(n_blocks * sizeof(int), 0, MICO_MEM_KV);
+    pool->ref_count = (int*)MiCo_alloc_kind(n_blocks * sizeof(int), 0, MICO_MEM_KV);
+    MiCo_assert(pool->key_blocks != NULL && pool->value_blocks != NULL &&
+        pool->free_list != NULL && pool->ref_count != NULL,
+        "[KVPool] failed to allocate blocks");
+
+    // Lowest block ids are handed out first
+    for (int i = 0; i < n_blocks; i++){
+        pool->free_list[i] = n_blocks - 1 - i;
+        pool->ref_count[i] = 0;
+    }
+    pool->n_free = n_blocks;
+}
+
+void MiCo_kv_pool_free(MiCo_KV_Pool* pool){
+    MiCo_free(pool->key_blocks);
+    MiCo_free(pool->value_blocks);
+    MiCo_free(pool->key_scales);
+    MiCo_free(pool->value_scales);
+    MiCo_free(pool->free_list);
+    MiCo_free(pool->ref_count);
+    pool->key_blocks = NULL;
+    pool->value_blocks = NULL;
+    pool->key_scales = NULL;
+    pool->value_scales = NULL;
+    pool->free_list = NULL;
+    pool->ref_count = NULL;
+    pool->n_free = 0;
+}
+
+int MiCo_kv_pool_alloc_block(MiCo_KV_Pool* pool){
+    if (pool->n_free == 0) return -1;
+    const int block = pool->free_list[--pool->n_free];
+    pool->ref_count[block] = 1;
+    return block;
+}
+
+// Blocks are reference counted so full prefix blocks can be shared by
+// several sequences and the prefix cache; a block returns to the free
+// list when its last owner releases it.
+void MiCo_kv_pool_retain_block(MiCo_KV_Pool* pool, const int block){
+    MiCo_assert(pool->ref_count[block] > 0, "[KVPool] retain of a free block");
+    pool->ref_count[block]++;
+}
+
+void MiCo_kv_pool_release_block(MiCo_KV_Pool* pool, const int block){
+    MiCo_assert(pool->ref_count[block] > 0, "[KVPool] double free of block");
+    if (--pool->ref_count[block] == 0){
+        pool->free_list[pool->n_free++] = block;
+    }
+}
+
+void MiCo_kv_seq_init(MiCo_KV_Seq* seq, const int max_blocks){
+    seq->block_table = (int*)MiCo_alloc_kind(max_blocks * sizeof(int), 0, MICO_MEM_KV);
+    MiCo_assert(seq->block_table != NULL, "[KVSeq] failed to allocate block table");
+    seq->max_blocks = max_blocks;
+    seq->n_blocks = 0;
+    seq->len = 0;
+}
+
+void MiCo_kv_seq_release(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq){
+    for (int i = 0; i < seq->n_blocks; i++){
+        MiCo_kv_pool_release_block(pool, seq->block_table[i]);
+    }
+    seq->n_blocks = 0;
+    seq->len = 0;
+}
+
+void MiCo_kv_seq_free(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq){
+    MiCo_kv_seq_release(pool, seq);
+    MiCo_free(seq->block_table);
+    seq->block_table = NULL;
+    seq->max_blocks = 0;
+}
+
+// Append one timestep of keys/values. Returns 0 on success and -1 when the
+// block table is full or the pool has run out of blocks.
+int MiCo_kv_seq_append(MiCo_KV_Pool* pool, MiCo_KV_Seq* seq,
+    const float* key, const float* value){
+    const int bs = pool->block_size;
+    const int kv_dim = pool->kv_dim;
+    const int off = seq->len % bs;
+
+    if (off == 0){
+        if (seq->n_blocks == seq->max_blocks) return -1;
+        int block = MiCo_kv_pool_alloc_block(pool);
+        if (block < 0) return -1;
+        seq->block_table[seq->n_blocks++] = block;
+    }
+    const size_t slot = (size_t)seq->block_table[seq->len / bs] * bs + off;
+
+    if (pool->kv_bits == 8){
+        int8_t* k = (int8_t*)pool->key_blocks + slot * kv_dim;
+        int8_t* v = (int8_t*)pool->value_blocks + slot * kv_dim;
+        pool->key_scales[slot] = __FP32toQ8((qbyte*)k, (float*)key, kv_dim);
+        pool->value_scales[slot] = __FP32toQ8((qbyte*)v, (float*)value, kv_dim);
+    } else {
+        memcpy((float*)pool->key_blocks + slot * kv_dim, key, kv_dim * sizeof(float));
+        memcpy((float*)pool->value_blocks + slot * kv_dim, value, kv_dim * sizeof(float));
+    }
+    seq->len++;
+    return 0;
+}
+
+// Prefix KV Cache
+// Full blocks are keyed by a hash chained over every token from the start
+// of the sequence. A hash hit is confirmed against the block's stored token
+// ids and its parent block, so with the walk starting at block 0 a match
+// on block i implies the whole prefix matches, even on hash collisions.
+// The cache owns one reference per cached block; a block can be evicted
+// (LRU) only when no sequence maps it any more and no cached block is
+// chained to it. A sequence that recomputed a cached block holds its own
+// copy, so its later blocks hang off a parent it does not map; without the
+// child count that parent could go first and orphan them. Ties evict the
+// deepest block first.
+
+static uint64_t __prefix_hash(uint64_t h, const int* tokens, const int n){
+    // FNV-1a over the token ids, seeded with the parent block's hash
+    for (int i = 0; i < n; i++){
+        uint32_t t = (uint32_t)tokens[i];
+        for (int b = 0; b < 4; b++){
+            h ^= (t >> (8 * b)) & 0xFF;
+            h *= 0x100000001B3ULL;
+        }
+    }
+    return h;
+}
+
+#define PREFIX_HASH_SEED 0xCBF29CE484222325ULL
+
+static int __prefix_find(const MiCo_KV_Prefix_Cache* cache, const uint64_t hash,
+    const int parent, const int* tokens){
+    const int bs = cache->pool->block_size;
+    const int mask = cache->table_size - 1;
+    for (int i = (int)(hash & mask); ; i = (i + 1) & mask){
+        const MiCo_KV_Prefix_Entry* e = &cache->table[i];
+        if (e->block < 0) return -1;
+        if (e->hash == hash && e->parent == parent &&
+            memcmp(cache->tokens + (size_t)e->block * bs, tokens, bs * sizeof(int)) == 0){
+            return i;
+        }
+    }
+}
+
+// Linear-probing delete with backward shift, so lookups need no tombstones
+static void __prefix_remove(MiCo_KV_Prefix_Cache* cache, int i){
+    const int mask = cache->table_size - 1;
+    MiCo_KV_Prefix_Entry* table = cache->table;
+    if (table[i].parent >= 0) cache->children[table[i].parent]--;
+    table[i].block = -1;
+    for (int j = (i + 1) & mask; table[j].block >= 0; j = (j + 1) & mask){
+        const int home = (int)(table[j].hash & mask);
+        // move j back into the hole unless its home lies in (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)){
+            table[i] = table[j];
+            table[j].block = -1;
+            i = j;
+        }
+    }
+    cache->n_entries--;
+}
+
+void MiCo_kv_prefix_init(MiCo_KV_Prefix_Cache* cache, MiCo_KV_Pool* pool, const int capacity){
+    MiCo_assert(capacity > 0, "[KVPrefix] capacity must be positive");
+    int size = 1;
+    while (size < 2 * capacity) size <<= 1;
+
+    cache->pool = pool;
+    cache->capacity = capacity;
+    cache->n_entries = 0;
+    cache->table_size = size;
+    cache->clock = 0;
+    cache->table = (MiCo_KV_Prefix_Entry*)MiCo_alloc_kind(size * sizeof(MiCo_KV_Prefix_Entry), 0, MICO_MEM_KV);
+    cache->tokens = (int*)MiCo_alloc_kind((size_t)pool->n_blocks * pool->block_size * sizeof(int), 0, MICO_MEM_KV);
+    cache->children = (int*)MiCo_alloc_kind(pool->n_blocks * sizeof(int), 0, MICO_MEM_KV);
+    MiCo_assert(cache->table != NULL && cache->tokens != NULL && cache->children != NULL,
+        "[KVPrefix] failed to allocate table");
+    for (int i = 0; i < size; i++){
+        cache->table[i].block = -1;
+    }
+    memset(cache->children, 0, pool->n_blocks * sizeof(int));
+}
+
+void MiCo_kv_prefix_free(MiCo_KV_Prefix_Cache* cache){
+    for (int i = 0; i < cache->table_size; i++){
+        if (cache->table[i].block >= 0){
+            MiCo_kv_pool_release_block(cache->pool, cache->table[i].block);
+        }
+    }
+    MiCo_free(cache->table);
+    MiCo_free(cache->tokens);
+    MiCo_free(cache->children);
+    cache->table = NULL;
+    cache->tokens = NULL;
+    cache->children = NULL;
+    cache->n_entries = 0;
+    cache->table_size = 0;
+}
+
+// Map the longest cached prefix of tokens into an empty sequence.
+// At most n_tokens - 1 tokens are matched so the caller always runs the
+// last prompt token to get its logits. Returns the matched token count;
+// prefill resumes at that position.
+int MiCo_kv_prefix_match(MiCo_KV_Prefix_Cache* cache, MiCo_KV_Seq* seq,
+    const int* tokens, const int n_tokens){
+    const int bs = cache->pool->block_size;
+    MiCo_assert(seq->len == 0, "[KVPrefix] sequence must be empty");
+
+    const uint64_t stamp = ++cache->clock;
+    uint64_t hash = PREFIX_HASH_SEED;
+    int parent = -1;
+    for (int b = 0; (b + 1) * bs < n_tokens && b < seq->max_blocks; b++){
+        hash = __prefix_hash(hash, tokens + b * bs, bs);
+        const int i = __prefix_find(cache, hash, parent, tokens + b * bs);
+        if (i < 0) break;
+        parent = cache->table[i].block;
+        MiCo_kv_pool_retain_block(cache->pool, cache->table[i].block);
+        cache->table[i].last_used = stamp;
+        seq->block_table[seq->n_blocks++] = cache->table[i].block;
+        seq->len += bs;
+    }
+    return seq->len;
+}
+
+// Evict up to n_blocks least-recently-used leaf blocks that only the
+// cache still owns, returning them to the pool. Returns the number evicted.
+int MiCo_kv_prefix_evict(MiCo_KV_Prefix_Cache* cache, const int n_blocks){
+    int evicted = 0;
+    while (evicted < n_blocks){
+        int lru = -1;
+        for (int i = 0; i < cache->table_size; i++){
+            const MiCo_KV_Prefix_Entry* e = &cache->table[i];
+            if (e->block < 0 || cache->pool->ref_count[e->block] != 1 ||
+                cache->children[e->block] > 0) continue;
+            if (lru < 0 || e->last_used < cache->table[lru].last_used ||
+                (e->last_used == cache->table[lru].last_used && e->depth > cache->table[lru].depth)){
+                lru = i;
+            }
+        }
+        if (lru < 0) break;
+        MiCo_kv_pool_release_block(cache->pool, cache->table[lru].block);
+        __prefix_remove(cache, lru);
+        evicted++;
+    }
+    return evicted;
+}
+
+// Register the full blocks of a prefilled sequence. tokens are the ids
+// stored in seq; blocks already cached are only touched. When the cache is
+// at capacity, unused blocks are evicted first; if none can be evicted the
+// remaining blocks are not cached. Returns the number of blocks added.
+int MiCo_kv_prefix_insert(MiCo_KV_Prefix_Cache* cache, const MiCo_KV_Seq* seq,
+    const int* tokens, const int n_tokens){
+    const int bs = cache->pool->block_size;
+    const int len = n_tokens < seq->len ? n_tokens : seq->len;
+    const int mask = cache->table_size - 1;
+    const uint64_t stamp = ++cache->clock;
+    int added = 0;
+
+    uint64_t hash = PREFIX_HASH_SEED;
+    int parent = -1;
+    for (int b = 0; (b + 1) * bs <= len; b++){
+        hash = __prefix_hash(hash, tokens + b * bs, bs);
+        const int found = __prefix_find(cache, hash, parent, tokens + b * bs);
+        if (found >= 0){
+            cache->table[found].last_used = stamp;
+            // chain the following blocks to the cached copy, which may not
+            // be seq's own if it recomputed this block
+            parent = cache->table[found].block;
+            continue;
+        }
+        if (cache->n_entries == cache->capacity && MiCo_kv_prefix_evict(cache, 1) == 0){
+            break;
+        }
+        int i = (int)(hash & mask);
+        while (cache->table[i].block >= 0) i = (i + 1) & mask;
+        cache->table[i].hash = hash;
+        cache->table[i].block = seq->block_table[b];
+        cache->table[i].parent = parent;
+        cache->table[i].depth = b;
+        cache->table[i].last_used = stamp;
+        memcpy(cache->tokens + (size_t)seq->block_table[b] * bs, tokens + b * bs, bs * sizeof(int));
+        MiCo_kv_pool_retain_block(cache->pool, seq->block_table[b]);
+        if (parent >= 0) cache->children[parent]++;
+        parent = seq->block_table[b];
+        cache->n_entries++;
+        added++;
+    }
+    return added;
+}
+
+// Both paged kernels walk one KV head at a time and score all kv_mul
+// query heads of the group against each gathered K/V row.
+void MiCo_paged_attention_f32(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    const MiCo_KV_Pool* pool,      // FP32 block pool
+    const MiCo_KV_Seq* seq,        // block table of this sequence
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current position
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "paged_attention_f32");
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
+    const int bs = pool->block_size;
+
+    MiCo_assert(pool->kv_bits == 32, "[PagedAttention] pool is not FP32");
+    MiCo_assert(pool->kv_dim == kv_dim, "[PagedAttention] kv_dim mismatch");
+    MiCo_assert(pos < seq->len, "[PagedAttention] position not in cache");
+    MiCo_assert(pos < seq_len, "[PagedAttention] position exceeds seq_len");
+
+    const float attn_scale = 1.0f / sqrtf((float)head_size);
+    const float* key_blocks = (const float*)pool->key_blocks;
+    const float* value_blocks = (const float*)pool->value_blocks;
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    int g;
+    for (g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        const int kv_off = g * head_size;
+        float* q = query->data + h0 * head_size;
+        float* att = att_buffer + h0 * seq_len;
+        float* xb = output->data + h0 * head_size;
+
+        // gather keys block by block through the block table
+        for (int t0 = 0; t0 <= pos; t0 += bs) {
+            const float* kb = key_blocks + (size_t)seq->block_table[t0 / bs] * bs * kv_dim;
+            const int n = (pos + 1 - t0) < bs ? (pos + 1 - t0) : bs;
+            for (int t = 0; t < n; t++) {
+                const float* k = kb + t * kv_dim + kv_off;
+                for (int j = 0; j < kv_mul; j++) {
+                    const float* qj = q + j * head_size;
+                    float score = 0.0f;
+                    for (int i = 0; i < head_size; i++) {
+                        score += qj[i] * k[i];
+                    }
+                    att[j * seq_len + t0 + t] = score * attn_scale;
+                }
+            }
+        }
+
+        for (int j = 0; j < kv_mul; j++) {
+            softmax(att + j * seq_len, pos + 1);
+        }
+
+        for (int i = 0; i < kv_mul * head_size; i++) {
+            xb[i] = 0.0f;
+        }
+        for (int t0 = 0; t0 <= pos; t0 += bs) {
+            const float* vb = value_blocks + (size_t)seq->block_table[t0 / bs] * bs * kv_dim;
+            const int n = (pos + 1 - t0) < bs ? (pos + 1 - t0) : bs;
+            for (int t = 0; t < n; t++) {
+                const float* v = vb + t * kv_dim + kv_off;
+                for (int j = 0; j < kv_mul; j++) {
+                    const float a = att[j * seq_len + t0 + t];
+                    float* xbj = xb + j * head_size;
+                    for (int i = 0; i < head_size; i++) {
+                        xbj[i] += a * v[i];
+                    }
+                }
+            }
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("paged_attention_f32", 2 * n_heads * head_size * (pos + 1), 32, 32,
+        2 * (size_t)(pos + 1) * kv_dim * 4 + 2 * n_heads * head_size * 4);
+}
+
+void MiCo_paged_attention_f32_kv8(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    const MiCo_KV_Pool* pool,      // INT8 block pool
+    const MiCo_KV_Seq* seq,        // block table of this sequence
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current position
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "paged_attention_f32_kv8");
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
+    const int bs = pool->block_size;
+
+    MiCo_assert(pool->kv_bits == 8, "[PagedAttention] pool is not INT8");
+    MiCo_assert(pool->kv_dim == kv_dim, "[PagedAttention] kv_dim mismatch");
+    MiCo_assert(pos < seq->len, "[PagedAttention] position not in cache");
+    MiCo_assert(pos < seq_len, "[PagedAttention] position exceeds seq_len");
+
+    const float attn_scale = 1.0f / sqrtf((float)head_size);
+    const int8_t* key_blocks = (const int8_t*)pool->key_blocks;
+    const int8_t* value_blocks = (const int8_t*)pool->value_blocks;
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    int g;
+    for (g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        const int kv_off = g * head_size;
+        float* q = query->data + h0 * head_size;
+        float* att = att_buffer + h0 * seq_len;
+        float* xb = output->data + h0 * head_size;
+
+        #ifdef USE_INT8_Q
+        int8_t q_int8[kv_mul * head_size];
+        float q_scale[kv_mul];
+        for (int j = 0; j < kv_mul; j++) {
+            q_scale[j] = __FP32toQ8((qbyte*)(q_int8 + j * head_size), q + j * head_size, head_size);
+        }
+        #endif
+
+        for (int t0 = 0; t0 <= pos; t0 += bs) {
+            const size_t slot0 = (size_t)seq->block_table[t0 / bs] * bs;
+            const int n = (pos + 1 - t0) < bs ? (pos + 1 - t0) : bs;
+            for (int t = 0; t < n; t++) {
+                const int8_t* k = key_blocks + (slot0 + t) * kv_dim + kv_off;
+                const float k_scale = pool->key_scales[slot0 + t] * attn_scale;
+                for (int j = 0; j < kv_mul; j++) {
+                    #ifdef USE_INT8_Q
+                    const int8_t* qj = q_int8 + j * head_size;
+                    int32_t acc = 0;
+                    for (int i = 0; i < head_size; i++) {
+                        acc += (int32_t)qj[i] * (int32_t)k[i];
+                    }
+                    att[j * seq_len + t0 + t] = (float)acc * q_scale[j] * k_scale;
+                    #else
+                    const float* qj = q + j * head_size;
+                    float score = 0.0f;
+                    for (int i = 0; i < head_size; i++) {
+                        score += qj[i] * k[i];
+                    }
+                    att[j * seq_len + t0 + t] = score * k_scale;
+                    #endif
+                }
+            }
+        }
+
+        for (int j = 0; j < kv_mul; j++) {
+            softmax(att + j * seq_len, pos + 1);
+        }
+
+        for (int i = 0; i < kv_mul * head_size; i++) {
+            xb[i] = 0.0f;
+        }
+        for (int t0 = 0; t0 <= pos; t0 += bs) {
+            const size_t slot0 = (size_t)seq->block_table[t0 / bs] * bs;
+            const int n = (pos + 1 - t0) < bs ? (pos + 1 - t0) : bs;
+            for (int t = 0; t < n; t++) {
+                const int8_t* v = value_blocks + (slot0 + t) * kv_dim + kv_off;
+                const float v_scale = pool->value_scales[slot0 + t];
+                for (int j = 0; j < kv_mul; j++) {
+                    const float av = att[j * seq_len + t0 + t] * v_scale;
+                    float* xbj = xb + j * head_size;
+                    for (int i = 0; i < head_size; i++) {
+                        xbj[i] += av * v[i];
+                    }
+                }
+            }
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("paged_attention_f32_kv8", 2 * n_heads * head_size * (pos + 1), KV_RL_QBITS, 8,
+        2 * (size_t)(pos + 1) * (kv_dim + 4) + 2 * n_heads * head_size * 4);
+}
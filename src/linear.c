@@ -1,10 +1,12 @@
 #include "nn.h"
+#include "profile.h"
 
 __attribute__((weak)) void MiCo_linear_f32(
     Tensor2D_F32 *y, 
     const Tensor2D_F32 *x, 
     const Tensor2D_F32 *weight, 
     const Tensor1D_F32 *bias) { 
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "linear_f32");
     // nn_assert(x->shape[1] == weight->shape[1], "Cannot perform Linear on tensors of different shapes");
     // nn_assert(bias->shape[0] == weight->shape[0], "Cannot perform Linear on tensors of different shapes");
     // nn_assert(y->shape[0] == x->shape[0] && y->shape[1] == weight->shape[0], "Cannot perform Linear on tensors of different shapes");
@@ -17,6 +19,7 @@ __attribute__((weak)) void MiCo_linear_f32(
     #else
     const size_t out_features = weight->shape[0];
     #endif
+    MiCo_ROOFLINE_BEGIN();
     
     // Initialize Output Tensor
     if (bias->shape[0] == 0){
@@ -33,6 +36,8 @@ __attribute__((weak)) void MiCo_linear_f32(
 
     MiCo_MatMul_f32(y->data, x->data, weight->data, 
         batch_size, in_features, out_features);
+    MiCo_ROOFLINE_END("linear_f32", batch_size * in_features * out_features, 32, 32,
+        4 * (batch_size * in_features + in_features * out_features + batch_size * out_features));
 }
 
 void MiCo_linear3d_f32(
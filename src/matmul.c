@@ -1,10 +1,11 @@
 #include "nn.h"
+#include "profile.h"
 
 // FP32 MatMul Kernel
 __attribute__((weak)) void MiCo_MatMul_f32(
     float* y, const float* x, const float* w, 
     const size_t m, const size_t n, const size_t p){
-        
+    MiCo_ROOFLINE_BEGIN();
     for (size_t i = 0; i < m; i++) {
         for (size_t j = 0; j < p; j++) {
             for (size_t k = 0; k < n; k++) {
@@ -16,4 +17,5 @@ __attribute__((weak)) void MiCo_MatMul_f32(
             }
         }
     }
+    MiCo_ROOFLINE_END("MatMul_f32", m * n * p, 32, 32, 4 * (m * n + n * p + m * p));
 }
\ No newline at end of file
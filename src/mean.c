@@ -1,7 +1,9 @@
 #include "nn.h"
+#include "profile.h"
 
 // Mean reduction (keepdim=False): 2D input -> 1D output
 void MiCo_mean1d_f32(Tensor1D_F32 *y, const Tensor2D_F32 *x, const size_t dim) {
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "mean1d_f32");
     size_t size0 = x->shape[0];
     size_t size1 = x->shape[1];
 
@@ -29,6 +31,7 @@ void MiCo_mean1d_f32(Tensor1D_F32 *y, const Tensor2D_F32 *x, const size_t dim) {
 
 // Mean reduction (keepdim=False): 3D input -> 2D output
 void MiCo_mean2d_f32(Tensor2D_F32 *y, const Tensor3D_F32 *x, const size_t dim) {
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "mean2d_f32");
     size_t d0 = x->shape[0];
     size_t d1 = x->shape[1];
     size_t d2 = x->shape[2];
@@ -75,6 +78,7 @@ void MiCo_mean2d_f32(Tensor2D_F32 *y, const Tensor3D_F32 *x, const size_t dim) {
 
 // Mean reduction (keepdim=False): 4D input -> 3D output
 void MiCo_mean3d_f32(Tensor3D_F32 *y, const Tensor4D_F32 *x, const size_t dim) {
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "mean3d_f32");
     size_t d0 = x->shape[0];
     size_t d1 = x->shape[1];
     size_t d2 = x->shape[2];
@@ -141,6 +145,7 @@ void MiCo_mean3d_f32(Tensor3D_F32 *y, const Tensor4D_F32 *x, const size_t dim) {
 
 // Mean with keepdim=True: 2D input -> 2D output (one dimension becomes 1)
 void MiCo_meankp2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const size_t dim) {
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "meankp2d_f32");
     size_t size0 = x->shape[0];
     size_t size1 = x->shape[1];
 
@@ -170,6 +175,7 @@ void MiCo_meankp2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const size_t dim)
 
 // Mean with keepdim=True: 3D input -> 3D output (one dimension becomes 1)
 void MiCo_meankp3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const size_t dim) {
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "meankp3d_f32");
     size_t d0 = x->shape[0];
     size_t d1 = x->shape[1];
     size_t d2 = x->shape[2];
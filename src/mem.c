@@ -0,0 +1,312 @@
+#include "nn.h"
+#include "mico_nn.h"
+#include "profile.h"
+
+// Memory accounting.
+// Every library allocation carries a small header with its size and kind,
+// so frees are accounted exactly. Current and peak bytes are kept per kind
+// and in total; static buffers (weights, activation arenas) are added with
+// MiCo_mem_register. With -DMICO_MEM each trace region also records the
+// bytes it allocated above its entry level, which gives per-layer peaks.
+
+#ifndef MICO_MEM_MIN_ALIGN
+#define MICO_MEM_MIN_ALIGN (2 * sizeof(void*))
+#endif
+
+#define MICO_MEM_STACK_FILL 0xA5
+
+typedef struct {
+    void* raw;
+    size_t size;
+    int kind;
+} __mem_header;
+
+static const char* mem_kind_names[MICO_MEM_N_KINDS] = {
+    "weight", "activation", "workspace", "kv_cache"
+};
+
+static size_t mem_current[MICO_MEM_N_KINDS + 1];   // last entry: total
+static size_t mem_peak[MICO_MEM_N_KINDS + 1];
+static size_t mem_qbuffer_peak = 0;
+
+static volatile uint8_t* mem_stack_lo = NULL;
+static uint8_t* mem_stack_hi = NULL;
+
+// Host kernels may allocate from OpenMP workers; the SoC is single-threaded
+// and may lack the A extension, so plain arithmetic is used there.
+#ifdef USE_HOST
+#define __MEM_ADD(p, v) __atomic_add_fetch(p, v, __ATOMIC_RELAXED)
+#define __MEM_SUB(p, v) __atomic_sub_fetch(p, v, __ATOMIC_RELAXED)
+#else
+#define __MEM_ADD(p, v) (*(p) += (v))
+#define __MEM_SUB(p, v) (*(p) -= (v))
+#endif
+
+static inline void __mem_raise_peak(size_t* peak, const size_t v){
+    #ifdef USE_HOST
+    size_t p = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (v > p && !__atomic_compare_exchange_n(peak, &p, v, 1,
+        __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+    }
+    #else
+    if (v > *peak) *peak = v;
+    #endif
+}
+
+#ifdef MICO_MEM
+static void __mem_region_update(const size_t qbuffer);
+#endif
+
+static void __mem_add(const int kind, const size_t bytes){
+    const size_t k = __MEM_ADD(&mem_current[kind], bytes);
+    const size_t t = __MEM_ADD(&mem_current[MICO_MEM_N_KINDS], bytes);
+    __mem_raise_peak(&mem_peak[kind], k);
+    __mem_raise_peak(&mem_peak[MICO_MEM_N_KINDS], t);
+    #ifdef MICO_MEM
+    __mem_region_update(0);
+    #endif
+}
+
+static void __mem_sub(const int kind, const size_t bytes){
+    __MEM_SUB(&mem_current[kind], bytes);
+    __MEM_SUB(&mem_current[MICO_MEM_N_KINDS], bytes);
+}
+
+void* MiCo_alloc_kind(const size_t size, const int align, const int kind){
+    size_t a = (align > 0) ? (size_t)align : MICO_MEM_MIN_ALIGN;
+    if (a < MICO_MEM_MIN_ALIGN) a = MICO_MEM_MIN_ALIGN;
+    // require power-of-two alignment
+    if ((a & (a - 1)) != 0) return NULL;
+
+    // extra space for alignment padding + the header
+    void *raw = malloc(size + a - 1 + sizeof(__mem_header));
+    if (!raw) return NULL;
+
+    uintptr_t addr = (uintptr_t)raw + sizeof(__mem_header);
+    uintptr_t aligned_addr = (addr + (a - 1)) & ~(uintptr_t)(a - 1);
+    __mem_header* h = (__mem_header*)aligned_addr - 1;
+    h->raw = raw;
+    h->size = size;
+    h->kind = kind;
+    __mem_add(kind, size);
+    return (void*)aligned_addr;
+}
+
+void* MiCo_alloc(const size_t size, const int align){
+    if (size == 0) return NULL;
+    return MiCo_alloc_kind(size, align, MICO_MEM_WORKSPACE);
+}
+
+void* MiCo_malloc(const size_t size){
+    return MiCo_alloc_kind(size, 0, MICO_MEM_WORKSPACE);
+}
+
+void* MiCo_calloc(const size_t count, const size_t size){
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+    uint8_t* p = MiCo_alloc_kind(count * size, 0, MICO_MEM_WORKSPACE);
+    if (p != NULL) memset(p, 0, count * size);
+    return p;
+}
+
+void MiCo_free(void *ptr){
+    if (!ptr) return;
+    const __mem_header* h = (const __mem_header*)ptr - 1;
+    __mem_sub(h->kind, h->size);
+    free(h->raw);
+}
+
+void MiCo_mem_register(const int kind, const size_t bytes){
+    __mem_add(kind, bytes);
+}
+
+void MiCo_mem_release(const int kind, const size_t bytes){
+    __mem_sub(kind, bytes);
+}
+
+size_t MiCo_mem_current(const int kind){
+    return mem_current[kind];
+}
+
+size_t MiCo_mem_peak(const int kind){
+    return mem_peak[kind];
+}
+
+void MiCo_mem_qbuffer_use(const size_t bytes){
+    __mem_raise_peak(&mem_qbuffer_peak, bytes);
+    #ifdef MICO_MEM
+    __mem_region_update(bytes);
+    #endif
+}
+
+size_t MiCo_mem_qbuffer_peak(){
+    return mem_qbuffer_peak;
+}
+
+// Fill the stack below the caller with a pattern; MiCo_mem_stack_peak
+// later finds the deepest byte that was overwritten.
+__attribute__((noinline)) void MiCo_mem_stack_paint(const size_t bytes){
+    volatile uint8_t* p = __builtin_alloca(bytes);
+    for (size_t i = 0; i < bytes; i++){
+        p[i] = MICO_MEM_STACK_FILL;
+    }
+    mem_stack_lo = p;
+    mem_stack_hi = (uint8_t*)__builtin_frame_address(0);
+}
+
+size_t MiCo_mem_stack_peak(){
+    if (mem_stack_lo == NULL) return 0;
+    volatile uint8_t* p = mem_stack_lo;
+    while (p < mem_stack_hi && *p == MICO_MEM_STACK_FILL) p++;
+    return (size_t)(mem_stack_hi - (uint8_t*)p);
+}
+
+void MiCo_mem_reset_peak(){
+    for (int k = 0; k <= MICO_MEM_N_KINDS; k++){
+        mem_peak[k] = mem_current[k];
+    }
+    mem_qbuffer_peak = 0;
+}
+
+#ifdef MICO_MEM
+
+#define MICO_MEM_MAX_DEPTH 64
+
+typedef struct {
+    const char* name;
+    size_t entry[MICO_MEM_N_KINDS + 1];
+    size_t peak[MICO_MEM_N_KINDS + 1];  // above entry
+    size_t qbuffer;
+} __mem_frame;
+
+static MiCo_Mem_Layer mem_layers[MICO_MEM_MAX_LAYERS];
+static int mem_n_layers = 0;
+static __mem_frame mem_stack[MICO_MEM_MAX_DEPTH];
+static int mem_depth = 0;
+
+// Regions are tracked on the thread that opened the first one; kernels
+// allocating on worker threads still count towards the open regions.
+#ifdef USE_HOST
+static __thread int mem_owner = 0;
+static int mem_has_owner = 0;
+#else
+static int mem_owner = 1;
+#endif
+
+// Also called from worker threads, so the peaks are raised atomically
+static void __mem_region_update(const size_t qbuffer){
+    for (int d = 0; d < mem_depth && d < MICO_MEM_MAX_DEPTH; d++){
+        __mem_frame* f = &mem_stack[d];
+        for (int k = 0; k <= MICO_MEM_N_KINDS; k++){
+            const size_t c = mem_current[k];
+            if (c > f->entry[k]) __mem_raise_peak(&f->peak[k], c - f->entry[k]);
+        }
+        __mem_raise_peak(&f->qbuffer, qbuffer);
+    }
+}
+
+static int __mem_streq(const char* a, const char* b){
+    while (*a && *a == *b){
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+void __MiCo_mem_begin(const char* name){
+    #ifdef USE_HOST
+    if (!mem_owner){
+        if (__atomic_exchange_n(&mem_has_owner, 1, __ATOMIC_RELAXED)) return;
+        mem_owner = 1;
+    }
+    #endif
+    if (mem_depth < MICO_MEM_MAX_DEPTH){
+        __mem_frame* f = &mem_stack[mem_depth];
+        f->name = name;
+        for (int k = 0; k <= MICO_MEM_N_KINDS; k++){
+            f->entry[k] = mem_current[k];
+            f->peak[k] = 0;
+        }
+        f->qbuffer = 0;
+    }
+    mem_depth++;
+}
+
+void __MiCo_mem_end(){
+    if (!mem_owner || mem_depth == 0) return;
+    mem_depth--;
+    if (mem_depth >= MICO_MEM_MAX_DEPTH) return;
+    const __mem_frame* f = &mem_stack[mem_depth];
+    int i = 0;
+    while (i < mem_n_layers && mem_layers[i].name != f->name &&
+        !__mem_streq(mem_layers[i].name, f->name)) i++;
+    if (i == mem_n_layers){
+        if (mem_n_layers == MICO_MEM_MAX_LAYERS) return;
+        memset(&mem_layers[i], 0, sizeof(MiCo_Mem_Layer));
+        mem_layers[i].name = f->name;
+        mem_n_layers++;
+    }
+    MiCo_Mem_Layer* l = &mem_layers[i];
+    l->calls++;
+    for (int k = 0; k <= MICO_MEM_N_KINDS; k++){
+        if (f->peak[k] > l->peak[k]) l->peak[k] = f->peak[k];
+    }
+    if (f->qbuffer > l->qbuffer) l->qbuffer = f->qbuffer;
+}
+
+int MiCo_mem_layers(const MiCo_Mem_Layer** layers){
+    *layers = mem_layers;
+    return mem_n_layers;
+}
+
+void MiCo_mem_reset_layers(){
+    mem_n_layers = 0;
+}
+
+#else
+
+void __MiCo_mem_begin(const char* name){
+    (void)name;
+}
+
+void __MiCo_mem_end(){
+}
+
+int MiCo_mem_layers(const MiCo_Mem_Layer** layers){
+    *layers = NULL;
+    return 0;
+}
+
+void MiCo_mem_reset_layers(){
+}
+
+#endif // MICO_MEM
+
+void MiCo_mem_print_report(){
+    printf("[Mem] %-12s %12s %12s\n", "kind", "current", "peak");
+    for (int k = 0; k < MICO_MEM_N_KINDS; k++){
+        printf("[Mem] %-12s %12lu %12lu\n", mem_kind_names[k],
+            (unsigned long)mem_current[k], (unsigned long)mem_peak[k]);
+    }
+    printf("[Mem] %-12s %12lu %12lu\n", "total",
+        (unsigned long)mem_current[MICO_MEM_N_KINDS], (unsigned long)mem_peak[MICO_MEM_N_KINDS]);
+    printf("[Mem] QBuffer peak: %lu of QUANTIZE_BUFFER_SIZE=%lu bytes\n",
+        (unsigned long)mem_qbuffer_peak, (unsigned long)QUANTIZE_BUFFER_SIZE);
+    if (mem_stack_lo != NULL){
+        printf("[Mem] stack peak: %lu bytes\n", (unsigned long)MiCo_mem_stack_peak());
+    }
+
+    const MiCo_Mem_Layer* layers;
+    const int n = MiCo_mem_layers(&layers);
+    if (n == 0) return;
+    printf("[Mem] per region, bytes allocated above entry (peak over calls):\n");
+    printf("[Mem] %-34s %8s %10s %10s %10s %10s %10s\n", "region", "calls",
+        "act", "workspace", "kv_cache", "total", "qbuffer");
+    for (int i = 0; i < n; i++){
+        const MiCo_Mem_Layer* l = &layers[i];
+        printf("[Mem] %-34s %8lu %10lu %10lu %10lu %10lu %10lu\n", l->name,
+            (unsigned long)l->calls,
+            (unsigned long)l->peak[MICO_MEM_ACT], (unsigned long)l->peak[MICO_MEM_WORKSPACE],
+            (unsigned long)l->peak[MICO_MEM_KV], (unsigned long)l->peak[MICO_MEM_N_KINDS],
+            (unsigned long)l->qbuffer);
+    }
+}
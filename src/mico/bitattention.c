@@ -0,0 +1,158 @@
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include "mico_quant.h"
+#include "mico_runtime.h"
+
+extern long QMATMUL_TIMER;
+extern long QUANT_TIMER;
+extern long ATTN_TIMER;
+
+extern MiCoRuntime MiCo_runtime;
+
+// Quantized ViT attention on the mixed-precision MatMul table.
+// For every (batch, head):
+//   S = Q(aq) . K(kq)^T          -> matmul_matrix[aq][kq], [I, J]
+//   P = softmax(S * sQ * sK / scale)
+//   O = P(8) . (V^T)(vq)^T       -> matmul_matrix[8][vq],  [I, F]
+// V is transposed so both products use the (activation, weight) row-major
+// layout of the MatMul kernels. Reduction dims are zero-padded to align,
+// so any SIMD / LUT / accelerator backend in the table applies.
+void MiCo_bitattention_f32(
+    Tensor4D_F32 *y,
+    const Tensor4D_F32 *q,
+    const Tensor4D_F32 *k,
+    const Tensor4D_F32 *v,
+    const float scale,
+    const qtype aq, const qtype kq, const qtype vq,
+    const size_t align
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitattention_f32");
+    const size_t B = q->shape[0];
+    const size_t H = q->shape[1];
+    const size_t I = q->shape[2];
+    const size_t F = q->shape[3];
+    const size_t J = k->shape[2];
+
+    MiCo_assert(k->shape[0] == B && k->shape[1] == H && k->shape[3] == F, "[BitAttention] k shape mismatch");
+    MiCo_assert(v->shape[0] == B && v->shape[1] == H && v->shape[2] == J && v->shape[3] == F, "[BitAttention] v shape mismatch");
+    MiCo_assert(y->shape[0] == B && y->shape[1] == I && y->shape[2] == H && y->shape[3] == F, "[BitAttention] y shape mismatch");
+    MiCo_assert(scale != 0.0f, "[BitAttention] scale must be non-zero");
+    MiCo_assert(aq <= 8 && kq <= 8 && vq <= 8, "[BitAttention] Unsupported Quantization Type");
+    #ifdef USE_ALT_LAYOUT
+    MiCo_assert(0, "[BitAttention] N,K x K,M layout is not supported");
+    #endif
+
+    const size_t Fa = (F + align - 1) / align * align;
+    const size_t Ja = (J + align - 1) / align * align;
+    const size_t O_size = I * (J > F ? J : F);
+
+    // Zero-padded FP32 staging buffers, pads stay zero across heads
+    float *qf = (float *)MiCo_calloc(I * Fa, sizeof(float));
+    float *kf = (float *)MiCo_calloc(J * Fa, sizeof(float));
+    float *vt = (float *)MiCo_calloc(F * Ja, sizeof(float));
+    float *pf = (float *)MiCo_calloc(I * Ja, sizeof(float));
+    // Quantized buffers, sized for the 8-bit worst case
+    qbyte *qq = (qbyte *)MiCo_malloc(I * Fa);
+    qbyte *qk = (qbyte *)MiCo_malloc(J * Fa);
+    qbyte *qv = (qbyte *)MiCo_malloc(F * Ja);
+    qbyte *qp = (qbyte *)MiCo_malloc(I * Ja);
+    int32_t *qO = (int32_t *)MiCo_malloc(O_size * sizeof(int32_t));
+    MiCo_assert(qf != NULL && kf != NULL && vt != NULL && pf != NULL &&
+                qq != NULL && qk != NULL && qv != NULL && qp != NULL && qO != NULL,
+                "[BitAttention] failed to allocate buffers");
+
+    Tensor2D_F32 Qf = { .shape = {I, Fa}, .data = qf };
+    Tensor2D_F32 Kf = { .shape = {J, Fa}, .data = kf };
+    Tensor2D_F32 Vt = { .shape = {F, Ja}, .data = vt };
+    Tensor2D_F32 Pf = { .shape = {I, Ja}, .data = pf };
+    Tensor2D_Q8 Qq = { .shape = {I, Fa}, .data = qq };
+    Tensor2D_Q8 Kq = { .shape = {J, Fa}, .data = qk };
+    Tensor2D_Q8 Vq = { .shape = {F, Ja}, .data = qv };
+    Tensor2D_Q8 Pq = { .shape = {I, Ja}, .data = qp };
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    long start;
+
+    for (size_t b = 0; b < B; b++){
+        for (size_t h = 0; h < H; h++){
+            const float *qbh = q->data + ((b * H + h) * I) * F;
+            const float *kbh = k->data + ((b * H + h) * J) * F;
+            const float *vbh = v->data + ((b * H + h) * J) * F;
+
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
+            for (size_t i = 0; i < I; i++){
+                memcpy(qf + i * Fa, qbh + i * F, F * sizeof(float));
+            }
+            for (size_t j = 0; j < J; j++){
+                memcpy(kf + j * Fa, kbh + j * F, F * sizeof(float));
+                for (size_t f = 0; f < F; f++){
+                    vt[f * Ja + j] = vbh[j * F + f];
+                }
+            }
+            // staging rows are already padded, so no further alignment
+            MiCo_2D_quant_act(&Qq, &Qf, aq, 1);
+            MiCo_2D_quant_act(&Kq, &Kf, kq, 1);
+            MiCo_2D_quant_act(&Vq, &Vt, vq, 1);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QUANT_TIMER += MiCo_time() - start;
+
+            // S = Q . K^T; the MatMul kernels accumulate into qO
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+            memset(qO, 0, I * J * sizeof(int32_t));
+            MiCo_runtime.matmul_matrix[qlog(aq)][qlog(kq)](qO, &Qq, &Kq);
+            MiCo_PERF_MACS(I * Fa * J);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QMATMUL_TIMER += MiCo_time() - start;
+
+            const float s_scale = Qq.scale * Kq.scale / scale;
+            for (size_t i = 0; i < I; i++){
+                float *pi = pf + i * Ja;
+                for (size_t j = 0; j < J; j++){
+                    pi[j] = (float)qO[i * J + j] * s_scale;
+                }
+                MiCo_softmax_f32(pi, pi, J);
+            }
+
+            // O = P . V
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
+            MiCo_2D_quant_act(&Pq, &Pf, 8, 1);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QUANT_TIMER += MiCo_time() - start;
+
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+            memset(qO, 0, I * F * sizeof(int32_t));
+            MiCo_runtime.matmul_matrix[qlog(8)][qlog(vq)](qO, &Pq, &Vq);
+            MiCo_PERF_MACS(I * Ja * F);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QMATMUL_TIMER += MiCo_time() - start;
+
+            const float o_scale = Pq.scale * Vq.scale;
+            for (size_t i = 0; i < I; i++){
+                float *yi = y->data + ((b * I + i) * H + h) * F;
+                for (size_t f = 0; f < F; f++){
+                    yi[f] = (float)qO[i * F + f] * o_scale;
+                }
+            }
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("bitattention_f32", 2 * B * H * I * J * F, aq, kq,
+        4 * B * H * (2 * I * F + 2 * J * F));
+
+    MiCo_free(qf);
+    MiCo_free(kf);
+    MiCo_free(vt);
+    MiCo_free(pf);
+    MiCo_free(qq);
+    MiCo_free(qk);
+    MiCo_free(qv);
+    MiCo_free(qp);
+    MiCo_free(qO);
+}
@@ -61,6 +61,7 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
     const qtype wq, const qtype aq,
     const size_t stride, const size_t padding, 
     const size_t dilation, const size_t groups, const size_t align){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitconv1d_f32");
 
     const size_t batch_size = x->shape[0];
 
@@ -80,6 +81,7 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
 
     const size_t in_c_per_group = in_c / groups;
     const size_t out_c_per_group = out_c / groups;
+    MiCo_ROOFLINE_BEGIN();
 
     size_t b_addr, c_addr;
 
@@ -116,11 +118,12 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
     // Calculate memory requirements for one block
     size_t block_out_size = block_elements;
 
-    float* col = malloc(in_c_per_group * k_l * block_out_size * sizeof(float));
-    int32_t *qO = malloc(out_c_per_group * block_out_size * sizeof(int32_t));
+    float* col = MiCo_malloc(in_c_per_group * k_l * block_out_size * sizeof(float));
+    int32_t *qO = MiCo_malloc(out_c_per_group * block_out_size * sizeof(int32_t));
 
     size_t qx_size = aligned_size * block_out_size * sizeof(qbyte);
     qx_size /= (8 / aq); // Num of Act per Byte
+    MiCo_mem_qbuffer_use(qx_size);
     MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
     qbyte* qx_data = MiCo_QBuffer;
 
@@ -135,6 +138,7 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
                 size_t current_block_elements = (elem_offset + block_elements <= out_l) ? block_elements : out_l - elem_offset;
                 
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "im2col");
                 // Partial im2col on the current group
                 im2col_block_1d_T(img_group, in_c_per_group, in_l, k_l, stride, padding, 
                               col, elem_offset, current_block_elements, out_l);
@@ -150,11 +154,14 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
                 qx.shape[1] = aligned_size;
                 qx.scale = 0.0f; // To be calculated later
 
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 IM2COL_TIMER += MiCo_time() - start;
                 
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
                 // Activation Quantization for the current block
                 MiCo_2D_quant(&qx, &x_col, aq);
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QUANT_TIMER += MiCo_time() - start;
 
                 // Get the weights for the current group
@@ -172,7 +179,10 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
                 
                 // MatMul-Based Convolution for the current block
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
                 MiCo_runtime.matmul_matrix[qlog(wq)][qlog(aq)](qO, &qw, &qx);
+                MiCo_PERF_MACS(qw.shape[0] * qw.shape[1] * qx.shape[0]);
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QMATMUL_TIMER += MiCo_time() - start;
 
                 // Calculate output position for this block
@@ -182,6 +192,7 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
                 
                 float scale = weight->scale * qx.scale;
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
                 // De-Quantization for the current block
                 for (size_t oc = 0; oc < out_c_per_group; oc++) {
                     for (size_t j = 0; j < current_block_elements; j++) {
@@ -190,10 +201,183 @@ void MiCo_bitconv1d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
                         y->data[y_idx] += (float)qO[qo_idx] * scale;
                     }
                 }
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QUANT_TIMER += MiCo_time() - start;
             }
         }
     }
-    free(qO);
-    free(col);
+    MiCo_free(qO);
+    MiCo_free(col);
+    MiCo_ROOFLINE_END("bitconv1d_f32", batch_size * out_c * out_l * in_c_per_group * k_l, aq, wq,
+        batch_size * in_c * in_l * 4 + MICO_RL_BYTES(out_c * in_c_per_group * k_l, wq) +
+        batch_size * out_c * out_l * 4);
+}
+
+// Streaming 1D Convolution
+// A stream keeps the last (kernel - 1) * dilation input frames of one
+// layer and the stride phase, so every push of new frames computes only
+// the output frames that became available. The outputs are the same
+// frames a full "valid" (no padding) convolution over the concatenated
+// input would produce, and y of one layer can be pushed to the next.
+
+void MiCo_conv1d_stream_init(MiCo_Conv1D_Stream *s, const size_t channels,
+    const size_t kernel, const size_t stride, const size_t dilation,
+    const size_t max_hop){
+    MiCo_assert(kernel > 0 && stride > 0 && dilation > 0, "[Conv1D-Stream] invalid geometry");
+    s->channels = channels;
+    s->kernel = kernel;
+    s->stride = stride;
+    s->dilation = dilation;
+    s->hist = (kernel - 1) * dilation;
+    s->max_hop = max_hop;
+    s->buf = MiCo_alloc_kind(channels * (s->hist + max_hop) * sizeof(float), 0, MICO_MEM_ACT);
+    MiCo_assert(s->buf != NULL, "[Conv1D-Stream] failed to allocate buffer");
+    MiCo_conv1d_stream_reset(s);
+}
+
+void MiCo_conv1d_stream_reset(MiCo_Conv1D_Stream *s){
+    s->len = 0;
+    s->skip = 0;
+}
+
+void MiCo_conv1d_stream_free(MiCo_Conv1D_Stream *s){
+    MiCo_free(s->buf);
+    s->buf = NULL;
+}
+
+// Push x [1, C, T] new frames, T <= max_hop. y [1, out_c, cap] receives the
+// new output frames; on return y->shape[2] is their count (possibly 0).
+size_t MiCo_bitconv1d_stream_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
+    MiCo_Conv1D_Stream *s, const Tensor3D_Q8 *weight, const Tensor1D_F32 *bias,
+    const qtype wq, const qtype aq, const size_t groups, const size_t align){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitconv1d_stream_f32");
+
+    const size_t in_c = s->channels;
+    const size_t T = x->shape[2];
+    const size_t cap = s->hist + s->max_hop;
+    const size_t k_l = s->kernel;
+    const size_t out_c = y->shape[1];
+
+    MiCo_assert(x->shape[0] == 1 && y->shape[0] == 1, "[Conv1D-Stream] batch must be 1");
+    MiCo_assert(x->shape[1] == in_c, "[Conv1D-Stream] channel mismatch");
+    MiCo_assert(T <= s->max_hop, "[Conv1D-Stream] hop exceeds max_hop");
+    MiCo_assert(weight->shape[2] == k_l, "[Conv1D-Stream] kernel mismatch");
+    MiCo_assert(in_c % groups == 0 && out_c % groups == 0, "[Conv1D-Stream] Group Mismatched!");
+    MiCo_ROOFLINE_BEGIN();
+
+    long start = MiCo_time();
+    // Append the new frames after the kept history
+    for (size_t c = 0; c < in_c; c++){
+        memcpy(s->buf + c * cap + s->len, x->data + c * T, T * sizeof(float));
+    }
+    const size_t L = s->len + T;
+
+    // Output starts at skip, skip + stride, ... while the window fits
+    size_t n_out = 0;
+    if (L > s->skip + s->hist){
+        n_out = (L - s->skip - s->hist - 1) / s->stride + 1;
+    }
+    MiCo_assert(n_out <= y->shape[2], "[Conv1D-Stream] output capacity exceeded");
+
+    const size_t in_c_per_group = in_c / groups;
+    const size_t out_c_per_group = out_c / groups;
+    const size_t aligned_size = (in_c_per_group * k_l + align - 1) / align * align;
+
+    if (n_out > 0){
+        float* col = MiCo_malloc(n_out * in_c_per_group * k_l * sizeof(float));
+        int32_t* qO = MiCo_malloc(out_c_per_group * n_out * sizeof(int32_t));
+        MiCo_assert(col != NULL && qO != NULL, "[Conv1D-Stream] failed to allocate buffers");
+
+        size_t qx_size = aligned_size * n_out * sizeof(qbyte);
+        qx_size /= (8 / aq); // Num of Act per Byte
+        MiCo_mem_qbuffer_use(qx_size);
+        MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
+        IM2COL_TIMER += MiCo_time() - start;
+
+        for (size_t g = 0; g < groups; g++){
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "im2col");
+            // Dilated im2col of the new output frames only
+            for (size_t o = 0; o < n_out; o++){
+                const size_t p = s->skip + o * s->stride;
+                for (size_t c = 0; c < in_c_per_group; c++){
+                    const float* src = s->buf + (g * in_c_per_group + c) * cap + p;
+                    float* dst = col + (o * in_c_per_group + c) * k_l;
+                    for (size_t kl = 0; kl < k_l; kl++){
+                        dst[kl] = src[kl * s->dilation];
+                    }
+                }
+            }
+            Tensor2D_F32 x_col;
+            x_col.data = col;
+            x_col.shape[0] = n_out;
+            x_col.shape[1] = in_c_per_group * k_l;
+
+            Tensor2D_Q8 qx;
+            qx.data = MiCo_QBuffer;
+            qx.shape[0] = n_out;
+            qx.shape[1] = aligned_size;
+            qx.scale = 0.0f;
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            IM2COL_TIMER += MiCo_time() - start;
+
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
+            MiCo_2D_quant(&qx, &x_col, aq);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QUANT_TIMER += MiCo_time() - start;
+
+            Tensor2D_Q8 qw;
+            qw.data = weight->data + (g * out_c_per_group * aligned_size) / (8 / wq);
+            qw.shape[0] = out_c_per_group;
+            qw.shape[1] = aligned_size;
+            qw.scale = weight->scale;
+
+            for (size_t i = 0; i < out_c_per_group * n_out; i++){
+                qO[i] = 0;
+            }
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+            MiCo_runtime.matmul_matrix[qlog(wq)][qlog(aq)](qO, &qw, &qx);
+            MiCo_PERF_MACS(qw.shape[0] * qw.shape[1] * qx.shape[0]);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QMATMUL_TIMER += MiCo_time() - start;
+
+            // y is written densely as [out_c, n_out] so it chains
+            const float scale = weight->scale * qx.scale;
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
+            for (size_t oc = 0; oc < out_c_per_group; oc++){
+                const size_t oc_g = g * out_c_per_group + oc;
+                const float bias_oc = bias->shape[0] == 0 ? 0.f : bias->data[oc_g];
+                for (size_t j = 0; j < n_out; j++){
+                    y->data[oc_g * n_out + j] = bias_oc + (float)qO[oc * n_out + j] * scale;
+                }
+            }
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QUANT_TIMER += MiCo_time() - start;
+        }
+        MiCo_free(col);
+        MiCo_free(qO);
+        start = MiCo_time();
+    }
+    y->shape[2] = n_out;
+
+    // Keep the frames still needed by future outputs (at most hist)
+    const size_t next = s->skip + n_out * s->stride;
+    if (next <= L){
+        const size_t keep = L - next;
+        for (size_t c = 0; c < in_c; c++){
+            memmove(s->buf + c * cap, s->buf + c * cap + next, keep * sizeof(float));
+        }
+        s->len = keep;
+        s->skip = 0;
+    } else {
+        s->len = 0;
+        s->skip = next - L;
+    }
+    IM2COL_TIMER += MiCo_time() - start;
+    MiCo_ROOFLINE_END("bitconv1d_stream_f32", n_out * out_c * (in_c / groups) * k_l, aq, wq,
+        in_c * T * 4 + MICO_RL_BYTES(out_c * (in_c / groups) * k_l, wq) + out_c * n_out * 4);
+    return n_out;
 }
@@ -11,12 +11,19 @@ extern long IM2COL_TIMER;
 
 extern MiCoRuntime MiCo_runtime;
 
+// Output rows per im2col block; tune for the data cache
+// (doc/Survey_On_Im2Col_Blocks.md, CACHESIM=1 to model it on host)
+#ifndef MICO_IM2COL_BLOCK_ROWS
+#define MICO_IM2COL_BLOCK_ROWS 2
+#endif
+
 // TODO: Maybe we have too many arguments here
 __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const Tensor4D_Q8 *weight, const Tensor1D_F32 *bias, 
     const qtype wq, const qtype aq,
     const size_t stride, const size_t padding, 
     const size_t dilation, const size_t groups, const size_t align){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitconv2d_f32");
 
     const size_t batch_size = x->shape[0];
 
@@ -69,6 +76,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
 
     const size_t in_c_per_group = in_c / groups;
     const size_t out_c_per_group = out_c / groups;
+    MiCo_ROOFLINE_BEGIN();
 
     size_t b_addr, h_addr;
     #ifndef USE_ALT_LAYOUT
@@ -126,26 +134,27 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
     }
     
     // Define block size for partial im2col (process this many output rows at a time)
-    const size_t block_rows = 2;  // Can be tuned based on cache size and input dimensions
+    const size_t block_rows = MICO_IM2COL_BLOCK_ROWS;
     
     // Calculate memory requirements for one block
     size_t block_out_size = block_rows * out_w;
 
 
-    float* col = malloc(in_c_per_group * kernel_size * block_out_size * sizeof(float));
-    int32_t *qO = malloc(out_c_per_group * block_out_size * sizeof(int32_t));
+    float* col = MiCo_malloc(in_c_per_group * kernel_size * block_out_size * sizeof(float));
+    int32_t *qO = MiCo_malloc(out_c_per_group * block_out_size * sizeof(int32_t));
     
     #ifdef USE_ALT_LAYOUT
     // Allocate temp buffer for weight reordering in grouped convolution
     qbyte* temp_weight = NULL;
     if (groups > 1) {
-        temp_weight = malloc(aligned_size * out_c_per_group * sizeof(qbyte));
+        temp_weight = MiCo_malloc(aligned_size * out_c_per_group * sizeof(qbyte));
         MiCo_assert(temp_weight != NULL, "Failed to allocate temp_weight buffer");
     }
     #endif
 
     size_t qx_size = aligned_size * block_out_size * sizeof(qbyte);
     qx_size /= (8 / aq); // Num of Act per Byte
+    MiCo_mem_qbuffer_use(qx_size);
     MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
     qbyte* qx_data = MiCo_QBuffer;
 
@@ -169,6 +178,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                 size_t current_block_out_size = current_block_rows * out_w;
                 
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "im2col");
                 // Partial im2col on the current group - only process the needed rows
                 #ifdef USE_ALT_LAYOUT
                 // Use NHWC im2col for NHWC input layout
@@ -193,11 +203,14 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                 qx.shape[1] = aligned_size;
                 qx.scale = 0.0f; // To be calculated later
 
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 IM2COL_TIMER += MiCo_time() - start;
                 
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
                 // Activation Quantization for the current block
                 MiCo_2D_quant(&qx, &x_col, aq);
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QUANT_TIMER += MiCo_time() - start;
                 // printf("Quant Speed: %ld\n", MiCo_time() - start);
 
@@ -263,6 +276,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                 // TODO: Handle VLEN ?
                 // MatMul-Based Convolution for the current block
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
                 #ifdef USE_ALT_LAYOUT
                 // For NHWC: qx (activation) is first arg, qw (weight) is second
                 // Index order: [first_tensor_bits][second_tensor_bits]
@@ -271,6 +285,8 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                 // For NCHW: qw (weight) is first arg, qx (activation) is second
                 MiCo_runtime.matmul_matrix[qlog(wq)][qlog(aq)](qO, &qw, &qx);
                 #endif
+                MiCo_PERF_MACS(qw.shape[0] * qw.shape[1] * qx.shape[0]);
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QMATMUL_TIMER += MiCo_time() - start;
 
                 #ifdef USE_ALT_LAYOUT
@@ -279,6 +295,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                 // We need to write to y at positions (b, row_offset+h, w, g*out_c_per_group + oc)
                 float scale = weight->scale * qx.scale;
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
                 for (size_t j = 0; j < current_block_out_size; j++) {
                     size_t h_out = row_offset + (j / out_w);
                     size_t w_out = j % out_w;
@@ -288,6 +305,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                         y->data[y_base + oc] += (float)qO[qo_idx] * scale;
                     }
                 }
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QUANT_TIMER += MiCo_time() - start;
                 #else
                 // NCHW output layout
@@ -298,6 +316,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                 
                 float scale = weight->scale * qx.scale;
                 start = MiCo_time();
+                MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
                 // De-Quantization for the current block
                 for (size_t oc = 0; oc < out_c_per_group; oc++) {
                     for (size_t j = 0; j < current_block_out_size; j++) {
@@ -306,6 +325,7 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
                         y->data[y_idx] += (float)qO[qo_idx] * scale;
                     }
                 }
+                MiCo_TRACE_END(MICO_TRACE_PHASE);
                 QUANT_TIMER += MiCo_time() - start;
                 #endif
                 // printf("DeQuant Speed: %ld\n", MiCo_time() - start);
@@ -314,9 +334,101 @@ __attribute__((weak)) void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F3
     }
     #ifdef USE_ALT_LAYOUT
     if (temp_weight != NULL) {
-        free(temp_weight);
+        MiCo_free(temp_weight);
     }
     #endif
-    free(qO);
-    free(col);
+    MiCo_free(qO);
+    MiCo_free(col);
+    MiCo_ROOFLINE_END("bitconv2d_f32",
+        batch_size * out_c * out_h * out_w * in_c_per_group * kernel_size, aq, wq,
+        batch_size * in_c * in_h * in_w * 4 +
+        MICO_RL_BYTES(out_c * in_c_per_group * kernel_size, wq) +
+        batch_size * out_c * out_h * out_w * 4);
+}
+
+// 1x1 (pointwise, stride 1, no padding) convolution on a pre-quantized
+// activation handle from MiCo_4D_quant_act_pw, so branches that share an
+// input (Inception, residual projections) quantize it only once.
+void MiCo_bitconv2d_pw_q_f32(Tensor4D_F32 *y, const Tensor2D_Q8 *qx,
+    const Tensor4D_Q8 *weight, const Tensor1D_F32 *bias, const qtype wq){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitconv2d_pw_q_f32");
+
+    const qtype aq = qx->wq;
+    const size_t batch_size = y->shape[0];
+    #ifdef USE_ALT_LAYOUT
+    const size_t out_size = y->shape[1] * y->shape[2];
+    const size_t out_c = y->shape[3];
+    MiCo_assert(weight->shape[0] == 1 && weight->shape[1] == 1,
+        "[BitConv2D-PW] kernel must be 1x1");
+    MiCo_assert(wq == 8 && aq == 8,
+        "[BitConv2D-PW] NHWC currently only support 8-bit quantization!");
+    #else
+    const size_t out_c = y->shape[1];
+    const size_t out_size = y->shape[2] * y->shape[3];
+    MiCo_assert(weight->shape[2] == 1 && weight->shape[3] == 1,
+        "[BitConv2D-PW] kernel must be 1x1");
+    #endif
+    MiCo_assert(qx->shape[0] == batch_size * out_size,
+        "[BitConv2D-PW] activation rows mismatch");
+    MiCo_assert(qx->shape[1] * aq % 8 == 0, "[BitConv2D-PW] rows must be byte aligned");
+
+    const size_t row_bytes = qx->shape[1] * aq / 8;
+    long start;
+    MiCo_ROOFLINE_BEGIN();
+
+    Tensor2D_Q8 qw;
+    qw.data = weight->data;
+    qw.scale = weight->scale;
+    qw.wq = wq;
+    #ifdef USE_ALT_LAYOUT
+    qw.shape[0] = qx->shape[1];
+    qw.shape[1] = out_c;
+    #else
+    qw.shape[0] = out_c;
+    qw.shape[1] = qx->shape[1];
+    #endif
+
+    int32_t *qO = MiCo_malloc(out_c * out_size * sizeof(int32_t));
+    MiCo_assert(qO != NULL, "[BitConv2D-PW] failed to allocate buffer");
+    const float scale = weight->scale * qx->scale;
+
+    for (size_t b = 0; b < batch_size; b++){
+        Tensor2D_Q8 qx_b = *qx;
+        qx_b.shape[0] = out_size;
+        qx_b.data = qx->data + b * out_size * row_bytes;
+
+        for (size_t i = 0; i < out_c * out_size; i++){
+            qO[i] = 0;
+        }
+        start = MiCo_time();
+        MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+        #ifdef USE_ALT_LAYOUT
+        MiCo_runtime.matmul_matrix[qlog(aq)][qlog(wq)](qO, &qx_b, &qw);
+        #else
+        MiCo_runtime.matmul_matrix[qlog(wq)][qlog(aq)](qO, &qw, &qx_b);
+        #endif
+        MiCo_PERF_MACS(qw.shape[0] * qw.shape[1] * qx_b.shape[0]);
+        MiCo_TRACE_END(MICO_TRACE_PHASE);
+        QMATMUL_TIMER += MiCo_time() - start;
+
+        // qO matches the output layout of one image: [out_c, HW] or [HW, out_c]
+        start = MiCo_time();
+        MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
+        float *yb = y->data + b * out_c * out_size;
+        for (size_t i = 0; i < out_c * out_size; i++){
+            #ifdef USE_ALT_LAYOUT
+            const size_t oc = i % out_c;
+            #else
+            const size_t oc = i / out_size;
+            #endif
+            const float bias_oc = bias->shape[0] == 0 ? 0.f : bias->data[oc];
+            yb[i] = bias_oc + (float)qO[i] * scale;
+        }
+        MiCo_TRACE_END(MICO_TRACE_PHASE);
+        QUANT_TIMER += MiCo_time() - start;
+    }
+    MiCo_free(qO);
+    MiCo_ROOFLINE_END("bitconv2d_pw_q_f32", qx->shape[0] * qx->shape[1] * out_c, aq, wq,
+        MICO_RL_BYTES(qx->shape[0] * qx->shape[1], aq) + MICO_RL_BYTES(out_c * qx->shape[1], wq) +
+        batch_size * out_c * out_size * 4);
 }
@@ -17,6 +17,7 @@ void MiCo_bitconv2d_f32_plain(Tensor4D_F32 *y, const Tensor4D_F32 *x,
     const qtype wq, const qtype aq,
     const size_t stride, const size_t padding, 
     const size_t dilation, const size_t groups){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitconv2d_f32_plain");
 
     size_t batch_size = x->shape[0];
 
@@ -43,6 +44,7 @@ void MiCo_bitconv2d_f32_plain(Tensor4D_F32 *y, const Tensor4D_F32 *x,
 
     size_t in_c_per_group = in_c / groups;
     size_t out_c_per_group = out_c / groups;
+    MiCo_ROOFLINE_BEGIN();
 
     size_t b_addr, c_addr, h_addr;
 
@@ -75,22 +77,25 @@ void MiCo_bitconv2d_f32_plain(Tensor4D_F32 *y, const Tensor4D_F32 *x,
     //     aligned_size = (in_c_per_group * kernel_size / 32 + 1) * 32;
     // }
 
-    float* col = malloc(in_c_per_group * kernel_size * out_h * out_w * sizeof(float));
-    int32_t *qO = malloc(out_c_per_group * out_size * sizeof(int32_t));
+    float* col = MiCo_malloc(in_c_per_group * kernel_size * out_h * out_w * sizeof(float));
+    int32_t *qO = MiCo_malloc(out_c_per_group * out_size * sizeof(int32_t));
 
     size_t qx_size = in_c_per_group * kernel_size * out_h * out_w * sizeof(qbyte);
     qx_size /= (8 / aq); // Num of Act per Byte
-    qbyte* qx_data = malloc(qx_size);
+    qbyte* qx_data = MiCo_malloc(qx_size);
 
     for (size_t b = 0; b < batch_size; b++){
         for (size_t g = 0; g < groups; g++) {
             // Get the input data for the current group
             float* img_group = x->data + (b * in_c * in_h * in_w) + (g * in_c_per_group * in_h * in_w);
             start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "im2col");
             // Perform im2col on the current group
             im2col_T(img_group, in_c_per_group, in_h, in_w, k_h, stride, padding, col);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
             IM2COL_TIMER += MiCo_time() - start;
             start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
             float qs = 0.0;
             switch (aq)
             {
@@ -110,6 +115,7 @@ void MiCo_bitconv2d_f32_plain(Tensor4D_F32 *y, const Tensor4D_F32 *x,
                     printf("[Warning] Unsupported Weight Quantization - %d\n", aq);
                 break;
             }
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
             QUANT_TIMER += MiCo_time() - start;
             
             Tensor2D_Q8 qx;
@@ -134,20 +140,30 @@ void MiCo_bitconv2d_f32_plain(Tensor4D_F32 *y, const Tensor4D_F32 *x,
             // MatMul-Based Convolution for the current group
             // TODO: Need Alignment!
             start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
             MiCo_runtime.matmul_matrix[qlog(wq)][qlog(aq)](qO, &qw, &qx);
+            MiCo_PERF_MACS(qw.shape[0] * qw.shape[1] * qx.shape[0]);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
             QMATMUL_TIMER += MiCo_time() - start;
 
             size_t group_addr = b * out_c * out_size + (g * out_c_per_group * out_size);
             float scale = weight->scale * qx.scale;
             start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
             // De-Quantization for the current group
             for (size_t j = 0; j < out_c_per_group * out_size; j++) {
                 y->data[group_addr + j] += (float)qO[j] * scale;
             }
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
             QUANT_TIMER += MiCo_time() - start;
         }
     }
-    free(qx_data);
-    free(qO);
-    free(col);
+    MiCo_free(qx_data);
+    MiCo_free(qO);
+    MiCo_free(col);
+    MiCo_ROOFLINE_END("bitconv2d_f32_plain",
+        batch_size * out_c * out_h * out_w * in_c_per_group * kernel_size, aq, wq,
+        batch_size * in_c * in_h * in_w * 4 +
+        MICO_RL_BYTES(out_c * in_c_per_group * kernel_size, wq) +
+        batch_size * out_c * out_h * out_w * 4);
 }
\ No newline at end of file
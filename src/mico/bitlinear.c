@@ -10,25 +10,25 @@ extern long QUANT_TIMER;
 
 extern MiCoRuntime MiCo_runtime;
 
-__attribute__((weak)) void MiCo_bitlinear_f32(
-    Tensor2D_F32 *y, const Tensor2D_F32 *x,
-    const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias,
-    const qtype wq, const qtype aq, const size_t align){
-
+// Shared by both entry points, which each open the layer region
+static void __bitlinear_q_f32(
+    Tensor2D_F32 *y, const Tensor2D_Q8 *qx,
+    const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias, const qtype wq){
+    const qtype aq = qx->wq;
     // Check qtype legality
     if (wq > 8 || aq > 8){
         printf("[Error] Unsupported Quantization Type\n");
         return;
     }
 
-    const size_t b = x->shape[0];
-    const size_t n = x->shape[1];
+    const size_t b = qx->shape[0];
     #ifdef USE_ALT_LAYOUT
     const size_t m = weight->shape[1];
     MiCo_assert(wq == 8 && aq == 8, "N,K x K,M layout only supports INT8 weights and activations");
     #else
     const size_t m = weight->shape[0];
     #endif
+    MiCo_ROOFLINE_BEGIN();
     
     // Address
     size_t baddr;
@@ -47,48 +47,174 @@ __attribute__((weak)) void MiCo_bitlinear_f32(
       }
     }
 
-    int32_t* qO = malloc(b*m*sizeof(int32_t));
+    int32_t* qO = MiCo_malloc(b*m*sizeof(int32_t));
     for (size_t i = 0; i < b * m; i++) {
         qO[i] = 0;
     }
 
-    const size_t align_factor = align;
-
-    const size_t aligned_size = (n + align_factor - 1) / align_factor * align_factor;
-    // Activation Quantization
-    Tensor2D_Q8 qx;
-    qx.shape[0] = b;
-    qx.shape[1] = aligned_size;
-
-    start = MiCo_time();
-    const size_t qx_size = b*aligned_size*sizeof(int8_t) / (8/aq);
-    MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
-    qx.data = MiCo_QX_Buffer_Global.buffer;
-    MiCo_2D_quant(&qx, x, aq);
-    QUANT_TIMER += MiCo_time() - start;
-    // printf("Quant Speed: %ld\n", MiCo_time() - start);
-
     // TODO: Maybe we should use Enum for aq and wq, so that we can skip qlog
     start = MiCo_time();
-    MiCo_runtime.matmul_matrix[qlog(aq)][qlog(wq)](qO, &qx, weight);
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+    MiCo_runtime.matmul_matrix[qlog(aq)][qlog(wq)](qO, qx, weight);
+    MiCo_PERF_MACS(b * qx->shape[1] * m);
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
     QMATMUL_TIMER += MiCo_time() - start;
     // printf("MatMul Speed: %ld\n", MiCo_time() - start);
 
-    float scale = weight->scale * qx.scale;
+    float scale = weight->scale * qx->scale;
     // De-Quantization (TODO: Heavy in FP32 operations)
     start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
     for (size_t i = 0; i < b; i++) {
       baddr = i * m;
       for (size_t j = 0; j < m; j++) {
           y->data[baddr + j] += (float)qO[baddr + j] * scale;
       }
     }
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
     QUANT_TIMER += MiCo_time() - start;
     // printf("DeQuant Speed: %ld\n", MiCo_time() - start);
     // printf("DeQuant Scale: %.4f\n", scale);
     
     // Free Quantized Memory
-    free(qO);
+    MiCo_free(qO);
+    MiCo_ROOFLINE_END("bitlinear_q_f32", b * qx->shape[1] * m, aq, wq,
+        MICO_RL_BYTES(b * qx->shape[1], aq) + MICO_RL_BYTES(m * qx->shape[1], wq) + b * m * 4);
+}
+
+// Bitlinear on a pre-quantized activation handle (see MiCo_2D_quant_act).
+// The activation bit-width is qx->wq; qx->shape[1] is the aligned size.
+void MiCo_bitlinear_q_f32(
+    Tensor2D_F32 *y, const Tensor2D_Q8 *qx,
+    const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias, const qtype wq){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitlinear_q_f32");
+    __bitlinear_q_f32(y, qx, weight, bias, wq);
+}
+
+__attribute__((weak)) void MiCo_bitlinear_f32(
+    Tensor2D_F32 *y, const Tensor2D_F32 *x,
+    const Tensor2D_Q8 *weight, const Tensor1D_F32 *bias,
+    const qtype wq, const qtype aq, const size_t align){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitlinear_f32");
+
+    // Check qtype legality
+    if (wq > 8 || aq > 8){
+        printf("[Error] Unsupported Quantization Type\n");
+        return;
+    }
+
+    const size_t b = x->shape[0];
+    const size_t n = x->shape[1];
+    long start;
+    MiCo_ROOFLINE_BEGIN();
+
+    const size_t align_factor = align;
+
+    const size_t aligned_size = (n + align_factor - 1) / align_factor * align_factor;
+    // Activation Quantization
+    Tensor2D_Q8 qx;
+    qx.shape[0] = b;
+    qx.shape[1] = aligned_size;
+
+    start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
+    const size_t qx_size = b*aligned_size*sizeof(int8_t) / (8/aq);
+    MiCo_mem_qbuffer_use(qx_size);
+    MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
+    qx.data = MiCo_QX_Buffer_Global.buffer;
+    MiCo_2D_quant(&qx, x, aq);
+    qx.wq = aq;
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
+    QUANT_TIMER += MiCo_time() - start;
+    // printf("Quant Speed: %ld\n", MiCo_time() - start);
+
+    __bitlinear_q_f32(y, &qx, weight, bias, wq);
+    MiCo_ROOFLINE_END("bitlinear_f32", b * aligned_size * y->shape[1], aq, wq,
+        b * n * 4 + MICO_RL_BYTES(y->shape[1] * aligned_size, wq) + b * y->shape[1] * 4);
+}
+
+// Several weight matrices against one quantized input, e.g. the SwiGLU
+// gate/up projections. The activation is walked once in blocks of
+// MICO_MULTI_ROWS rows; every weight consumes a block while it is still
+// in cache. Weight i uses bit-width weights[i]->wq and writes ys[i].
+#ifndef MICO_MULTI_ROWS
+#define MICO_MULTI_ROWS 8
+#endif
+
+void MiCo_bitlinear_multi_f32(
+    Tensor2D_F32 *const *ys, const Tensor2D_Q8 *qx,
+    const Tensor2D_Q8 *const *weights, const Tensor1D_F32 *const *biases,
+    const size_t n_weights){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitlinear_multi_f32");
+
+    const qtype aq = qx->wq;
+    const size_t b = qx->shape[0];
+    const size_t row_bytes = qx->shape[1] * aq / 8;
+    long start;
+
+    MiCo_assert(aq <= 8, "[BitLinearMulti] Unsupported Quantization Type");
+    MiCo_assert(qx->shape[1] * aq % 8 == 0, "[BitLinearMulti] rows must be byte aligned");
+    #ifdef USE_ALT_LAYOUT
+    MiCo_assert(0, "[BitLinearMulti] N,K x K,M layout is not supported");
+    #endif
+
+    size_t m_max = 0;
+    for (size_t w = 0; w < n_weights; w++){
+        MiCo_assert(weights[w]->wq <= 8, "[BitLinearMulti] Unsupported Quantization Type");
+        MiCo_assert(ys[w]->shape[0] == b && ys[w]->shape[1] == weights[w]->shape[0],
+            "[BitLinearMulti] output shape mismatch");
+        m_max = weights[w]->shape[0] > m_max ? weights[w]->shape[0] : m_max;
+    }
+    int32_t* qO = MiCo_malloc(MICO_MULTI_ROWS * m_max * sizeof(int32_t));
+    MiCo_assert(qO != NULL, "[BitLinearMulti] failed to allocate buffer");
+    MiCo_ROOFLINE_BEGIN();
+
+    for (size_t r0 = 0; r0 < b; r0 += MICO_MULTI_ROWS){
+        const size_t rb = (b - r0) < MICO_MULTI_ROWS ? (b - r0) : MICO_MULTI_ROWS;
+        Tensor2D_Q8 qx_blk = *qx;
+        qx_blk.shape[0] = rb;
+        qx_blk.data = qx->data + r0 * row_bytes;
+
+        for (size_t w = 0; w < n_weights; w++){
+            const Tensor2D_Q8 *weight = weights[w];
+            const size_t m = weight->shape[0];
+            for (size_t i = 0; i < rb * m; i++) {
+                qO[i] = 0;
+            }
+
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+            MiCo_runtime.matmul_matrix[qlog(aq)][qlog(weight->wq)](qO, &qx_blk, weight);
+            MiCo_PERF_MACS(qx_blk.shape[0] * qx_blk.shape[1] * weight->shape[0]);
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QMATMUL_TIMER += MiCo_time() - start;
+
+            const float scale = weight->scale * qx->scale;
+            const Tensor1D_F32 *bias = biases != NULL ? biases[w] : NULL;
+            start = MiCo_time();
+            MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
+            for (size_t i = 0; i < rb; i++) {
+                float* yi = ys[w]->data + (r0 + i) * m;
+                for (size_t j = 0; j < m; j++) {
+                    float bj = (bias != NULL && bias->shape[0] != 0) ? bias->data[j] : 0.f;
+                    yi[j] = bj + (float)qO[i * m + j] * scale;
+                }
+            }
+            MiCo_TRACE_END(MICO_TRACE_PHASE);
+            QUANT_TIMER += MiCo_time() - start;
+        }
+    }
+    MiCo_free(qO);
+    #ifdef MICO_ROOFLINE
+    // Reported at the first weight's bit-width
+    uint64_t rl_macs = 0, rl_bytes = MICO_RL_BYTES(b * qx->shape[1], aq);
+    for (size_t w = 0; w < n_weights; w++){
+        rl_macs += (uint64_t)b * qx->shape[1] * weights[w]->shape[0];
+        rl_bytes += MICO_RL_BYTES(weights[w]->shape[0] * qx->shape[1], weights[w]->wq)
+            + b * weights[w]->shape[0] * 4;
+    }
+    MiCo_ROOFLINE_END("bitlinear_multi_f32", rl_macs, aq, weights[0]->wq, rl_bytes);
+    #endif
 }
 
 void MiCo_bitlinear3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
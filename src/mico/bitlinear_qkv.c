@@ -0,0 +1,152 @@
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include "mico_quant.h"
+#include "mico_runtime.h"
+
+extern long QMATMUL_TIMER;
+extern long QUANT_TIMER;
+
+extern MiCoRuntime MiCo_runtime;
+
+// Rotate consecutive (even, odd) pairs of every head by pos * freq_i
+static void __rope_rows(float* x, const int n, const int head_size,
+    const float* cos_t, const float* sin_t){
+    for (int h = 0; h < n; h += head_size){
+        float* xh = x + h;
+        for (int i = 0; i < head_size / 2; i++){
+            const float x0 = xh[2 * i];
+            const float x1 = xh[2 * i + 1];
+            xh[2 * i]     = x0 * cos_t[i] - x1 * sin_t[i];
+            xh[2 * i + 1] = x0 * sin_t[i] + x1 * cos_t[i];
+        }
+    }
+}
+
+// Fused QKV projection with RoPE for LLM blocks.
+// x is quantized once and projected through a single matmul against the
+// row-concatenated weight [Wq; Wk; Wv]. The epilogue de-quantizes each
+// segment, rotates Q and K and writes K/V of token i straight into cache
+// row pos0 + i, in FP32 or INT8 with one scale per row (the layout of
+// MiCo_multihead_attention_f32 / _kv8). No bias, as in LLaMA-style blocks.
+void MiCo_bitlinear_qkv_f32(
+    Tensor2D_F32* q,                // [b, n_heads * head_size] - rotated queries
+    const Tensor2D_F32* x,          // [b, n] - inputs at positions pos0 .. pos0 + b - 1
+    const Tensor2D_Q8* w_qkv,       // [n_heads * head_size + 2 * kv_dim, n] - Q|K|V weights
+    const float* w_scales,          // [3] per-segment weight scales, NULL uses w_qkv->scale
+    void* key_cache,                // [seq_len, kv_dim] float or int8_t
+    void* value_cache,              // [seq_len, kv_dim] float or int8_t
+    float* key_scales,              // [seq_len] (INT8 only)
+    float* value_scales,            // [seq_len] (INT8 only)
+    const uint8_t kv_bits,          // 32 for FP32, 8 for INT8
+    const int pos0,
+    const float rope_theta,
+    const MiCo_MHA_Config* cfg,
+    const qtype wq, const qtype aq, const size_t align
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitlinear_qkv_f32");
+    const size_t b = x->shape[0];
+    const size_t n = x->shape[1];
+    const int head_size = cfg->head_size;
+    const int dim = cfg->n_heads * head_size;
+    const int kv_dim = cfg->kv_dim;
+    const size_t m = (size_t)dim + 2 * kv_dim;
+
+    MiCo_assert(wq <= 8 && aq <= 8, "[BitQKV] Unsupported Quantization Type");
+    MiCo_assert(kv_bits == 32 || kv_bits == 8, "[BitQKV] only FP32 and INT8 KV cache is supported");
+    #ifdef USE_ALT_LAYOUT
+    MiCo_assert(w_qkv->shape[1] == m, "[BitQKV] weight columns must be dim + 2 * kv_dim");
+    MiCo_assert(wq == 8 && aq == 8, "[BitQKV] N,K x K,M layout only supports INT8 weights and activations");
+    #else
+    MiCo_assert(w_qkv->shape[0] == m, "[BitQKV] weight rows must be dim + 2 * kv_dim");
+    #endif
+    MiCo_assert(q->shape[0] == b && q->shape[1] == (size_t)dim, "[BitQKV] q shape mismatch");
+    MiCo_assert(head_size % 2 == 0, "[BitQKV] head_size must be even for RoPE");
+    MiCo_assert(pos0 >= 0 && pos0 + (int)b <= cfg->seq_len, "[BitQKV] positions exceed seq_len");
+
+    long start;
+    MiCo_ROOFLINE_BEGIN();
+    int32_t* qO = MiCo_malloc(b * m * sizeof(int32_t));
+    float* kv_row = MiCo_malloc(2 * kv_dim * sizeof(float));
+    float* cos_t = MiCo_malloc(head_size / 2 * sizeof(float));
+    float* sin_t = MiCo_malloc(head_size / 2 * sizeof(float));
+    MiCo_assert(qO != NULL && kv_row != NULL && cos_t != NULL && sin_t != NULL,
+        "[BitQKV] failed to allocate buffers");
+
+    // One activation quantization for all three projections
+    const size_t aligned_size = (n + align - 1) / align * align;
+    Tensor2D_Q8 qx;
+    qx.shape[0] = b;
+    qx.shape[1] = aligned_size;
+
+    start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "quant");
+    const size_t qx_size = b * aligned_size * sizeof(int8_t) / (8 / aq);
+    MiCo_mem_qbuffer_use(qx_size);
+    MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
+    qx.data = MiCo_QX_Buffer_Global.buffer;
+    MiCo_2D_quant(&qx, x, aq);
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
+    QUANT_TIMER += MiCo_time() - start;
+
+    start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+    // the MatMul kernels accumulate into qO
+    memset(qO, 0, b * m * sizeof(int32_t));
+    MiCo_runtime.matmul_matrix[qlog(aq)][qlog(wq)](qO, &qx, w_qkv);
+    MiCo_PERF_MACS(b * aligned_size * m);
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
+    QMATMUL_TIMER += MiCo_time() - start;
+
+    const float sq = (w_scales ? w_scales[0] : w_qkv->scale) * qx.scale;
+    const float sk = (w_scales ? w_scales[1] : w_qkv->scale) * qx.scale;
+    const float sv = (w_scales ? w_scales[2] : w_qkv->scale) * qx.scale;
+
+    // Epilogue: de-quantize, RoPE, and KV cache write
+    start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "dequant");
+    for (size_t t = 0; t < b; t++){
+        const int pos = pos0 + (int)t;
+        const int32_t* o = qO + t * m;
+        for (int i = 0; i < head_size / 2; i++){
+            const float freq = 1.0f / powf(rope_theta, (float)(2 * i) / (float)head_size);
+            const float val = pos * freq;
+            cos_t[i] = cosf(val);
+            sin_t[i] = sinf(val);
+        }
+
+        float* qt = q->data + t * dim;
+        float* kt = kv_row;
+        float* vt = kv_row + kv_dim;
+        for (int j = 0; j < dim; j++){
+            qt[j] = (float)o[j] * sq;
+        }
+        for (int j = 0; j < kv_dim; j++){
+            kt[j] = (float)o[dim + j] * sk;
+            vt[j] = (float)o[dim + kv_dim + j] * sv;
+        }
+        __rope_rows(qt, dim, head_size, cos_t, sin_t);
+        __rope_rows(kt, kv_dim, head_size, cos_t, sin_t);
+
+        if (kv_bits == 8){
+            qbyte* kc = (qbyte*)key_cache + (size_t)pos * kv_dim;
+            qbyte* vc = (qbyte*)value_cache + (size_t)pos * kv_dim;
+            key_scales[pos] = __FP32toQ8(kc, kt, kv_dim);
+            value_scales[pos] = __FP32toQ8(vc, vt, kv_dim);
+        } else {
+            memcpy((float*)key_cache + (size_t)pos * kv_dim, kt, kv_dim * sizeof(float));
+            memcpy((float*)value_cache + (size_t)pos * kv_dim, vt, kv_dim * sizeof(float));
+        }
+    }
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
+    QUANT_TIMER += MiCo_time() - start;
+
+    MiCo_free(qO);
+    MiCo_free(kv_row);
+    MiCo_free(cos_t);
+    MiCo_free(sin_t);
+    MiCo_ROOFLINE_END("bitlinear_qkv_f32", b * aligned_size * m, aq, wq,
+        b * n * 4 + MICO_RL_BYTES(m * aligned_size, wq) + b * dim * 4 +
+        MICO_RL_BYTES(b * 2 * kv_dim, kv_bits));
+}
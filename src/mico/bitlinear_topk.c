@@ -0,0 +1,230 @@
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include "mico_quant.h"
+#include "mico_runtime.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+extern long QMATMUL_TIMER;
+
+extern MiCoRuntime MiCo_runtime;
+
+// Fused classifier / LM head.
+// The weight is walked in tiles of MICO_HEAD_TILE output rows; each tile's
+// int32 accumulators are scanned into a running top-k per row and, when
+// requested, into online log-sum-exp partials, so the full FP32 logits are
+// never written. Without bias and with a positive scale, candidates are
+// compared on the raw int32 accumulators and only the winners are
+// de-quantized. With OpenMP, tiles are split across threads and the
+// per-thread results merged at the end.
+#ifndef MICO_HEAD_TILE
+#define MICO_HEAD_TILE 256
+#endif
+
+typedef struct {
+    float* val;     // [b, k] sorted descending
+    size_t* idx;    // [b, k]
+    int32_t* acc;   // [b, k] raw accumulators of the entries
+    int* count;     // [b]
+    float* lse_max; // [b] running max of logits / temperature
+    float* lse_sum; // [b] running sum of exp(logit / temperature - max)
+} __topk_state;
+
+// Insert into a descending list; ties keep the lower index first
+static inline void __topk_insert(float* val, size_t* idx, int32_t* acc,
+    int* count, const size_t k, const float v, const size_t j, const int32_t a){
+    int p = *count < (int)k ? (*count)++ : (int)k - 1;
+    while (p > 0 && (val[p - 1] < v || (val[p - 1] == v && idx[p - 1] > j))){
+        val[p] = val[p - 1];
+        idx[p] = idx[p - 1];
+        acc[p] = acc[p - 1];
+        p--;
+    }
+    val[p] = v;
+    idx[p] = j;
+    acc[p] = a;
+}
+
+static void __topk_tiles(__topk_state* st, int32_t* qO, const Tensor2D_Q8* qx,
+    const Tensor2D_Q8* weight, const Tensor1D_F32* bias, const qtype wq,
+    const size_t k, const float inv_temp, const int with_lse,
+    const size_t tile0, const size_t tile1){
+    MiCo_TRACE_SCOPE(MICO_TRACE_KERNEL, "topk_tiles");
+    const size_t b = qx->shape[0];
+    const size_t m = weight->shape[0];
+    const size_t row_bytes = weight->shape[1] * wq / 8;
+    const float scale = weight->scale * qx->scale;
+    const int has_bias = bias != NULL && bias->shape[0] != 0;
+    // Raw int32 comparison is only order-preserving for a positive scale
+    const int int_order = !has_bias && scale > 0.0f;
+
+    for (size_t t = tile0; t < tile1; t++){
+        const size_t j0 = t * MICO_HEAD_TILE;
+        const size_t mt = (m - j0) < MICO_HEAD_TILE ? (m - j0) : MICO_HEAD_TILE;
+        Tensor2D_Q8 w_tile = *weight;
+        w_tile.shape[0] = mt;
+        w_tile.data = weight->data + j0 * row_bytes;
+
+        for (size_t i = 0; i < b * mt; i++){
+            qO[i] = 0;
+        }
+        MiCo_runtime.matmul_matrix[qlog(qx->wq)][qlog(wq)](qO, qx, &w_tile);
+        MiCo_PERF_MACS(b * qx->shape[1] * mt);
+
+        for (size_t i = 0; i < b; i++){
+            const int32_t* o = qO + i * mt;
+            float* val = st->val + i * k;
+            size_t* idx = st->idx + i * k;
+            int32_t* acc = st->acc + i * k;
+            int* count = st->count + i;
+
+            if (!int_order){
+                for (size_t j = 0; j < mt; j++){
+                    float v = (float)o[j] * scale;
+                    if (has_bias) v += bias->data[j0 + j];
+                    if (*count == (int)k && v <= val[k - 1]) continue;
+                    __topk_insert(val, idx, acc, count, k, v, j0 + j, o[j]);
+                }
+            } else {
+                // scale > 0, so the int32 order is the logit order
+                for (size_t j = 0; j < mt; j++){
+                    if (*count == (int)k && o[j] <= acc[k - 1]) continue;
+                    __topk_insert(val, idx, acc, count, k, (float)o[j] * scale, j0 + j, o[j]);
+                }
+            }
+
+            if (with_lse){
+                float tmax = -INFINITY;
+                for (size_t j = 0; j < mt; j++){
+                    float v = (float)o[j] * scale;
+                    if (has_bias) v += bias->data[j0 + j];
+                    v *= inv_temp;
+                    tmax = v > tmax ? v : tmax;
+                }
+                const float m_new = tmax > st->lse_max[i] ? tmax : st->lse_max[i];
+                float sum = st->lse_sum[i] * MiCo_fast_expf(st->lse_max[i] - m_new);
+                for (size_t j = 0; j < mt; j++){
+                    float v = (float)o[j] * scale;
+                    if (has_bias) v += bias->data[j0 + j];
+                    sum += MiCo_fast_expf(v * inv_temp - m_new);
+                }
+                st->lse_max[i] = m_new;
+                st->lse_sum[i] = sum;
+            }
+        }
+    }
+}
+
+void MiCo_bitlinear_topk_f32(
+    size_t* top_idx,                // [b, k] output indices, best first
+    float* top_val,                 // [b, k] de-quantized logits of the winners
+    float* lse,                     // [b] log-sum-exp of logits / temperature, or NULL
+    const Tensor2D_Q8* qx,          // [b, n] pre-quantized activation handle
+    const Tensor2D_Q8* weight,      // [m, n] head weight
+    const Tensor1D_F32* bias,       // [m] or empty
+    const qtype wq,
+    const size_t k,
+    const float temperature
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "bitlinear_topk_f32");
+    const size_t b = qx->shape[0];
+    const size_t m = weight->shape[0];
+    const size_t n_tiles = (m + MICO_HEAD_TILE - 1) / MICO_HEAD_TILE;
+    const int with_lse = lse != NULL;
+
+    MiCo_assert(wq <= 8 && qx->wq <= 8, "[BitHead] Unsupported Quantization Type");
+    MiCo_assert(k > 0 && k <= m, "[BitHead] k must be in [1, m]");
+    MiCo_assert(weight->shape[1] * wq % 8 == 0, "[BitHead] weight rows must be byte aligned");
+    MiCo_assert(!with_lse || temperature > 0.0f, "[BitHead] temperature must be positive");
+    #ifdef USE_ALT_LAYOUT
+    MiCo_assert(0, "[BitHead] N,K x K,M layout is not supported");
+    #endif
+
+    MiCo_ROOFLINE_BEGIN();
+    int n_threads = 1;
+    #ifdef _OPENMP
+    n_threads = omp_get_max_threads();
+    if ((size_t)n_threads > n_tiles) n_threads = (int)n_tiles;
+    #endif
+
+    __topk_state* st = MiCo_malloc(n_threads * sizeof(__topk_state));
+    MiCo_assert(st != NULL, "[BitHead] failed to allocate state");
+    for (int t = 0; t < n_threads; t++){
+        st[t].val = MiCo_malloc(b * k * sizeof(float));
+        st[t].idx = MiCo_malloc(b * k * sizeof(size_t));
+        st[t].acc = MiCo_malloc(b * k * sizeof(int32_t));
+        st[t].count = MiCo_calloc(b, sizeof(int));
+        st[t].lse_max = MiCo_malloc(b * sizeof(float));
+        st[t].lse_sum = MiCo_calloc(b, sizeof(float));
+        MiCo_assert(st[t].val != NULL && st[t].idx != NULL && st[t].acc != NULL &&
+            st[t].count != NULL && st[t].lse_max != NULL && st[t].lse_sum != NULL,
+            "[BitHead] failed to allocate state");
+        for (size_t i = 0; i < b; i++){
+            st[t].lse_max[i] = -INFINITY;
+        }
+    }
+
+    long start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "matmul");
+    const float inv_temp = with_lse ? 1.0f / temperature : 1.0f;
+    int t;
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(n_threads) schedule(static)
+    #endif
+    for (t = 0; t < n_threads; t++){
+        const size_t tile0 = n_tiles * t / n_threads;
+        const size_t tile1 = n_tiles * (t + 1) / n_threads;
+        int32_t* qO = MiCo_malloc(b * MICO_HEAD_TILE * sizeof(int32_t));
+        MiCo_assert(qO != NULL, "[BitHead] failed to allocate buffer");
+        __topk_tiles(&st[t], qO, qx, weight, bias, wq, k, inv_temp, with_lse, tile0, tile1);
+        MiCo_free(qO);
+    }
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
+    QMATMUL_TIMER += MiCo_time() - start;
+
+    // Merge per-thread results
+    int32_t* macc = MiCo_malloc(k * sizeof(int32_t));
+    MiCo_assert(macc != NULL, "[BitHead] failed to allocate buffer");
+    for (size_t i = 0; i < b; i++){
+        float* val = top_val + i * k;
+        size_t* idx = top_idx + i * k;
+        int count = 0;
+        float m_all = -INFINITY;
+        for (int th = 0; th < n_threads; th++){
+            m_all = st[th].lse_max[i] > m_all ? st[th].lse_max[i] : m_all;
+        }
+        float sum = 0.0f;
+        for (int th = 0; th < n_threads; th++){
+            for (int e = 0; e < st[th].count[i]; e++){
+                const float v = st[th].val[i * k + e];
+                if (count == (int)k && v <= val[k - 1]) continue;
+                __topk_insert(val, idx, macc, &count, k, v,
+                    st[th].idx[i * k + e], st[th].acc[i * k + e]);
+            }
+            if (with_lse && st[th].lse_sum[i] > 0.0f){
+                sum += st[th].lse_sum[i] * MiCo_fast_expf(st[th].lse_max[i] - m_all);
+            }
+        }
+        if (with_lse){
+            lse[i] = m_all + logf(sum);
+        }
+    }
+
+    MiCo_free(macc);
+    for (int th = 0; th < n_threads; th++){
+        MiCo_free(st[th].val);
+        MiCo_free(st[th].idx);
+        MiCo_free(st[th].acc);
+        MiCo_free(st[th].count);
+        MiCo_free(st[th].lse_max);
+        MiCo_free(st[th].lse_sum);
+    }
+    MiCo_free(st);
+    MiCo_ROOFLINE_END("bitlinear_topk_f32", b * qx->shape[1] * m, qx->wq, wq,
+        MICO_RL_BYTES(b * qx->shape[1], qx->wq) + MICO_RL_BYTES(m * qx->shape[1], wq) +
+        b * k * (sizeof(float) + sizeof(size_t)));
+}
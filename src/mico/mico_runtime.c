@@ -8,14 +8,79 @@ MatMulFunc MiCo_QMatMul[4][4] = {
     {MiCo_Q8x1_MatMul, MiCo_Q8x2_MatMul, MiCo_Q8x4_MatMul, MiCo_Q8_MatMul},
 };
 
+#ifdef MICO_CACHESIM
+#include "profile.h"
+
+// Access pattern of the generic kernels: one pass over K per output, with
+// sub-byte operands loaded again for every element they hold
+static void __matmul_cache_trace(const int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w,
+    const size_t xq, const size_t wq){
+    const size_t batch_size = x->shape[0];
+    const size_t in_features = x->shape[1];
+    #ifdef USE_ALT_LAYOUT
+    const size_t out_features = w->shape[1];
+    #else
+    const size_t out_features = w->shape[0];
+    #endif
+    for (size_t i = 0; i < batch_size; i++) {
+        for (size_t j = 0; j < out_features; j++) {
+            for (size_t k = 0; k < in_features; k++) {
+                MiCo_CACHE_READ(MICO_CACHE_MATMUL, &x->data[(i * in_features + k) * xq / 8], 1);
+                #ifdef USE_ALT_LAYOUT
+                MiCo_CACHE_READ(MICO_CACHE_MATMUL, &w->data[(k * out_features + j) * wq / 8], 1);
+                #else
+                MiCo_CACHE_READ(MICO_CACHE_MATMUL, &w->data[(j * in_features + k) * wq / 8], 1);
+                #endif
+            }
+            MiCo_CACHE_WRITE(MICO_CACHE_MATMUL, &O[i * out_features + j], sizeof(int32_t));
+        }
+    }
+}
+
+// Every entry runs the linked kernel, then replays its accesses into the cache model
+#define __MATMUL_CACHESIM(kernel, xq, wq) \
+static void kernel##_CacheSim(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w){ \
+    kernel(O, x, w); \
+    __matmul_cache_trace(O, x, w, xq, wq); \
+}
+
+__MATMUL_CACHESIM(MiCo_Q1_MatMul, 1, 1)
+__MATMUL_CACHESIM(MiCo_Q1x2_MatMul, 1, 2)
+__MATMUL_CACHESIM(MiCo_Q1x4_MatMul, 1, 4)
+__MATMUL_CACHESIM(MiCo_Q1x8_MatMul, 1, 8)
+__MATMUL_CACHESIM(MiCo_Q2x1_MatMul, 2, 1)
+__MATMUL_CACHESIM(MiCo_Q2_MatMul, 2, 2)
+__MATMUL_CACHESIM(MiCo_Q2x4_MatMul, 2, 4)
+__MATMUL_CACHESIM(MiCo_Q2x8_MatMul, 2, 8)
+__MATMUL_CACHESIM(MiCo_Q4x1_MatMul, 4, 1)
+__MATMUL_CACHESIM(MiCo_Q4x2_MatMul, 4, 2)
+__MATMUL_CACHESIM(MiCo_Q4_MatMul, 4, 4)
+__MATMUL_CACHESIM(MiCo_Q4x8_MatMul, 4, 8)
+__MATMUL_CACHESIM(MiCo_Q8x1_MatMul, 8, 1)
+__MATMUL_CACHESIM(MiCo_Q8x2_MatMul, 8, 2)
+__MATMUL_CACHESIM(MiCo_Q8x4_MatMul, 8, 4)
+__MATMUL_CACHESIM(MiCo_Q8_MatMul, 8, 8)
+
+static MatMulFunc MiCo_QMatMul_CacheSim[4][4] = {
+    {MiCo_Q1_MatMul_CacheSim,   MiCo_Q1x2_MatMul_CacheSim, MiCo_Q1x4_MatMul_CacheSim, MiCo_Q1x8_MatMul_CacheSim},
+    {MiCo_Q2x1_MatMul_CacheSim, MiCo_Q2_MatMul_CacheSim,   MiCo_Q2x4_MatMul_CacheSim, MiCo_Q2x8_MatMul_CacheSim},
+    {MiCo_Q4x1_MatMul_CacheSim, MiCo_Q4x2_MatMul_CacheSim, MiCo_Q4_MatMul_CacheSim,   MiCo_Q4x8_MatMul_CacheSim},
+    {MiCo_Q8x1_MatMul_CacheSim, MiCo_Q8x2_MatMul_CacheSim, MiCo_Q8x4_MatMul_CacheSim, MiCo_Q8_MatMul_CacheSim},
+};
+
+#define MICO_DEFAULT_MATMUL MiCo_QMatMul_CacheSim
+#else
+#define MICO_DEFAULT_MATMUL MiCo_QMatMul
+#endif
+
 MiCoRuntime MiCo_runtime = {
-    .matmul_matrix = MiCo_QMatMul
+    .matmul_matrix = MICO_DEFAULT_MATMUL
 };
 
 void MiCo_set_runtime(MiCo_MatMul_Opt opt) {
     switch (opt) {
         case MiCo_MatMul_Opt_Default:
-            MiCo_runtime.matmul_matrix = MiCo_QMatMul;
+            MiCo_runtime.matmul_matrix = MICO_DEFAULT_MATMUL;
             break;
         // case MiCo_MatMul_Opt_Unroll:
         //     MiCo_runtime.matmul_matrix = MiCo_QMatMul_Unroll;
@@ -25,7 +90,7 @@ void MiCo_set_runtime(MiCo_MatMul_Opt opt) {
         //     break;
         default:
             // Invalid option, fallback to default
-            MiCo_runtime.matmul_matrix = MiCo_QMatMul;
+            MiCo_runtime.matmul_matrix = MICO_DEFAULT_MATMUL;
             break;
     }
 }
@@ -1,28 +1,35 @@
 #include "mico_quant.h"
+#include "profile.h"
 
 #include <math.h>
 
 
-void MiCo_2D_quant(Tensor2D_Q8 *qx, const Tensor2D_F32 *x, const qtype qbits){
-
+#ifdef MICO_CACHESIM
+// Access pattern of the generic MiCo_2D_FP32to* kernels: an absmax pass
+// over x, then per output byte the 8 / qbits floats packed into it
+static void __2D_quant_cache_trace(const Tensor2D_Q8 *qx, const Tensor2D_F32 *x, const qtype qbits){
     const size_t b = x->shape[0];
     const size_t n = x->shape[1];
-
-    #ifdef QUANT_REUSE
-    // Check if the buffer already store the same tensor
-    if (MiCo_QX_Buffer_Global.src == x->data && 
-        MiCo_QX_Buffer_Global.size == b*n &&
-        MiCo_QX_Buffer_Global.qbits == qbits) {
-        return;
+    const size_t qx_n = qx->shape[1];
+    const size_t per_byte = 8 / qbits;
+    for (size_t i = 0; i < b * n; i++){
+        MiCo_CACHE_READ(MICO_CACHE_QUANT, &x->data[i], sizeof(float));
     }
-    #endif
-
-    // Update Global Buffer Info
-    MiCo_QX_Buffer_Global.src = x->data;
-    MiCo_QX_Buffer_Global.size = b*n;
-    MiCo_QX_Buffer_Global.qbits = qbits;
-    MiCo_QX_Buffer_Global.dirty = 0;
+    for (size_t r = 0; r < b; r++){
+        for (size_t i = 0; i < qx_n; i += per_byte){
+            for (size_t j = i; j < i + per_byte && j < n; j++){
+                MiCo_CACHE_READ(MICO_CACHE_QUANT, &x->data[r * n + j], sizeof(float));
+            }
+            MiCo_CACHE_WRITE(MICO_CACHE_QUANT, &qx->data[(r * qx_n + i) / per_byte], 1);
+        }
+    }
+}
+#endif
 
+static void __2D_quant(Tensor2D_Q8 *qx, const Tensor2D_F32 *x, const qtype qbits){
+    #ifdef MICO_CACHESIM
+    if (qbits == 8 || qbits == 4 || qbits == 2 || qbits == 1) __2D_quant_cache_trace(qx, x, qbits);
+    #endif
     switch (qbits)
     {
       case 8:
@@ -41,6 +48,29 @@ void MiCo_2D_quant(Tensor2D_Q8 *qx, const Tensor2D_F32 *x, const qtype qbits){
         printf("[Warning] Unsupported Weight Quantization - %d\n", qbits);
         break;
     }
+}
+
+void MiCo_2D_quant(Tensor2D_Q8 *qx, const Tensor2D_F32 *x, const qtype qbits){
+
+    const size_t b = x->shape[0];
+    const size_t n = x->shape[1];
+
+    #ifdef QUANT_REUSE
+    // Check if the buffer already store the same tensor
+    if (MiCo_QX_Buffer_Global.src == x->data && 
+        MiCo_QX_Buffer_Global.size == b*n &&
+        MiCo_QX_Buffer_Global.qbits == qbits) {
+        return;
+    }
+    #endif
+
+    // Update Global Buffer Info
+    MiCo_QX_Buffer_Global.src = x->data;
+    MiCo_QX_Buffer_Global.size = b*n;
+    MiCo_QX_Buffer_Global.qbits = qbits;
+    MiCo_QX_Buffer_Global.dirty = 0;
+
+    __2D_quant(qx, x, qbits);
     return;
 }
 
@@ -85,6 +115,52 @@ void MiCo_4D_quant(Tensor4D_Q8 *qx, const Tensor4D_F32 *x, const qtype qbits){
     return;
 }
 
+// Explicit activation handles.
+// The activation is quantized once into caller-owned storage and can be
+// consumed by any number of *_q kernels, independent of the global
+// QUANT_REUSE buffer.
+size_t MiCo_qact_size(const size_t rows, const size_t cols,
+    const qtype aq, const size_t align){
+    const size_t aligned_size = (cols + align - 1) / align * align;
+    return rows * aligned_size * aq / 8;
+}
+
+void MiCo_2D_quant_act(Tensor2D_Q8 *qx, const Tensor2D_F32 *x,
+    const qtype aq, const size_t align){
+    qx->shape[0] = x->shape[0];
+    qx->shape[1] = (x->shape[1] + align - 1) / align * align;
+    __2D_quant(qx, x, aq);
+    qx->wq = aq;
+}
+
+// NCHW input of a 1x1 convolution as a [B*H*W, C] activation handle
+void MiCo_4D_quant_act_pw(Tensor2D_Q8 *qx, const Tensor4D_F32 *x,
+    const qtype aq, const size_t align){
+    #ifdef USE_ALT_LAYOUT
+    // NHWC is already [B*H*W, C]
+    Tensor2D_F32 x2d = { .shape = {x->shape[0] * x->shape[1] * x->shape[2], x->shape[3]},
+        .data = x->data };
+    MiCo_2D_quant_act(qx, &x2d, aq, align);
+    #else
+    const size_t B = x->shape[0];
+    const size_t C = x->shape[1];
+    const size_t HW = x->shape[2] * x->shape[3];
+    float *xt = MiCo_malloc(B * HW * C * sizeof(float));
+    MiCo_assert(xt != NULL, "[Quantization] failed to allocate buffer");
+    for (size_t b = 0; b < B; b++){
+        for (size_t c = 0; c < C; c++){
+            const float *src = x->data + (b * C + c) * HW;
+            for (size_t p = 0; p < HW; p++){
+                xt[(b * HW + p) * C + c] = src[p];
+            }
+        }
+    }
+    Tensor2D_F32 x2d = { .shape = {B * HW, C}, .data = xt };
+    MiCo_2D_quant_act(qx, &x2d, aq, align);
+    MiCo_free(xt);
+    #endif
+}
+
 #ifdef USE_RVF
 int roundf2i(float x){
     int result;
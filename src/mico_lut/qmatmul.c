@@ -101,7 +101,7 @@ void MiCo_Q8x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     
     // Allocate LUT storage for all groups
     int32_t lut_storage[256 * 64];
-    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 64) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -134,7 +134,7 @@ void MiCo_Q8x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 64) free(luts);
+    if (num_groups > 64) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -148,7 +148,7 @@ void MiCo_Q8x2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 4;
     
     int32_t lut_storage[256 * 64];
-    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 64) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -181,7 +181,7 @@ void MiCo_Q8x2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 64) free(luts);
+    if (num_groups > 64) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -195,7 +195,7 @@ void MiCo_Q8x4_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 2;
     
     int32_t lut_storage[256 * 128];
-    int32_t *luts = (num_groups <= 128) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 128) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 128) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -227,7 +227,7 @@ void MiCo_Q8x4_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 128) free(luts);
+    if (num_groups > 128) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -241,7 +241,7 @@ void MiCo_Q4_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 2;
     
     int32_t lut_storage[256 * 128];
-    int32_t *luts = (num_groups <= 128) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 128) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 128) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -277,7 +277,7 @@ void MiCo_Q4_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 128) free(luts);
+    if (num_groups > 128) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -291,7 +291,7 @@ void MiCo_Q2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 4;
     
     int32_t lut_storage[256 * 64];
-    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 64) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -327,7 +327,7 @@ void MiCo_Q2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 64) free(luts);
+    if (num_groups > 64) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -386,7 +386,7 @@ void MiCo_Q4x2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 4;
     
     int32_t lut_storage[256 * 64];
-    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 64) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 64) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -424,7 +424,7 @@ void MiCo_Q4x2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 64) free(luts);
+    if (num_groups > 64) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -438,7 +438,7 @@ void MiCo_Q4x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 8;
     
     int32_t lut_storage[256 * 32];
-    int32_t *luts = (num_groups <= 32) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 32) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 32) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -476,7 +476,7 @@ void MiCo_Q4x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 32) free(luts);
+    if (num_groups > 32) MiCo_free(luts);
 }
 
 // =============================================================================
@@ -490,7 +490,7 @@ void MiCo_Q2x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
     const size_t num_groups = in_features / 8;
     
     int32_t lut_storage[256 * 32];
-    int32_t *luts = (num_groups <= 32) ? lut_storage : (int32_t*)malloc(num_groups * 256 * sizeof(int32_t));
+    int32_t *luts = (num_groups <= 32) ? lut_storage : (int32_t*)MiCo_malloc(num_groups * 256 * sizeof(int32_t));
     if (luts == NULL && num_groups > 32) return;
     
     for (size_t i = 0; i < batch_size; i++) {
@@ -532,5 +532,5 @@ void MiCo_Q2x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
         }
     }
     
-    if (num_groups > 32) free(luts);
+    if (num_groups > 32) MiCo_free(luts);
 }
\ No newline at end of file
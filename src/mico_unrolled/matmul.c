@@ -1,4 +1,5 @@
 #include "nn.h"
+#include "profile.h"
 
 // FP32 MatMul Kernel
 // Unrolled Implementation of 8-bit MatMul
@@ -6,7 +7,7 @@
 void MiCo_MatMul_f32(
     float* y, const float* x, const float* w, 
     const size_t m, const size_t n, const size_t p){
-        
+    MiCo_ROOFLINE_BEGIN();
     size_t unrolled_end = (n / 4) * 4;
     for (size_t i = 0; i < m; i++) {
         for (size_t j = 0; j < p; j++) {
@@ -23,4 +24,5 @@ void MiCo_MatMul_f32(
             y[i * p + j] += sum;
         }
     }
+    MiCo_ROOFLINE_END("MatMul_f32", m * n * p, 32, 32, 4 * (m * n + n * p + m * p));
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "nn.h"
+#include "profile.h"
 
 void MiCo_mul2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x1, const Tensor2D_F32 *x2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "mul2d_f32");
     size_t batch_size = x1->shape[0];
     size_t dims = x1->shape[1];
 
@@ -4,30 +4,107 @@
 #include "profile.h"
 #include <math.h>
 
-extern long SOFTMAX_TIMER;
 extern long ATTN_TIMER;
+extern long SOFTMAX_TIMER;
 
-void softmax(float* x, int size) {
-    long start = MiCo_time();
-    // find max value (for numerical stability)
-    float max_val = x[0];
-    for (int i = 1; i < size; i++) {
-        if (x[i] > max_val) {
-            max_val = x[i];
+// Query bit-width of the INT8 KV paths in the roofline report
+#ifdef USE_INT8_Q
+#define MHA_RL_QBITS 8
+#else
+#define MHA_RL_QBITS 32
+#endif
+
+// Scores of n consecutive cache rows, written to att[j * seq_len + t]
+static void __mha_scores_f32(
+    float* att,                    // [kv_mul, seq_len] scores, segment offset applied
+    const float* q,                // [kv_mul, head_size] queries for this group
+    const float* key_rows,         // first key row, head offset already applied
+    const int n,
+    const MiCo_MHA_Config* cfg
+){
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const float scale = 1.0f / sqrtf((float)head_size);
+
+    for (int t = 0; t < n; t++) {
+        // get the key vector for this KV head and at this timestep
+        const float* k = key_rows + t * kv_dim;
+        // score every query head of the group against the same key row
+        for (int j = 0; j < kv_mul; j++) {
+            const float* qj = q + j * head_size;
+            float score = 0.0f;
+            for (int i = 0; i < head_size; i++) {
+                score += qj[i] * k[i];
+            }
+            att[j * seq_len + t] = score * scale;
+        }
+    }
+}
+
+// Weighted sum of n consecutive value rows, accumulated into xb
+static void __mha_values_f32(
+    float* xb,                     // [kv_mul, head_size] output for this group
+    const float* att,              // [kv_mul, seq_len] weights, segment offset applied
+    const float* value_rows,       // first value row, head offset already applied
+    const int n,
+    const MiCo_MHA_Config* cfg
+){
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+
+    for (int t = 0; t < n; t++) {
+        // get the value vector for this KV head and at this timestep
+        const float* v = value_rows + t * kv_dim;
+        // accumulate the weighted value into every head of the group
+        for (int j = 0; j < kv_mul; j++) {
+            const float a = att[j * seq_len + t];
+            float* xbj = xb + j * head_size;
+            for (int i = 0; i < head_size; i++) {
+                xbj[i] += a * v[i];
+            }
         }
     }
-    // exp and sum
-    float sum = 0.0f;
-    for (int i = 0; i < size; i++) {
-        x[i] = expf(x[i] - max_val);
-        sum += x[i];
+}
+
+// GQA-aware attention of one KV head against its kv_mul query heads.
+// Query heads sharing a KV head are adjacent, so q/xb hold kv_mul
+// consecutive heads and att holds kv_mul consecutive rows of seq_len.
+// Each K/V row is loaded once and used by every query head of the group
+// while it is still in registers/L1, instead of re-streaming the cache
+// kv_mul times.
+static void __mha_group_f32(
+    float* xb,                     // [kv_mul, head_size] output for this group
+    const float* q,                // [kv_mul, head_size] queries for this group
+    const float* key_cache,        // key cache, head offset already applied
+    const float* value_cache,      // value cache, head offset already applied
+    float* att,                    // [kv_mul, seq_len] attention scores for this group
+    const int pos,
+    const MiCo_MHA_Config* cfg,
+    long* softmax_time             // softmax time, added to SOFTMAX_TIMER by the caller
+){
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+
+    // iterate over all timesteps, including the current one
+    __mha_scores_f32(att, q, key_cache, pos + 1, cfg);
+
+    // softmax the scores to get attention weights, from 0..pos inclusively.
+    // The timer-free kernel is used so this is safe inside a parallel loop.
+    long start = MiCo_time();
+    for (int j = 0; j < kv_mul; j++) {
+        MiCo_softmax_f32(att + j * seq_len, att + j * seq_len, pos + 1);
     }
-    // normalize
-    for (int i = 0; i < size; i++) {
-        x[i] /= sum;
+    *softmax_time += MiCo_time() - start;
+
+    // weighted sum of the values, store back into xb
+    for (int i = 0; i < kv_mul * cfg->head_size; i++) {
+        xb[i] = 0.0f;
     }
-    long end = MiCo_time();
-    SOFTMAX_TIMER += end - start;
+    __mha_values_f32(xb, att, value_cache, pos + 1, cfg);
 }
 
 void MiCo_multihead_attention_f32(
@@ -39,59 +116,339 @@ void MiCo_multihead_attention_f32(
     const int pos,                  // current position
     const MiCo_MHA_Config* cfg      // MHA configuration
 ){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32");
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    long softmax_time = 0;
+    int g;
+    for (g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        __mha_group_f32(output->data + h0 * head_size, query->data + h0 * head_size,
+            key_cache + g * head_size, value_cache + g * head_size,
+            att_buffer + h0 * seq_len, pos, cfg, &softmax_time);
+    }
+    SOFTMAX_TIMER += softmax_time;
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("multihead_attention_f32", 2 * n_heads * head_size * (pos + 1), 32, 32,
+        2 * (size_t)(pos + 1) * cfg->kv_dim * 4 + 2 * n_heads * head_size * 4);
+    return;
+}
+
+// Batched decode attention for continuous batching.
+// Row s of query/output holds all heads of sequence s, so the Q and output
+// projections around this call run as one bitlinear over n_seqs rows.
+// Each sequence has its own cache and position; the (sequence, KV head)
+// work items are independent and are spread across threads when built
+// with OpenMP.
+void MiCo_multihead_attention_f32_batched(
+    Tensor2D_F32* output,           // [n_seqs, n_heads * head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_seqs, n_heads * head_size] - query vectors
+    float* const* key_caches,      // [n_seqs] key cache of each sequence
+    float* const* value_caches,    // [n_seqs] value cache of each sequence
+    float* att_buffer,             // [n_seqs, n_heads, seq_len] - attention scores buffer
+    const int* pos,                // [n_seqs] current position of each sequence
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32_batched");
+    const int n_seqs = (int)query->shape[0];
     const int n_heads = cfg->n_heads;
     const int head_size = cfg->head_size;
-    const int kv_dim = cfg->kv_dim;
     const int kv_mul = cfg->kv_mul;
     const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
+    const int dim = n_heads * head_size;
 
+    MiCo_assert(query->shape[1] == (size_t)dim, "[MHA-Batched] query shape mismatch");
+    MiCo_assert(output->shape[0] == (size_t)n_seqs && output->shape[1] == (size_t)dim,
+        "[MHA-Batched] output shape mismatch");
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    long softmax_time = 0;
+    int w;
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) reduction(+:softmax_time)
+    #endif
+    for (w = 0; w < n_seqs * n_kv_heads; w++) {
+        const int s = w / n_kv_heads;
+        const int g = w % n_kv_heads;
+        const int h0 = g * kv_mul;
+        __mha_group_f32(output->data + (size_t)s * dim + h0 * head_size,
+            query->data + (size_t)s * dim + h0 * head_size,
+            key_caches[s] + g * head_size, value_caches[s] + g * head_size,
+            att_buffer + ((size_t)s * n_heads + h0) * seq_len,
+            pos[s], cfg, &softmax_time);
+    }
+    // summed over work items, so it may exceed the wall time with threads
+    SOFTMAX_TIMER += softmax_time;
+    ATTN_TIMER += MiCo_time() - start_time;
+    #ifdef MICO_ROOFLINE
+    uint64_t rl_rows = 0;
+    for (int s = 0; s < n_seqs; s++) rl_rows += pos[s] + 1;
+    MiCo_ROOFLINE_END("multihead_attention_f32_batched", 2 * rl_rows * dim, 32, 32,
+        2 * rl_rows * cfg->kv_dim * 4 + 2 * (size_t)n_seqs * dim * 4);
+    #endif
+}
+
+// Chunked causal prefill.
+// Writes K/V of the n_tok chunk at positions pos0.. into the cache, then
+// computes causal attention for all chunk queries as blocked GEMMs: a tile
+// of MHA_PREFILL_QB tokens x kv_mul heads is scored against MHA_PREFILL_KB
+// cache rows at a time, so every K/V row is loaded once per query tile
+// instead of once per query. An online (running max/sum) softmax keeps
+// the scratch at one score tile, independent of the context length.
+#ifndef MHA_PREFILL_QB
+#define MHA_PREFILL_QB 16
+#endif
+#ifndef MHA_PREFILL_KB
+#define MHA_PREFILL_KB 64
+#endif
+
+void MiCo_multihead_attention_f32_prefill(
+    Tensor2D_F32* output,           // [n_tok, n_heads * head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_tok, n_heads * head_size] - query vectors
+    const Tensor2D_F32* key,       // [n_tok, kv_dim] - keys of the chunk
+    const Tensor2D_F32* value,     // [n_tok, kv_dim] - values of the chunk
+    float* key_cache,              // [seq_len, kv_dim] key cache buffer
+    float* value_cache,            // [seq_len, kv_dim] value cache buffer
+    const int pos0,                // position of the first chunk token
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32_prefill");
+    const int n_tok = (int)query->shape[0];
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int n_kv_heads = n_heads / kv_mul;
+    const int dim = n_heads * head_size;
     const float scale = 1.0f / sqrtf((float)head_size);
 
-    // Temporary bias (none)
-    Tensor1D_F32 Tb = { .shape = {0}, .data = NULL };
+    MiCo_assert(query->shape[1] == (size_t)dim, "[MHA-Prefill] query shape mismatch");
+    MiCo_assert(output->shape[0] == (size_t)n_tok && output->shape[1] == (size_t)dim,
+        "[MHA-Prefill] output shape mismatch");
+    MiCo_assert(key->shape[0] == (size_t)n_tok && key->shape[1] == (size_t)kv_dim &&
+        value->shape[0] == (size_t)n_tok && value->shape[1] == (size_t)kv_dim,
+        "[MHA-Prefill] key/value shape mismatch");
+    MiCo_assert(pos0 >= 0 && pos0 + n_tok <= cfg->seq_len, "[MHA-Prefill] chunk exceeds seq_len");
+
+    MiCo_ROOFLINE_BEGIN();
     long start_time = MiCo_time();
-    int h;
-    for (h = 0; h < n_heads; h++) {
-        // get the query vector for this head
-        float* q = query->data + h * head_size;
-        // attention scores for this head
-        float* att = att_buffer + h * seq_len;
-        // iterate over all timesteps, including the current one
-        for (int t = 0; t <= pos; t++) {
-            // get the key vector for this head and at this timestep
-            float* k = key_cache + t * kv_dim + (h / kv_mul) * head_size;
-            // calculate the attention score as the dot product of q and k
+
+    // one pass over the chunk to fill the cache
+    memcpy(key_cache + (size_t)pos0 * kv_dim, key->data, (size_t)n_tok * kv_dim * sizeof(float));
+    memcpy(value_cache + (size_t)pos0 * kv_dim, value->data, (size_t)n_tok * kv_dim * sizeof(float));
+
+    const int R = MHA_PREFILL_QB * kv_mul;
+    float* s = (float*)MiCo_malloc((size_t)R * MHA_PREFILL_KB * sizeof(float));
+    float* m = (float*)MiCo_malloc((size_t)R * sizeof(float));
+    float* l = (float*)MiCo_malloc((size_t)R * sizeof(float));
+    float* kt = (float*)MiCo_malloc((size_t)head_size * MHA_PREFILL_KB * sizeof(float));
+    MiCo_assert(s != NULL && m != NULL && l != NULL && kt != NULL, "[MHA-Prefill] failed to allocate buffers");
+
+    for (int g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        const float* kc = key_cache + g * head_size;
+        const float* vc = value_cache + g * head_size;
+
+        for (int i0 = 0; i0 < n_tok; i0 += MHA_PREFILL_QB) {
+            MiCo_TRACE_SCOPE(MICO_TRACE_KERNEL, "prefill_block");
+            const int qb = (n_tok - i0) < MHA_PREFILL_QB ? (n_tok - i0) : MHA_PREFILL_QB;
+            // tile row r = i * kv_mul + j is token i0 + i, head h0 + j
+            for (int r = 0; r < qb * kv_mul; r++) {
+                m[r] = -INFINITY;
+                l[r] = 0.0f;
+            }
+            for (int i = 0; i < qb; i++) {
+                float* xb = output->data + (size_t)(i0 + i) * dim + h0 * head_size;
+                for (int x = 0; x < kv_mul * head_size; x++) {
+                    xb[x] = 0.0f;
+                }
+            }
+
+            const int t_end = pos0 + i0 + qb;   // causal bound of the last tile row
+            for (int t0 = 0; t0 < t_end; t0 += MHA_PREFILL_KB) {
+                const int kb = (t_end - t0) < MHA_PREFILL_KB ? (t_end - t0) : MHA_PREFILL_KB;
+
+                // S = Q K^T for the tile. K is transposed once per tile so
+                // every score row is a chain of unit-stride axpys over t.
+                for (int t = 0; t < kb; t++) {
+                    const float* k = kc + (size_t)(t0 + t) * kv_dim;
+                    for (int x = 0; x < head_size; x++) {
+                        kt[x * MHA_PREFILL_KB + t] = k[x];
+                    }
+                }
+                for (int i = 0; i < qb; i++) {
+                    const float* q = query->data + (size_t)(i0 + i) * dim + h0 * head_size;
+                    for (int j = 0; j < kv_mul; j++) {
+                        const float* qj = q + j * head_size;
+                        float* sr = s + (size_t)(i * kv_mul + j) * MHA_PREFILL_KB;
+                        for (int t = 0; t < kb; t++) {
+                            sr[t] = 0.0f;
+                        }
+                        for (int x = 0; x < head_size; x++) {
+                            const float a = qj[x] * scale;
+                            const float* ktx = kt + x * MHA_PREFILL_KB;
+                            for (int t = 0; t < kb; t++) {
+                                sr[t] += a * ktx[t];
+                            }
+                        }
+                    }
+                }
+
+                // online softmax over the visible (causal) prefix of each row,
+                // rescaling the running output and sum to the new max
+                for (int i = 0; i < qb; i++) {
+                    const int n_vis = pos0 + i0 + i + 1 - t0;
+                    const int n = n_vis < 0 ? 0 : (n_vis < kb ? n_vis : kb);
+                    for (int j = 0; j < kv_mul; j++) {
+                        const int r = i * kv_mul + j;
+                        float* sr = s + (size_t)r * MHA_PREFILL_KB;
+                        for (int t = n; t < kb; t++) {
+                            sr[t] = 0.0f;
+                        }
+                        if (n == 0) continue;
+                        float m_new = m[r];
+                        for (int t = 0; t < n; t++) {
+                            m_new = sr[t] > m_new ? sr[t] : m_new;
+                        }
+                        float sum = 0.0f;
+                        for (int t = 0; t < n; t++) {
+                            sr[t] = MiCo_fast_expf(sr[t] - m_new);
+                            sum += sr[t];
+                        }
+                        if (m[r] != m_new) {
+                            const float c = MiCo_fast_expf(m[r] - m_new);
+                            float* xbj = output->data + (size_t)(i0 + i) * dim + (h0 + j) * head_size;
+                            for (int x = 0; x < head_size; x++) {
+                                xbj[x] *= c;
+                            }
+                            l[r] *= c;
+                        }
+                        l[r] += sum;
+                        m[r] = m_new;
+                    }
+                }
+
+                // O += P V for the tile, each value row shared by all tile rows;
+                // masked entries of P are zero
+                for (int t = 0; t < kb; t++) {
+                    const float* v = vc + (size_t)(t0 + t) * kv_dim;
+                    for (int i = 0; i < qb; i++) {
+                        float* xb = output->data + (size_t)(i0 + i) * dim + h0 * head_size;
+                        for (int j = 0; j < kv_mul; j++) {
+                            const float a = s[(size_t)(i * kv_mul + j) * MHA_PREFILL_KB + t];
+                            float* xbj = xb + j * head_size;
+                            for (int x = 0; x < head_size; x++) {
+                                xbj[x] += a * v[x];
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (int i = 0; i < qb; i++) {
+                for (int j = 0; j < kv_mul; j++) {
+                    const float inv = 1.0f / l[i * kv_mul + j];
+                    float* xbj = output->data + (size_t)(i0 + i) * dim + (h0 + j) * head_size;
+                    for (int x = 0; x < head_size; x++) {
+                        xbj[x] *= inv;
+                    }
+                }
+            }
+        }
+    }
+
+    MiCo_free(s);
+    MiCo_free(m);
+    MiCo_free(l);
+    MiCo_free(kt);
+    ATTN_TIMER += MiCo_time() - start_time;
+    // Causal: token i attends to pos0 + i + 1 rows; the cache is read once
+    MiCo_ROOFLINE_END("multihead_attention_f32_prefill",
+        2 * (uint64_t)dim * ((uint64_t)n_tok * pos0 + (uint64_t)n_tok * (n_tok + 1) / 2), 32, 32,
+        2 * (size_t)(pos0 + n_tok) * kv_dim * 4 + 2 * (size_t)n_tok * dim * 4);
+}
+
+// INT8 cache counterparts of __mha_scores_f32 / __mha_values_f32, with one
+// scale per cache row. Under USE_INT8_Q the queries are pre-quantized
+// (q_int8, q_scale) and scored with integer dot products.
+static void __mha_scores_kv8(
+    float* att,                    // [kv_mul, seq_len] scores, segment offset applied
+    const float* q,                // [kv_mul, head_size] queries for this group
+    const int8_t* q_int8,          // [kv_mul, head_size] quantized queries (USE_INT8_Q)
+    const float* q_scale,          // [kv_mul] query scales (USE_INT8_Q)
+    const int8_t* key_rows,        // first key row, head offset already applied
+    const float* key_scales,       // scale of the first key row
+    const int n,
+    const MiCo_MHA_Config* cfg
+){
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const float attn_scale = 1.0f / sqrtf((float)head_size);
+
+    for (int t = 0; t < n; t++) {
+        // get the key vector for this KV head and at this timestep
+        const int8_t* k = key_rows + t * kv_dim;
+        // get the key scale for this timestep
+        const float k_scale = key_scales[t] * attn_scale;
+        // calculate the attention scores as the dot products of q and k
+        for (int j = 0; j < kv_mul; j++) {
+            #ifdef USE_INT8_Q
+            const int8_t* qj = q_int8 + j * head_size;
+            int32_t acc = 0;
+            for (int i = 0; i < head_size; i++) {
+                acc += (int32_t)qj[i] * (int32_t)k[i];
+            }
+            att[j * seq_len + t] = (float)acc * q_scale[j] * k_scale;
+            #else
+            const float* qj = q + j * head_size;
             float score = 0.0f;
             for (int i = 0; i < head_size; i++) {
-                score += q[i] * k[i];
+                score += qj[i] * k[i];
             }
-            score /= sqrtf(head_size);
             // save the score to the attention buffer
-            att[t] = score;
+            att[j * seq_len + t] = score * k_scale;
+            #endif
         }
+    }
+}
 
-        // softmax the scores to get attention weights, from 0..pos inclusively
-        softmax(att, pos + 1);
-
-        // weighted sum of the values, store back into xb
-        float* xb = output->data + h * head_size;
-        for(int i = 0; i < head_size; i++){
-            xb[i] = 0.0f;
-        }
+static void __mha_values_kv8(
+    float* xb,                     // [kv_mul, head_size] output for this group
+    const float* att,              // [kv_mul, seq_len] weights, segment offset applied
+    const int8_t* value_rows,      // first value row, head offset already applied
+    const float* value_scales,     // scale of the first value row
+    const int n,
+    const MiCo_MHA_Config* cfg
+){
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
 
-        for (int t = 0; t <= pos; t++) {
-            // get the value vector for this head and at this timestep
-            float* v = value_cache + t * kv_dim + (h / kv_mul) * head_size;
-            // get the attention weight for this timestep
-            float a = att[t];
-            // accumulate the weighted value into xb
+    for (int t = 0; t < n; t++) {
+        // get the value vector for this KV head and at this timestep
+        const int8_t* v = value_rows + t * kv_dim;
+        // get the value scale for this timestep
+        const float v_scale = value_scales[t];
+        // accumulate the weighted value into every head of the group
+        for (int j = 0; j < kv_mul; j++) {
+            const float av = att[j * seq_len + t] * v_scale;
+            float* xbj = xb + j * head_size;
             for (int i = 0; i < head_size; i++) {
-                xb[i] += a * v[i];
+                xbj[i] += av * v[i];
             }
         }
     }
-    ATTN_TIMER += MiCo_time() - start_time;
-    return;
 }
 
 void MiCo_multihead_attention_f32_kv8(
@@ -105,77 +462,409 @@ void MiCo_multihead_attention_f32_kv8(
     const int pos,                 // current position
     const MiCo_MHA_Config* cfg     // MHA configuration
 ){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32_kv8");
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+
+    // Query heads of one KV head share every K/V row load (see __mha_group_f32)
+    int g;
+    for (g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        // get the query vectors of this group
+        float* q = query->data + h0 * head_size;
+        // attention scores of this group
+        float* att = att_buffer + h0 * seq_len;
+        float* xb = output->data + h0 * head_size;
+
+        #ifdef USE_INT8_Q
+        int8_t q_int8[kv_mul * head_size];
+        float q_scale[kv_mul];
+        for (int j = 0; j < kv_mul; j++) {
+            q_scale[j] = __FP32toQ8((qbyte*)(q_int8 + j * head_size), q + j * head_size, head_size);
+        }
+        #else
+        const int8_t* q_int8 = NULL;
+        const float* q_scale = NULL;
+        #endif
+
+        // iterate over all timesteps, including the current one
+        __mha_scores_kv8(att, q, q_int8, q_scale, key_cache + g * head_size,
+            key_scales, pos + 1, cfg);
+
+        // softmax the scores to get attention weights, from 0..pos inclusively
+        for (int j = 0; j < kv_mul; j++) {
+            softmax(att + j * seq_len, pos + 1);
+        }
+
+        // weighted sum of the values, store back into xb
+        for(int i = 0; i < kv_mul * head_size; i++){
+            xb[i] = 0.0f;
+        }
+        __mha_values_kv8(xb, att, value_cache + g * head_size, value_scales, pos + 1, cfg);
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("multihead_attention_f32_kv8", 2 * n_heads * head_size * (pos + 1), MHA_RL_QBITS, 8,
+        2 * (size_t)(pos + 1) * (cfg->kv_dim + 4) + 2 * n_heads * head_size * 4);
+    return;
+}
+
+// Sliding-window attention with attention sinks.
+// The cache holds n_sink + window rows: rows [0, n_sink) pin the first
+// n_sink tokens, and the remaining rows are a ring buffer of the latest
+// window tokens. Memory and per-token work stay bounded however large pos
+// grows. The attended rows form at most three contiguous segments (sinks,
+// ring tail, ring head), walked in logical order without copying.
+
+int MiCo_window_slot(const MiCo_MHA_Window* win, const int pos){
+    if (pos < win->n_sink) return pos;
+    return win->n_sink + (pos - win->n_sink) % win->window;
+}
+
+// Split the attended positions of pos into contiguous cache row segments,
+// returns the number of segments and the total length in *len.
+static int __window_segments(const MiCo_MHA_Window* win, const int pos,
+    int* seg_row, int* seg_len, int* len){
+    const int n_sink = win->n_sink;
+    int n_seg = 0;
+    int total = 0;
+
+    const int sinks = pos + 1 < n_sink ? pos + 1 : n_sink;
+    if (sinks > 0) {
+        seg_row[n_seg] = 0;
+        seg_len[n_seg++] = sinks;
+        total += sinks;
+    }
+    if (pos >= n_sink) {
+        int start = pos - win->window + 1;
+        start = start > n_sink ? start : n_sink;
+        const int recent = pos - start + 1;
+        const int r0 = MiCo_window_slot(win, start);
+        const int tail = n_sink + win->window - r0;
+        seg_row[n_seg] = r0;
+        seg_len[n_seg++] = recent < tail ? recent : tail;
+        if (recent > tail) {
+            seg_row[n_seg] = n_sink;
+            seg_len[n_seg++] = recent - tail;
+        }
+        total += recent;
+    }
+    *len = total;
+    return n_seg;
+}
+
+void MiCo_multihead_attention_f32_window(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    float* key_cache,              // [n_sink + window, kv_dim] key ring buffer
+    float* value_cache,            // [n_sink + window, kv_dim] value ring buffer
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current (unbounded) position
+    const MiCo_MHA_Window* win,    // window configuration
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32_window");
     const int n_heads = cfg->n_heads;
     const int head_size = cfg->head_size;
     const int kv_dim = cfg->kv_dim;
     const int kv_mul = cfg->kv_mul;
     const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
 
-    const float attn_scale = 1.0f / sqrtf((float)head_size);
+    MiCo_assert(win->window > 0 && seq_len >= win->n_sink + win->window,
+        "[MHA-Window] seq_len must cover n_sink + window");
 
-    // Temporary bias (none)
-    Tensor1D_F32 Tb = { .shape = {0}, .data = NULL };
+    int seg_row[3], seg_len[3], len;
+    const int n_seg = __window_segments(win, pos, seg_row, seg_len, &len);
 
+    MiCo_ROOFLINE_BEGIN();
     long start_time = MiCo_time();
+    int g;
+    for (g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        float* q = query->data + h0 * head_size;
+        float* att = att_buffer + h0 * seq_len;
+        float* xb = output->data + h0 * head_size;
+
+        for (int s = 0, off = 0; s < n_seg; off += seg_len[s++]) {
+            __mha_scores_f32(att + off, q, key_cache + seg_row[s] * kv_dim + g * head_size,
+                seg_len[s], cfg);
+        }
+        for (int j = 0; j < kv_mul; j++) {
+            softmax(att + j * seq_len, len);
+        }
+        for (int i = 0; i < kv_mul * head_size; i++) {
+            xb[i] = 0.0f;
+        }
+        for (int s = 0, off = 0; s < n_seg; off += seg_len[s++]) {
+            __mha_values_f32(xb, att + off, value_cache + seg_row[s] * kv_dim + g * head_size,
+                seg_len[s], cfg);
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("multihead_attention_f32_window", 2 * n_heads * head_size * len, 32, 32,
+        2 * (size_t)len * kv_dim * 4 + 2 * n_heads * head_size * 4);
+}
+
+void MiCo_multihead_attention_f32_kv8_window(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    int8_t* key_cache,             // [n_sink + window, kv_dim] key ring buffer
+    int8_t* value_cache,           // [n_sink + window, kv_dim] value ring buffer
+    float* key_scales,             // [n_sink + window] key scales
+    float* value_scales,           // [n_sink + window] value scales
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current (unbounded) position
+    const MiCo_MHA_Window* win,    // window configuration
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32_kv8_window");
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+    const int n_kv_heads = n_heads / kv_mul;
+
+    MiCo_assert(win->window > 0 && seq_len >= win->n_sink + win->window,
+        "[MHA-Window] seq_len must cover n_sink + window");
+
+    int seg_row[3], seg_len[3], len;
+    const int n_seg = __window_segments(win, pos, seg_row, seg_len, &len);
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    int g;
+    for (g = 0; g < n_kv_heads; g++) {
+        const int h0 = g * kv_mul;
+        float* q = query->data + h0 * head_size;
+        float* att = att_buffer + h0 * seq_len;
+        float* xb = output->data + h0 * head_size;
 
-    int h;
-    for (h = 0; h < n_heads; h++) {
-        int kv_head = h / kv_mul;
-        // get the query vector for this head
-        float* q = query->data + h * head_size;
-        // attention scores for this head
-        float* att = att_buffer + h * seq_len;
-        float* xb = output->data + h * head_size;
-        
         #ifdef USE_INT8_Q
-        int8_t q_int8[head_size];
-        float q_scale = __FP32toQ8((qbyte*)q_int8, q, head_size);
-        for (int t = 0; t <= pos; t++) {
-            int8_t* k = key_cache + t * kv_dim + (h / kv_mul) * head_size;
-            int32_t acc = 0;
-            for (int i = 0; i < head_size; i++) {
-                acc += (int32_t)q_int8[i] * (int32_t)k[i];
-            }
-            att[t] = (float)acc * q_scale * key_scales[t] * attn_scale;
+        int8_t q_int8[kv_mul * head_size];
+        float q_scale[kv_mul];
+        for (int j = 0; j < kv_mul; j++) {
+            q_scale[j] = __FP32toQ8((qbyte*)(q_int8 + j * head_size), q + j * head_size, head_size);
         }
         #else
-        // iterate over all timesteps, including the current one
+        const int8_t* q_int8 = NULL;
+        const float* q_scale = NULL;
+        #endif
+
+        for (int s = 0, off = 0; s < n_seg; off += seg_len[s++]) {
+            __mha_scores_kv8(att + off, q, q_int8, q_scale,
+                key_cache + seg_row[s] * kv_dim + g * head_size,
+                key_scales + seg_row[s], seg_len[s], cfg);
+        }
+        for (int j = 0; j < kv_mul; j++) {
+            softmax(att + j * seq_len, len);
+        }
+        for (int i = 0; i < kv_mul * head_size; i++) {
+            xb[i] = 0.0f;
+        }
+        for (int s = 0, off = 0; s < n_seg; off += seg_len[s++]) {
+            __mha_values_kv8(xb, att + off, value_cache + seg_row[s] * kv_dim + g * head_size,
+                value_scales + seg_row[s], seg_len[s], cfg);
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("multihead_attention_f32_kv8_window", 2 * n_heads * head_size * len, MHA_RL_QBITS, 8,
+        2 * (size_t)len * (kv_dim + 4) + 2 * n_heads * head_size * 4);
+}
+
+// Packed low-bit KV cache (4-bit / 2-bit)
+// Each cache row holds kv_dim elements packed in the same order as the
+// activation quantizers: element i sits in byte (i * bits / 8) at bit
+// offset (i * bits) % 8. Scales are stored per (timestep, group), with
+// kv_dim / group_size groups per timestep; group_size == head_size gives
+// one scale per (timestep, kv head).
+
+void MiCo_kv_cache_store_q(
+    qbyte* cache,                  // packed cache buffer
+    float* scales,                 // [seq_len, kv_dim / group_size] scales buffer
+    const float* x,                // [kv_dim] key or value vector to store
+    const int pos,                 // timestep to write
+    const int kv_dim,              // key-value dimension
+    const int group_size,          // elements sharing one scale
+    const qtype bits               // 4 or 2
+){
+    MiCo_assert(bits == 4 || bits == 2, "[KVCache] only 4-bit and 2-bit KV cache is supported");
+    MiCo_assert(kv_dim % group_size == 0, "[KVCache] kv_dim must be divisible by group_size");
+    MiCo_assert((group_size * bits) % 8 == 0, "[KVCache] group must fill whole bytes");
+
+    const int n_groups = kv_dim / group_size;
+    const int per_byte = 8 / bits;
+    const int qmax = (1 << (bits - 1)) - 1;
+    const int qmin = -qmax - 1;
+    const qbyte mask = (1 << bits) - 1;
+
+    qbyte* row = cache + (size_t)pos * kv_dim / per_byte;
+    float* row_scales = scales + (size_t)pos * n_groups;
+
+    for (int g = 0; g < n_groups; g++){
+        const float* xg = x + g * group_size;
+        qbyte* qg = row + g * group_size / per_byte;
+        float absmax = 0.0f;
+        for (int i = 0; i < group_size; i++){
+            float a = fabsf(xg[i]);
+            if (a > absmax) absmax = a;
+        }
+        float scale = absmax / (float)qmax;
+        float inv_scale = absmax > 0.0f ? 1.0f / scale : 0.0f;
+        row_scales[g] = scale;
+
+        for (int i = 0; i < group_size; i += per_byte){
+            qbyte packed = 0;
+            for (int j = 0; j < per_byte; j++){
+                int q = (int)roundf(xg[i + j] * inv_scale);
+                q = CLAMP(q, qmin, qmax);
+                packed |= (q & mask) << (j * bits);
+            }
+            qg[i / per_byte] = packed;
+        }
+    }
+}
+
+// Dot product of an FP32 vector with a packed signed 4/2-bit vector
+__attribute__((weak)) float MiCo_kvq_dot_f32(const float* q, const qbyte* k,
+    const int n, const qtype bits){
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    if (bits == 4){
+        for (int i = 0; i < n; i += 4){
+            qbyte b0 = k[i / 2];
+            qbyte b1 = k[i / 2 + 1];
+            s0 += q[i]     * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b0, 0), 4);
+            s1 += q[i + 1] * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b0, 1), 4);
+            s2 += q[i + 2] * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b1, 0), 4);
+            s3 += q[i + 3] * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b1, 1), 4);
+        }
+    } else {
+        for (int i = 0; i < n; i += 4){
+            qbyte b = k[i / 4];
+            s0 += q[i]     * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 0), 2);
+            s1 += q[i + 1] * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 1), 2);
+            s2 += q[i + 2] * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 2), 2);
+            s3 += q[i + 3] * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 3), 2);
+        }
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+// y += a * dequant(v) for a packed signed 4/2-bit vector
+__attribute__((weak)) void MiCo_kvq_axpy_f32(float* y, const float a, const qbyte* v,
+    const int n, const qtype bits){
+    if (bits == 4){
+        for (int i = 0; i < n; i += 4){
+            qbyte b0 = v[i / 2];
+            qbyte b1 = v[i / 2 + 1];
+            y[i]     += a * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b0, 0), 4);
+            y[i + 1] += a * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b0, 1), 4);
+            y[i + 2] += a * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b1, 0), 4);
+            y[i + 3] += a * SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(b1, 1), 4);
+        }
+    } else {
+        for (int i = 0; i < n; i += 4){
+            qbyte b = v[i / 4];
+            y[i]     += a * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 0), 2);
+            y[i + 1] += a * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 1), 2);
+            y[i + 2] += a * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 2), 2);
+            y[i + 3] += a * SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(b, 3), 2);
+        }
+    }
+}
+
+void MiCo_multihead_attention_f32_kvq(
+    Tensor2D_F32* output,           // [n_heads, head_size] - output buffer
+    const Tensor2D_F32* query,     // [n_heads, head_size] - query vectors
+    qbyte* key_cache,              // packed key cache buffer (layer offset already applied)
+    qbyte* value_cache,            // packed value cache buffer (layer offset already applied)
+    float* key_scales,             // key scales, layout: (seq_len, kv_dim / group_size)
+    float* value_scales,           // value scales, layout: (seq_len, kv_dim / group_size)
+    float* att_buffer,             // [n_heads, seq_len] - attention scores buffer
+    const int pos,                 // current position
+    const int group_size,          // elements sharing one scale (divides head_size)
+    const qtype kv_bits,           // 4 or 2
+    const MiCo_MHA_Config* cfg     // MHA configuration
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "multihead_attention_f32_kvq");
+    const int n_heads = cfg->n_heads;
+    const int head_size = cfg->head_size;
+    const int kv_dim = cfg->kv_dim;
+    const int kv_mul = cfg->kv_mul;
+    const int seq_len = cfg->seq_len;
+
+    MiCo_assert(kv_bits == 4 || kv_bits == 2, "[MHA-KVQ] only 4-bit and 2-bit KV cache is supported");
+    MiCo_assert(head_size % group_size == 0, "[MHA-KVQ] head_size must be divisible by group_size");
+    MiCo_assert(group_size % 4 == 0, "[MHA-KVQ] group_size must be a multiple of 4");
+
+    const float attn_scale = 1.0f / sqrtf((float)head_size);
+    const int per_byte = 8 / kv_bits;
+    const size_t row_bytes = (size_t)kv_dim / per_byte;
+    const int n_groups = kv_dim / group_size;
+    const int head_groups = head_size / group_size;
+    const size_t group_bytes = (size_t)group_size / per_byte;
+
+    const int n_kv_heads = n_heads / kv_mul;
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+
+    // Query heads of one KV head share every K/V row load (see __mha_group_f32)
+    int kv_head;
+    for (kv_head = 0; kv_head < n_kv_heads; kv_head++) {
+        const int h0 = kv_head * kv_mul;
+        const int g0 = kv_head * head_groups;
+        // get the query vectors of this group
+        float* q = query->data + h0 * head_size;
+        // attention scores of this group
+        float* att = att_buffer + h0 * seq_len;
+        float* xb = output->data + h0 * head_size;
+
         for (int t = 0; t <= pos; t++) {
-            // get the key vector for this head and at this timestep
-            int8_t* k = key_cache + t * kv_dim + kv_head * head_size;
-            // get the key scale for this timestep
-            float k_scale = key_scales[t];
-            // calculate the attention score as the dot product of q and k
-            float score = 0.0f;
-            for (int i = 0; i < head_size; i++) {
-                score += (q[i] * k[i]) * k_scale;
+            const qbyte* k = key_cache + t * row_bytes + g0 * group_bytes;
+            const float* k_scale = key_scales + (size_t)t * n_groups + g0;
+            for (int j = 0; j < kv_mul; j++) {
+                const float* qj = q + j * head_size;
+                float score = 0.0f;
+                for (int g = 0; g < head_groups; g++) {
+                    score += k_scale[g] * MiCo_kvq_dot_f32(qj + g * group_size,
+                        k + g * group_bytes, group_size, kv_bits);
+                }
+                att[j * seq_len + t] = score * attn_scale;
             }
-            score *= attn_scale;
-            // save the score to the attention buffer
-            att[t] = score;
         }
-        #endif
+
         // softmax the scores to get attention weights, from 0..pos inclusively
-        softmax(att, pos + 1);
+        for (int j = 0; j < kv_mul; j++) {
+            softmax(att + j * seq_len, pos + 1);
+        }
 
         // weighted sum of the values, store back into xb
-        for(int i = 0; i < head_size; i++){
+        for(int i = 0; i < kv_mul * head_size; i++){
             xb[i] = 0.0f;
         }
 
         for (int t = 0; t <= pos; t++) {
-            // get the value vector for this head and at this timestep
-            int8_t* v = value_cache + t * kv_dim + kv_head * head_size;
-            // get the value scale for this timestep
-            float v_scale = value_scales[t];
-            // get the attention weight for this timestep
-            float av = att[t] * value_scales[t];
-            // accumulate the weighted value into xb
-            for (int i = 0; i < head_size; i++) {
-                xb[i] += av * v[i];
+            const qbyte* v = value_cache + t * row_bytes + g0 * group_bytes;
+            const float* v_scale = value_scales + (size_t)t * n_groups + g0;
+            for (int j = 0; j < kv_mul; j++) {
+                const float a = att[j * seq_len + t];
+                float* xbj = xb + j * head_size;
+                for (int g = 0; g < head_groups; g++) {
+                    MiCo_kvq_axpy_f32(xbj + g * group_size, a * v_scale[g],
+                        v + g * group_bytes, group_size, kv_bits);
+                }
             }
         }
     }
     ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("multihead_attention_f32_kvq", 2 * n_heads * head_size * (pos + 1), 32, kv_bits,
+        2 * (size_t)(pos + 1) * (row_bytes + n_groups * 4) + 2 * n_heads * head_size * 4);
     return;
-}
\ No newline at end of file
+}
@@ -1,10 +1,12 @@
 #include "nn.h"
+#include "profile.h"
 #include <math.h>
 
 void MiCo_batchnorm2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const Tensor1D_F32 *weight, Tensor1D_F32 *bias, 
     Tensor1D_F32 *mean, const Tensor1D_F32 *var, 
     const float eps){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "batchnorm2d_f32");
     size_t batch_size = x->shape[0];
     #ifdef USE_ALT_LAYOUT
     size_t in_h = x->shape[1];
@@ -44,6 +46,7 @@ void MiCo_batchnorm2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
 }
 
 void MiCo_simple_rmsnorm2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "simple_rmsnorm2d_f32");
     size_t b = x->shape[0];
     size_t n = x->shape[1];
 
@@ -64,6 +67,7 @@ void MiCo_simple_rmsnorm2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
 }
 
 void MiCo_simple_rmsnorm3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "simple_rmsnorm3d_f32");
     size_t b = x->shape[0];
     size_t c = x->shape[1];
     size_t n = x->shape[2];
@@ -86,6 +90,7 @@ void MiCo_simple_rmsnorm3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x){
 }
 
 void MiCo_simple_rmsnorm4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "simple_rmsnorm4d_f32");
     size_t batch_size = x->shape[0];
     #ifdef USE_ALT_LAYOUT
     size_t in_h = x->shape[1];
@@ -122,6 +127,7 @@ void MiCo_simple_rmsnorm4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x){
 
 void MiCo_rmsnorm2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, 
     const Tensor1D_F32 *weight, const float eps){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "rmsnorm2d_f32");
     size_t batch_size = x->shape[0];
     size_t dim_size = x->shape[1];
 
@@ -142,6 +148,7 @@ void MiCo_rmsnorm2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x,
 void MiCo_layernorm2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x,
     const Tensor1D_F32 *weight, const Tensor1D_F32 *bias,
     const size_t normalized_dim, const float eps){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "layernorm2d_f32");
     const size_t batch_size = x->shape[0];
     MiCo_assert(x->shape[1] == normalized_dim, "[LayerNorm2D] normalized_dim mismatch");
     for (size_t b = 0; b < batch_size; b++){
@@ -170,6 +177,7 @@ void MiCo_layernorm2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x,
 void MiCo_layernorm3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
     const Tensor1D_F32 *weight, const Tensor1D_F32 *bias,
     const size_t normalized_dim, const float eps){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "layernorm3d_f32");
     const size_t batch_size = x->shape[0];
     const size_t seq_len = x->shape[1];
     MiCo_assert(x->shape[2] == normalized_dim, "[LayerNorm3D] normalized_dim mismatch");
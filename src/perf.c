@@ -0,0 +1,363 @@
+#include "profile.h"
+
+#ifdef RISCV_VEXII
+#include "sim_stdlib.h"
+#else
+#include <stdio.h>
+#endif
+
+// Hardware counters per trace region (Linux perf_event_open).
+// Every region opened by MiCo_trace_begin reads the calling thread's
+// counter group on entry and exit; the deltas are accumulated per region
+// name, inclusive of nested regions. MACs reported with MiCo_PERF_MACS go
+// to the innermost open region and are added to its parents on exit.
+
+#if defined(MICO_PERF) && defined(__linux__)
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define MICO_PERF_MAX_DEPTH 64
+#define MICO_PERF_MAX_NAMES 128
+
+static const char* perf_counter_names[MICO_PERF_N_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+typedef struct {
+    const char* name;
+    uint64_t calls;
+    uint64_t ns;
+    uint64_t macs;
+    uint64_t counter[MICO_PERF_N_COUNTERS];
+} __perf_stat;
+
+typedef struct {
+    const char* name;
+    uint64_t ts;
+    uint64_t macs;
+    uint64_t counter[MICO_PERF_N_COUNTERS];
+} __perf_frame;
+
+typedef struct {
+    int leader;
+    int fd[MICO_PERF_N_COUNTERS];       // event fds, -1 if absent
+    int slot[MICO_PERF_N_COUNTERS];     // position in the group read, -1 if absent
+    int n_open;
+    int generation;                     // perf_generation the group was opened in
+    int depth;
+    __perf_frame stack[MICO_PERF_MAX_DEPTH];
+    __perf_stat stat[MICO_PERF_MAX_NAMES];
+    int n_stat;
+} __perf_thread;
+
+static __perf_thread* perf_threads[MICO_TRACE_MAX_THREADS];
+static int perf_n_threads = 0;
+static int perf_mode = -1;      // -1: not chosen yet
+static int perf_active_mode = MICO_PERF_OFF;
+static int perf_errno = 0;      // why the last open failed
+static int perf_generation = 0; // bumped when the groups are torn down
+
+static __thread __perf_thread* perf_tl = NULL;
+
+int MiCo_perf_mode(){
+    return perf_active_mode;
+}
+
+static int __perf_open(const uint32_t type, const uint64_t config, const int group, const int pinned){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = group == -1;
+    attr.pinned = pinned;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+        PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+    if (fd < 0) perf_errno = errno;
+    return fd;
+}
+
+// Open the counter group of the calling thread. HW mode falls back to
+// the instruction counter alone, and that to no counters at all.
+static void __perf_open_thread(__perf_thread* t){
+    static const struct { uint32_t type; uint64_t config; } ev[MICO_PERF_N_COUNTERS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    if (perf_mode < 0){
+        const char* env = getenv("MICO_PERF_MODE");
+        perf_mode = env != NULL && !strcmp(env, "instr") ? MICO_PERF_INSTR : MICO_PERF_HW;
+    }
+    for (int c = 0; c < MICO_PERF_N_COUNTERS; c++){
+        t->fd[c] = -1;
+        t->slot[c] = -1;
+    }
+    t->leader = -1;
+    t->n_open = 0;
+    t->generation = perf_generation;
+
+    if (perf_mode == MICO_PERF_HW){
+        t->leader = __perf_open(ev[0].type, ev[0].config, -1, 0);
+        if (t->leader >= 0){
+            t->fd[0] = t->leader;
+            t->slot[0] = t->n_open++;
+            for (int c = 1; c < MICO_PERF_N_COUNTERS; c++){
+                t->fd[c] = __perf_open(ev[c].type, ev[c].config, t->leader, 0);
+                if (t->fd[c] >= 0) t->slot[c] = t->n_open++;
+            }
+            perf_active_mode = MICO_PERF_HW;
+        }
+    }
+    if (t->leader < 0 && perf_mode != MICO_PERF_OFF){
+        // Deterministic mode: user-space instructions only, never multiplexed
+        t->leader = __perf_open(ev[1].type, ev[1].config, -1, 1);
+        if (t->leader >= 0){
+            t->fd[1] = t->leader;
+            t->slot[1] = t->n_open++;
+            if (perf_active_mode == MICO_PERF_OFF) perf_active_mode = MICO_PERF_INSTR;
+        }
+    }
+    if (t->leader >= 0){
+        ioctl(t->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(t->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+// Tear down the counter group, siblings before the leader
+static void __perf_close_thread(__perf_thread* t){
+    for (int c = 0; c < MICO_PERF_N_COUNTERS; c++){
+        if (t->fd[c] >= 0 && t->fd[c] != t->leader) close(t->fd[c]);
+        t->fd[c] = -1;
+        t->slot[c] = -1;
+    }
+    if (t->leader >= 0) close(t->leader);
+    t->leader = -1;
+    t->n_open = 0;
+}
+
+// A new mode closes every thread's group; each thread reopens its own on
+// its next region, since perf_event_open only attaches to the caller.
+void MiCo_perf_set_mode(const int mode){
+    const int n = perf_n_threads < MICO_TRACE_MAX_THREADS ? perf_n_threads : MICO_TRACE_MAX_THREADS;
+    perf_mode = mode;
+    perf_active_mode = MICO_PERF_OFF;
+    perf_generation++;
+    for (int th = 0; th < n; th++){
+        if (perf_threads[th] != NULL) __perf_close_thread(perf_threads[th]);
+    }
+}
+
+static __perf_thread* __perf_get_thread(){
+    if (perf_tl != NULL && perf_tl->generation != perf_generation){
+        __perf_open_thread(perf_tl);
+    }
+    if (perf_tl == NULL){
+        const int id = __atomic_fetch_add(&perf_n_threads, 1, __ATOMIC_RELAXED);
+        if (id >= MICO_TRACE_MAX_THREADS) return NULL;
+        __perf_thread* t = calloc(1, sizeof(__perf_thread));
+        if (t == NULL) return NULL;
+        __perf_open_thread(t);
+        perf_threads[id] = t;
+        perf_tl = t;
+    }
+    return perf_tl;
+}
+
+// Group read, scaled up when the kernel multiplexed the counters
+static void __perf_read(const __perf_thread* t, uint64_t* counter){
+    uint64_t buf[3 + MICO_PERF_N_COUNTERS];
+    memset(counter, 0, MICO_PERF_N_COUNTERS * sizeof(uint64_t));
+    if (t->leader < 0) return;
+    if (read(t->leader, buf, (3 + t->n_open) * sizeof(uint64_t)) <= 0) return;
+    const uint64_t enabled = buf[1], running = buf[2];
+    for (int c = 0; c < MICO_PERF_N_COUNTERS; c++){
+        if (t->slot[c] < 0) continue;
+        uint64_t v = buf[3 + t->slot[c]];
+        if (running > 0 && running < enabled) v = (uint64_t)((double)v * enabled / running);
+        counter[c] = v;
+    }
+}
+
+void __MiCo_perf_begin(const char* name){
+    __perf_thread* t = __perf_get_thread();
+    if (t == NULL) return;
+    if (t->depth < MICO_PERF_MAX_DEPTH){
+        __perf_frame* f = &t->stack[t->depth];
+        f->name = name;
+        f->macs = 0;
+        __perf_read(t, f->counter);
+        f->ts = MiCo_trace_clock();
+    }
+    t->depth++;
+}
+
+void __MiCo_perf_end(){
+    __perf_thread* t = perf_tl;
+    if (t == NULL || t->depth == 0) return;
+    t->depth--;
+    if (t->depth >= MICO_PERF_MAX_DEPTH) return;
+    const uint64_t ts = MiCo_trace_clock();
+    uint64_t counter[MICO_PERF_N_COUNTERS];
+    __perf_read(t, counter);
+
+    const __perf_frame* f = &t->stack[t->depth];
+    int i = 0;
+    while (i < t->n_stat && t->stat[i].name != f->name && strcmp(t->stat[i].name, f->name)) i++;
+    if (i == t->n_stat){
+        if (t->n_stat == MICO_PERF_MAX_NAMES) return;
+        memset(&t->stat[i], 0, sizeof(__perf_stat));
+        t->stat[i].name = f->name;
+        t->n_stat++;
+    }
+    __perf_stat* s = &t->stat[i];
+    s->calls++;
+    s->ns += (ts - f->ts) * 1000 / MiCo_trace_ticks_per_us();
+    s->macs += f->macs;
+    for (int c = 0; c < MICO_PERF_N_COUNTERS; c++){
+        s->counter[c] += counter[c] - f->counter[c];
+    }
+    if (t->depth > 0) t->stack[t->depth - 1].macs += f->macs;
+}
+
+void __MiCo_perf_macs(const uint64_t macs){
+    __perf_thread* t = perf_tl;
+    if (t == NULL || t->depth == 0 || t->depth > MICO_PERF_MAX_DEPTH) return;
+    t->stack[t->depth - 1].macs += macs;
+}
+
+void MiCo_perf_reset(){
+    const int n = perf_n_threads < MICO_TRACE_MAX_THREADS ? perf_n_threads : MICO_TRACE_MAX_THREADS;
+    for (int th = 0; th < n; th++){
+        if (perf_threads[th] != NULL) perf_threads[th]->n_stat = 0;
+    }
+}
+
+// Merge the per-thread tables by region name
+static int __perf_merge(__perf_stat* out){
+    int n_out = 0;
+    const int n = perf_n_threads < MICO_TRACE_MAX_THREADS ? perf_n_threads : MICO_TRACE_MAX_THREADS;
+    for (int th = 0; th < n; th++){
+        const __perf_thread* t = perf_threads[th];
+        if (t == NULL) continue;
+        for (int i = 0; i < t->n_stat; i++){
+            int j = 0;
+            while (j < n_out && strcmp(out[j].name, t->stat[i].name)) j++;
+            if (j == n_out){
+                if (n_out == MICO_PERF_MAX_NAMES) continue;
+                memset(&out[j], 0, sizeof(__perf_stat));
+                out[j].name = t->stat[i].name;
+                n_out++;
+            }
+            out[j].calls += t->stat[i].calls;
+            out[j].ns += t->stat[i].ns;
+            out[j].macs += t->stat[i].macs;
+            for (int c = 0; c < MICO_PERF_N_COUNTERS; c++){
+                out[j].counter[c] += t->stat[i].counter[c];
+            }
+        }
+    }
+    return n_out;
+}
+
+static double __per_kmac(const uint64_t v, const uint64_t macs){
+    return macs > 0 ? (double)v * 1000.0 / macs : 0.0;
+}
+
+void MiCo_perf_print_report(){
+    static __perf_stat s[MICO_PERF_MAX_NAMES];
+    const int n = __perf_merge(s);
+    if (perf_active_mode == MICO_PERF_OFF){
+        printf("[Perf] mode: off, perf_event_open: %s\n", perf_errno ? strerror(perf_errno) : "not used");
+    } else {
+        printf("[Perf] mode: %s\n", perf_active_mode == MICO_PERF_HW ? "hw" : "instr");
+    }
+    printf("[Perf] %-24s %6s %10s %12s %12s %5s %10s %10s %10s %12s %9s %9s %9s\n",
+        "region", "calls", "time(us)", "cycles", "instr", "IPC", "l1d_miss", "llc_miss",
+        "br_miss", "MACs", "l1d/kMAC", "llc/kMAC", "ins/MAC");
+    for (int i = 0; i < n; i++){
+        const uint64_t* c = s[i].counter;
+        printf("[Perf] %-24s %6lu %10.1f %12lu %12lu %5.2f %10lu %10lu %10lu %12lu %9.2f %9.2f %9.3f\n",
+            s[i].name, (unsigned long)s[i].calls, s[i].ns / 1000.0,
+            (unsigned long)c[MICO_PERF_CYCLES], (unsigned long)c[MICO_PERF_INSTRUCTIONS],
+            c[MICO_PERF_CYCLES] ? (double)c[MICO_PERF_INSTRUCTIONS] / c[MICO_PERF_CYCLES] : 0.0,
+            (unsigned long)c[MICO_PERF_L1D_MISSES], (unsigned long)c[MICO_PERF_LLC_MISSES],
+            (unsigned long)c[MICO_PERF_BRANCH_MISSES], (unsigned long)s[i].macs,
+            __per_kmac(c[MICO_PERF_L1D_MISSES], s[i].macs),
+            __per_kmac(c[MICO_PERF_LLC_MISSES], s[i].macs),
+            s[i].macs ? (double)c[MICO_PERF_INSTRUCTIONS] / s[i].macs : 0.0);
+    }
+}
+
+int MiCo_perf_dump_csv(const char* path){
+    static __perf_stat s[MICO_PERF_MAX_NAMES];
+    const int n = __perf_merge(s);
+    FILE* f = fopen(path, "w");
+    if (f == NULL){
+        printf("[Perf] cannot open %s\n", path);
+        return -1;
+    }
+    fprintf(f, "region,calls,ns,macs");
+    for (int c = 0; c < MICO_PERF_N_COUNTERS; c++) fprintf(f, ",%s", perf_counter_names[c]);
+    fprintf(f, ",ipc,l1d_per_kmac,llc_per_kmac,instr_per_mac\n");
+    for (int i = 0; i < n; i++){
+        const uint64_t* c = s[i].counter;
+        fprintf(f, "%s,%lu,%lu,%lu", s[i].name, (unsigned long)s[i].calls,
+            (unsigned long)s[i].ns, (unsigned long)s[i].macs);
+        for (int k = 0; k < MICO_PERF_N_COUNTERS; k++) fprintf(f, ",%lu", (unsigned long)c[k]);
+        fprintf(f, ",%.4f,%.4f,%.4f,%.4f\n",
+            c[MICO_PERF_CYCLES] ? (double)c[MICO_PERF_INSTRUCTIONS] / c[MICO_PERF_CYCLES] : 0.0,
+            __per_kmac(c[MICO_PERF_L1D_MISSES], s[i].macs),
+            __per_kmac(c[MICO_PERF_LLC_MISSES], s[i].macs),
+            s[i].macs ? (double)c[MICO_PERF_INSTRUCTIONS] / s[i].macs : 0.0);
+    }
+    fclose(f);
+    return 0;
+}
+
+#else
+
+void MiCo_perf_set_mode(const int mode){
+    (void)mode;
+}
+
+int MiCo_perf_mode(){
+    return MICO_PERF_OFF;
+}
+
+void MiCo_perf_reset(){
+}
+
+void __MiCo_perf_begin(const char* name){
+    (void)name;
+}
+
+void __MiCo_perf_end(){
+}
+
+void __MiCo_perf_macs(const uint64_t macs){
+    (void)macs;
+}
+
+void MiCo_perf_print_report(){
+    printf("[Perf] hardware counters are disabled (build with PERF=1 on Linux)\n");
+}
+
+int MiCo_perf_dump_csv(const char* path){
+    (void)path;
+    return -1;
+}
+
+#endif
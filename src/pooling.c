@@ -1,7 +1,9 @@
 #include "nn.h"
+#include "profile.h"
 
 void MiCo_avgpool4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const size_t k_size, const size_t stride, const size_t padding){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "avgpool4d_f32");
     
     size_t batch_size = x->shape[0];
     #ifdef USE_ALT_LAYOUT
@@ -65,6 +67,7 @@ void MiCo_avgpool4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
 
 void MiCo_maxpool4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const size_t k_size, const size_t stride, const size_t padding){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "maxpool4d_f32");
     
     size_t batch_size = x->shape[0];
     #ifdef USE_ALT_LAYOUT
@@ -145,6 +148,7 @@ void MiCo_adaptive_avgpool4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
 // 1D Pooling Functions with Layout NCL (Batch, Channels, Length)
 void MiCo_avgpool3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, 
     const size_t k_size, const size_t stride, const size_t padding){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "avgpool3d_f32");
     
     size_t batch_size = x->shape[0];
     size_t in_c = x->shape[1];
@@ -184,6 +188,7 @@ void MiCo_avgpool3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
 
 void MiCo_maxpool3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, 
     const size_t k_size, const size_t stride, const size_t padding){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "maxpool3d_f32");
     
     size_t batch_size = x->shape[0];
     size_t in_c = x->shape[1];
@@ -9,7 +9,10 @@
 
 __attribute__((weak)) long int MiCo_time(){
     #ifdef USE_HOST
-    return clock() / (CLOCKS_PER_SEC / 1000000); // Convert to ms
+    // Monotonic wall clock in us; clock() ticks too coarsely for per-layer timing
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
     #else
     #ifdef USE_CHIPYARD
     unsigned long cycles;
@@ -1,6 +1,8 @@
 #include "nn.h"
+#include "profile.h"
 
 void MiCo_relu2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
+  MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "relu2d_f32");
   const size_t n = y->shape[0] * y->shape[1];
   for (size_t i = 0; i < n; i += 1) {
     float x_val = x->data[i];
@@ -8,6 +10,7 @@ void MiCo_relu2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
   }
 }
 void MiCo_relu3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x){
+  MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "relu3d_f32");
   const size_t n = y->shape[0] * y->shape[1] * y->shape[2];
   for (size_t i = 0; i < n; i += 1) {
     float x_val = x->data[i];
@@ -15,6 +18,7 @@ void MiCo_relu3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x){
   }
 }
 void MiCo_relu4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x){
+  MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "relu4d_f32");
   const size_t n = y->shape[0] * y->shape[1] * y->shape[2] * y->shape[3];
   for (size_t i = 0; i < n; i += 1) {
     float x_val = x->data[i];
@@ -24,6 +28,7 @@ void MiCo_relu4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x){
 
 // ReLU 6
 void MiCo_relu62d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
+  MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "relu62d_f32");
   const size_t n = y->shape[0] * y->shape[1];
   for (size_t i = 0; i < n; i += 1) {
     float x_val = x->data[i];
@@ -32,6 +37,7 @@ void MiCo_relu62d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
 }
 
 void MiCo_relu64d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x){
+  MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "relu64d_f32");
   const size_t n = y->shape[0] * y->shape[1] * y->shape[2] * y->shape[3];
   for (size_t i = 0; i < n; i += 1) {
     float x_val = x->data[i];
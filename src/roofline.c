@@ -0,0 +1,270 @@
+#include "nn.h"
+#include "profile.h"
+#include "mico_nn.h"
+#include "mico_runtime.h"
+
+extern MiCoRuntime MiCo_runtime;
+
+#ifdef MICO_ROOFLINE
+
+// Probe sizes: the STREAM arrays should be well beyond the last-level
+// cache, the MatMul probe operands well inside it. On bare metal the three
+// arrays (24 KB) only have to outgrow the L1 D-cache and must fit next to
+// the model in a few hundred KB of RAM.
+#ifndef MICO_ROOFLINE_STREAM_N
+#ifdef USE_HOST
+#define MICO_ROOFLINE_STREAM_N (4 * 1024 * 1024)
+#else
+#define MICO_ROOFLINE_STREAM_N (2 * 1024)
+#endif
+#endif
+
+#ifndef MICO_ROOFLINE_PROBE_M
+#ifdef USE_HOST
+#define MICO_ROOFLINE_PROBE_M 16
+#define MICO_ROOFLINE_PROBE_K 512
+#define MICO_ROOFLINE_PROBE_N 256
+#else
+#define MICO_ROOFLINE_PROBE_M 4
+#define MICO_ROOFLINE_PROBE_K 128
+#define MICO_ROOFLINE_PROBE_N 64
+#endif
+#endif
+
+#define MICO_ROOFLINE_PROBE_REPS 5
+
+typedef struct {
+    const char* op;
+    uint64_t macs;
+    uint64_t bytes;
+    uint64_t ticks;
+    uint8_t aq, wq;
+} __roofline_record;
+
+static __roofline_record rl_records[MICO_ROOFLINE_MAX_RECORDS];
+static uint32_t rl_n_records = 0;
+static uint32_t rl_dropped = 0;
+
+// Probed roofs, in MACs and bytes per tick of MiCo_trace_clock()
+static float rl_bw = 0.f;
+static float rl_peak[MAX_QTYPE_LOG2 + 1][MAX_QTYPE_LOG2 + 1];
+static float rl_peak_f32 = 0.f;
+static int rl_probed = 0;
+
+// Nesting depth of instrumented ops on this thread
+#ifdef USE_HOST
+static __thread int rl_depth = 0;
+#else
+static int rl_depth = 0;
+#endif
+
+uint64_t MiCo_roofline_enter(){
+    rl_depth++;
+    return MiCo_trace_clock();
+}
+
+void MiCo_roofline_exit(const char* op, const uint64_t macs, const int aq, const int wq,
+    const uint64_t bytes, const uint64_t t0){
+    const uint64_t t1 = MiCo_trace_clock();
+    if (--rl_depth > 0) return;
+    const uint32_t i = __atomic_fetch_add(&rl_n_records, 1, __ATOMIC_RELAXED);
+    if (i >= MICO_ROOFLINE_MAX_RECORDS){
+        __atomic_fetch_add(&rl_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __roofline_record* r = &rl_records[i];
+    r->op = op;
+    r->macs = macs;
+    r->bytes = bytes;
+    r->ticks = t1 - t0;
+    r->aq = (uint8_t)aq;
+    r->wq = (uint8_t)wq;
+}
+
+void MiCo_roofline_reset(){
+    rl_n_records = 0;
+    rl_dropped = 0;
+}
+
+// STREAM triad a = b + s * c, 3 x 4 bytes per element, best of the reps
+static float __roofline_probe_bw(){
+    const size_t n = MICO_ROOFLINE_STREAM_N;
+    float* a = malloc(n * sizeof(float));
+    float* b = malloc(n * sizeof(float));
+    float* c = malloc(n * sizeof(float));
+    MiCo_assert(a != NULL && b != NULL && c != NULL, "[Roofline] failed to allocate probe buffers");
+    for (size_t i = 0; i < n; i++){
+        a[i] = 0.f;
+        b[i] = (float)(i & 0xff);
+        c[i] = 1.0f;
+    }
+    uint64_t best = 0;
+    for (int r = 0; r < MICO_ROOFLINE_PROBE_REPS; r++){
+        const uint64_t t0 = MiCo_trace_clock();
+        for (size_t i = 0; i < n; i++){
+            a[i] = b[i] + 3.0f * c[i];
+        }
+        const uint64_t dt = MiCo_trace_clock() - t0;
+        if (r == 0 || dt < best) best = dt;
+    }
+    // Keep the stores observable
+    volatile float sink = a[n - 1];
+    (void)sink;
+    free(a);
+    free(b);
+    free(c);
+    return best > 0 ? (float)(3 * sizeof(float) * n) / (float)best : 0.f;
+}
+
+static float __roofline_probe_matmul(const qtype aq, const qtype wq, qbyte* xd, qbyte* wd, int32_t* O){
+    const size_t M = MICO_ROOFLINE_PROBE_M;
+    const size_t K = MICO_ROOFLINE_PROBE_K;
+    const size_t N = MICO_ROOFLINE_PROBE_N;
+    Tensor2D_Q8 x, w;
+    x.shape[0] = M;
+    x.shape[1] = K;
+    x.data = xd;
+    x.scale = 1.0f;
+    x.wq = aq;
+    w.shape[0] = N;
+    w.shape[1] = K;
+    w.data = wd;
+    w.scale = 1.0f;
+    w.wq = wq;
+    uint64_t best = 0;
+    for (int r = 0; r < MICO_ROOFLINE_PROBE_REPS; r++){
+        for (size_t i = 0; i < M * N; i++) O[i] = 0;
+        const uint64_t t0 = MiCo_trace_clock();
+        MiCo_runtime.matmul_matrix[qlog(aq)][qlog(wq)](O, &x, &w);
+        const uint64_t dt = MiCo_trace_clock() - t0;
+        if (r == 0 || dt < best) best = dt;
+    }
+    return best > 0 ? (float)(M * K * N) / (float)best : 0.f;
+}
+
+static float __roofline_probe_f32(){
+    const size_t M = MICO_ROOFLINE_PROBE_M;
+    const size_t K = MICO_ROOFLINE_PROBE_K;
+    const size_t N = MICO_ROOFLINE_PROBE_N;
+    Tensor2D_F32 x, w, y;
+    Tensor1D_F32 bias;
+    x.shape[0] = M;
+    x.shape[1] = K;
+    x.data = malloc(M * K * sizeof(float));
+    w.shape[0] = N;
+    w.shape[1] = K;
+    w.data = malloc(N * K * sizeof(float));
+    y.shape[0] = M;
+    y.shape[1] = N;
+    y.data = malloc(M * N * sizeof(float));
+    bias.shape[0] = 0;
+    bias.data = NULL;
+    MiCo_assert(x.data != NULL && w.data != NULL && y.data != NULL,
+        "[Roofline] failed to allocate probe buffers");
+    for (size_t i = 0; i < M * K; i++) x.data[i] = (float)(i % 7) - 3.0f;
+    for (size_t i = 0; i < N * K; i++) w.data[i] = (float)(i % 5) - 2.0f;
+    uint64_t best = 0;
+    for (int r = 0; r < MICO_ROOFLINE_PROBE_REPS; r++){
+        const uint64_t t0 = MiCo_trace_clock();
+        MiCo_linear_f32(&y, &x, &w, &bias);
+        const uint64_t dt = MiCo_trace_clock() - t0;
+        if (r == 0 || dt < best) best = dt;
+    }
+    free(x.data);
+    free(w.data);
+    free(y.data);
+    return best > 0 ? (float)(M * K * N) / (float)best : 0.f;
+}
+
+void MiCo_roofline_probe(){
+    const size_t M = MICO_ROOFLINE_PROBE_M;
+    const size_t K = MICO_ROOFLINE_PROBE_K;
+    const size_t N = MICO_ROOFLINE_PROBE_N;
+    // Probe ops must not show up as records
+    rl_depth++;
+    rl_bw = __roofline_probe_bw();
+    qbyte* xd = malloc(M * K);
+    qbyte* wd = malloc(N * K);
+    int32_t* O = malloc(M * N * sizeof(int32_t));
+    MiCo_assert(xd != NULL && wd != NULL && O != NULL, "[Roofline] failed to allocate probe buffers");
+    uint32_t seed = 0x1234567u;
+    for (size_t i = 0; i < M * K; i++){
+        seed = seed * 1664525u + 1013904223u;
+        xd[i] = (qbyte)(seed >> 24);
+    }
+    for (size_t i = 0; i < N * K; i++){
+        seed = seed * 1664525u + 1013904223u;
+        wd[i] = (qbyte)(seed >> 24);
+    }
+    for (int a = 0; a <= MAX_QTYPE_LOG2; a++){
+        for (int w = 0; w <= MAX_QTYPE_LOG2; w++){
+            rl_peak[a][w] = __roofline_probe_matmul((qtype)(1 << a), (qtype)(1 << w), xd, wd, O);
+        }
+    }
+    free(xd);
+    free(wd);
+    free(O);
+    rl_peak_f32 = __roofline_probe_f32();
+    rl_depth--;
+    rl_probed = 1;
+}
+
+// Integer pairs use their MatMul roof; anything with an FP32 side is
+// bounded by the FP32 roof.
+static float __roofline_peak(const int aq, const int wq){
+    if (aq > 8 || wq > 8) return rl_peak_f32;
+    return rl_peak[qlog((qtype)aq)][qlog((qtype)wq)];
+}
+
+void MiCo_roofline_print(){
+    if (!rl_probed) MiCo_roofline_probe();
+    // MACs (bytes) per tick -> GMAC/s (GB/s)
+    const float g = (float)MiCo_trace_ticks_per_us() / 1000.f;
+    printf("[Roofline] STREAM triad: %.2f GB/s, FP32 peak: %.2f GMAC/s\n",
+        rl_bw * g, rl_peak_f32 * g);
+    printf("[Roofline] MatMul peak (GMAC/s), rows aq, cols wq:\n");
+    printf("[Roofline] %6s %8d %8d %8d %8d\n", "", 1, 2, 4, 8);
+    for (int a = 0; a <= MAX_QTYPE_LOG2; a++){
+        printf("[Roofline] %6d %8.2f %8.2f %8.2f %8.2f\n", 1 << a,
+            rl_peak[a][0] * g, rl_peak[a][1] * g, rl_peak[a][2] * g, rl_peak[a][3] * g);
+    }
+    const uint32_t n = rl_n_records < MICO_ROOFLINE_MAX_RECORDS ?
+        rl_n_records : MICO_ROOFLINE_MAX_RECORDS;
+    printf("[Roofline] %4s %-34s %5s %12s %12s %8s %10s %10s %10s %6s %s\n",
+        "#", "op", "aq/wq", "MACs", "bytes", "MAC/B", "time(us)",
+        "GMAC/s", "roof", "eff%", "bound");
+    for (uint32_t i = 0; i < n; i++){
+        const __roofline_record* r = &rl_records[i];
+        const float ai = r->bytes > 0 ? (float)r->macs / (float)r->bytes : 0.f;
+        const float peak = __roofline_peak(r->aq, r->wq);
+        const float mem_roof = ai * rl_bw;
+        const int mem_bound = r->bytes > 0 && mem_roof < peak;
+        const float roof = mem_bound ? mem_roof : peak;
+        const float achieved = r->ticks > 0 ? (float)r->macs / (float)r->ticks : 0.f;
+        printf("[Roofline] %4u %-34s %2u/%-2u %12lu %12lu %8.2f %10.2f %10.3f %10.3f %6.1f %s\n",
+            (unsigned)i, r->op, (unsigned)r->aq, (unsigned)r->wq,
+            (unsigned long)r->macs, (unsigned long)r->bytes, ai,
+            (float)r->ticks / (float)MiCo_trace_ticks_per_us(),
+            achieved * g, roof * g, roof > 0.f ? 100.f * achieved / roof : 0.f,
+            mem_bound ? "memory" : "compute");
+    }
+    if (rl_dropped > 0){
+        printf("[Roofline] %u calls not recorded (MICO_ROOFLINE_MAX_RECORDS=%d)\n",
+            (unsigned)rl_dropped, MICO_ROOFLINE_MAX_RECORDS);
+    }
+}
+
+#else
+
+uint64_t MiCo_roofline_enter(){ return 0; }
+void MiCo_roofline_exit(const char* op, const uint64_t macs, const int aq, const int wq,
+    const uint64_t bytes, const uint64_t t0){
+    (void)op; (void)macs; (void)aq; (void)wq; (void)bytes; (void)t0;
+}
+void MiCo_roofline_probe(){}
+void MiCo_roofline_reset(){}
+void MiCo_roofline_print(){
+    printf("[Roofline] roofline report is disabled (build with -DMICO_ROOFLINE)\n");
+}
+
+#endif // MICO_ROOFLINE
@@ -1,8 +1,10 @@
 #include "nn.h"
+#include "profile.h"
 #include <string.h>
 
 void MiCo_channel_shuffle(Tensor4D_F32 *y, const Tensor4D_F32 *x, 
     const size_t channels, const size_t groups) {
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "channel_shuffle");
 
     MiCo_assert(channels % groups == 0, 
         "[Channel Shuffle] Channels must be divisible by groups!");
@@ -62,7 +64,7 @@ void MiCo_channel_shuffle(Tensor4D_F32 *y, const Tensor4D_F32 *x,
 void __NCHW_to_NHWC_inplace(float* data, const size_t N, const size_t C, 
     const size_t H, const size_t W){
 
-    float* temp = (float*)malloc(
+    float* temp = (float*)MiCo_malloc(
         N * H * W * C * sizeof(float)
     );
     memcpy(temp, data, N * H * W * C * sizeof(float));
@@ -77,13 +79,13 @@ void __NCHW_to_NHWC_inplace(float* data, const size_t N, const size_t C,
             }
         }
     }
-    free(temp);
+    MiCo_free(temp);
 }
 
 void __NHWC_to_NCHW_inplace(float* data, const size_t N, const size_t C, 
     const size_t H, const size_t W){
 
-    float* temp = (float*)malloc(
+    float* temp = (float*)MiCo_malloc(
         N * H * W * C * sizeof(float)
     );
     memcpy(temp, data, N * H * W * C * sizeof(float));
@@ -98,5 +100,5 @@ void __NHWC_to_NCHW_inplace(float* data, const size_t N, const size_t C,
             }
         }
     }
-    free(temp);
+    MiCo_free(temp);
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "nn.h"
+#include "profile.h"
+
+extern long SOFTMAX_TIMER;
+
+// Fast exp with range reduction: x = n*ln2 + r, |r| <= ln2/2,
+// exp(x) = 2^n * P(r) with the degree-7 Cephes expf polynomial.
+// Max relative error is below 8.5e-8 (about 1.4 ulp) on [FEXP_LO, FEXP_HI];
+// inputs below FEXP_LO, including -inf, return 0. No libm call and no
+// table, so it vectorizes and runs well on RV32IM(F) cores.
+#define FEXP_HI        88.0f
+#define FEXP_LO       -87.3365447504019f
+#define FEXP_LOG2E     1.44269504088896341f
+#define FEXP_LN2_HI    0.693359375f
+#define FEXP_LN2_LO   -2.12194440e-4f
+#define FEXP_P0        1.9875691500E-4f
+#define FEXP_P1        1.3981999507E-3f
+#define FEXP_P2        8.3334519073E-3f
+#define FEXP_P3        4.1665795894E-2f
+#define FEXP_P4        1.6666665459E-1f
+#define FEXP_P5        5.0000001201E-1f
+
+static inline float __fast_expf(float x){
+    if (x < FEXP_LO) return 0.0f;
+    x = x > FEXP_HI ? FEXP_HI : x;
+
+    // n = round(x / ln2)
+    float fn = x * FEXP_LOG2E;
+    int n = (int)(fn + (fn >= 0.0f ? 0.5f : -0.5f));
+    fn = (float)n;
+    float r = x - fn * FEXP_LN2_HI;
+    r = r - fn * FEXP_LN2_LO;
+
+    float p = FEXP_P0;
+    p = p * r + FEXP_P1;
+    p = p * r + FEXP_P2;
+    p = p * r + FEXP_P3;
+    p = p * r + FEXP_P4;
+    p = p * r + FEXP_P5;
+    p = p * r * r + r + 1.0f;
+
+    // scale by 2^n through the exponent field
+    union { uint32_t i; float f; } pow2n;
+    pow2n.i = (uint32_t)(n + 127) << 23;
+    return p * pow2n.f;
+}
+
+float MiCo_fast_expf(float x){
+    return __fast_expf(x);
+}
+
+// Softmax over n contiguous elements, dst may alias src.
+// One pass for the max, one fused exp+sum pass, then a reciprocal-multiply
+// normalization. Unrolled by 4 with independent accumulators for in-order
+// RISC-V pipelines; targets may override it with a SIMD version.
+__attribute__((weak)) void MiCo_softmax_f32(float* dst, const float* src, const size_t n){
+    size_t i;
+    if (n == 0) return;
+    float m0 = src[0], m1 = src[0], m2 = src[0], m3 = src[0];
+    for (i = 0; i + 4 <= n; i += 4){
+        m0 = src[i]     > m0 ? src[i]     : m0;
+        m1 = src[i + 1] > m1 ? src[i + 1] : m1;
+        m2 = src[i + 2] > m2 ? src[i + 2] : m2;
+        m3 = src[i + 3] > m3 ? src[i + 3] : m3;
+    }
+    for (; i < n; i++){
+        m0 = src[i] > m0 ? src[i] : m0;
+    }
+    m0 = m0 > m1 ? m0 : m1;
+    m2 = m2 > m3 ? m2 : m3;
+    const float max_val = m0 > m2 ? m0 : m2;
+
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for (i = 0; i + 4 <= n; i += 4){
+        float e0 = __fast_expf(src[i]     - max_val);
+        float e1 = __fast_expf(src[i + 1] - max_val);
+        float e2 = __fast_expf(src[i + 2] - max_val);
+        float e3 = __fast_expf(src[i + 3] - max_val);
+        dst[i] = e0;
+        dst[i + 1] = e1;
+        dst[i + 2] = e2;
+        dst[i + 3] = e3;
+        s0 += e0;
+        s1 += e1;
+        s2 += e2;
+        s3 += e3;
+    }
+    for (; i < n; i++){
+        float e = __fast_expf(src[i] - max_val);
+        dst[i] = e;
+        s0 += e;
+    }
+
+    const float inv_sum = 1.0f / ((s0 + s1) + (s2 + s3));
+    for (i = 0; i + 4 <= n; i += 4){
+        dst[i]     *= inv_sum;
+        dst[i + 1] *= inv_sum;
+        dst[i + 2] *= inv_sum;
+        dst[i + 3] *= inv_sum;
+    }
+    for (; i < n; i++){
+        dst[i] *= inv_sum;
+    }
+}
+
+void softmax(float* x, int size) {
+    long start = MiCo_time();
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "softmax");
+    MiCo_softmax_f32(x, x, size);
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
+    SOFTMAX_TIMER += MiCo_time() - start;
+}
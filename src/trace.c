@@ -0,0 +1,605 @@
+#include "profile.h"
+
+#ifdef RISCV_VEXII
+#include "sim_stdlib.h"
+#else
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+// Trace clock: ns on host, cycles on RISC-V, MiCo_time() elsewhere.
+// Off host the ticks are core cycles, converted with the core clock
+// (100 MHz on the VexiiRiscv SoC, override with -DMICO_CORE_MHZ).
+#ifndef MICO_TRACE_TICKS_PER_US
+#ifdef USE_HOST
+#define MICO_TRACE_TICKS_PER_US 1000
+#else
+#ifndef MICO_CORE_MHZ
+#define MICO_CORE_MHZ 100
+#endif
+#define MICO_TRACE_TICKS_PER_US MICO_CORE_MHZ
+#endif
+#endif
+
+#define MICO_TRACE_MAX_DEPTH 64
+#define MICO_TRACE_MAX_NAMES 256
+#define MICO_TRACE_MAGIC "MTRC"
+
+uint64_t MiCo_trace_clock(){
+    #ifdef USE_HOST
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    #elif defined(__riscv) && !defined(MICO_TRACE_NO_RDCYCLE)
+    #if __riscv_xlen == 32
+    uint32_t hi, lo, hi2;
+    do {
+        asm volatile ("rdcycleh %0" : "=r" (hi));
+        asm volatile ("rdcycle %0" : "=r" (lo));
+        asm volatile ("rdcycleh %0" : "=r" (hi2));
+    } while (hi != hi2);
+    return ((uint64_t)hi << 32) | lo;
+    #else
+    uint64_t cycles;
+    asm volatile ("rdcycle %0" : "=r" (cycles));
+    return cycles;
+    #endif
+    #else
+    return (uint64_t)MiCo_time();
+    #endif
+}
+
+uint32_t MiCo_trace_ticks_per_us(){
+    return MICO_TRACE_TICKS_PER_US;
+}
+
+// A ring holds the last MICO_TRACE_RING_SIZE events of one thread.
+// Only its owner writes to it, so recording takes no lock; readers
+// (dump / summary) must run while the traced threads are idle.
+typedef struct {
+    MiCo_Trace_Event ev[MICO_TRACE_RING_SIZE];
+    uint64_t head;      // events written so far
+} __trace_ring;
+
+// Linear view of a ring, or of a decoded binary dump
+typedef struct {
+    const MiCo_Trace_Event* ev;
+    size_t cap;
+    uint64_t first, last;
+    int tid;
+} __trace_view;
+
+// Closed region callback of __trace_walk
+typedef void (*__trace_region_fn)(void* ctx, const int tid, const char* name,
+    const uint64_t t0, const uint64_t t1, const uint64_t child);
+
+// Match begin/end pairs of one thread. Ends whose begin was overwritten
+// are dropped; regions still open are closed at the last event.
+__attribute__((unused)) static void __trace_walk(const __trace_view* v, __trace_region_fn fn, void* ctx){
+    const MiCo_Trace_Event* stack[MICO_TRACE_MAX_DEPTH];
+    uint64_t child[MICO_TRACE_MAX_DEPTH];
+    int depth = 0;
+    uint64_t t_last = 0;
+    for (uint64_t i = v->first; i < v->last; i++){
+        const MiCo_Trace_Event* e = &v->ev[i % v->cap];
+        t_last = e->ts;
+        if (e->name != NULL){
+            if (depth < MICO_TRACE_MAX_DEPTH){
+                stack[depth] = e;
+                child[depth] = 0;
+            }
+            depth++;
+        } else if (depth > 0){
+            depth--;
+            if (depth < MICO_TRACE_MAX_DEPTH){
+                const uint64_t dur = e->ts - stack[depth]->ts;
+                fn(ctx, v->tid, stack[depth]->name, stack[depth]->ts, e->ts, child[depth]);
+                if (depth > 0 && depth - 1 < MICO_TRACE_MAX_DEPTH) child[depth - 1] += dur;
+            }
+        }
+    }
+    while (depth > 0){
+        depth--;
+        if (depth < MICO_TRACE_MAX_DEPTH){
+            const uint64_t dur = t_last - stack[depth]->ts;
+            fn(ctx, v->tid, stack[depth]->name, stack[depth]->ts, t_last, child[depth]);
+            if (depth > 0 && depth - 1 < MICO_TRACE_MAX_DEPTH) child[depth - 1] += dur;
+        }
+    }
+}
+
+#ifdef USE_HOST
+typedef struct {
+    FILE* f;
+    uint64_t base;
+    double ticks_per_us;
+    int first;
+} __chrome_ctx;
+
+static void __chrome_region(void* ctx, const int tid, const char* name,
+    const uint64_t t0, const uint64_t t1, const uint64_t child){
+    __chrome_ctx* c = (__chrome_ctx*)ctx;
+    (void)child;
+    fprintf(c->f, "%s\n  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+        c->first ? "" : ",", name, tid,
+        (double)(t0 - c->base) / c->ticks_per_us, (double)(t1 - t0) / c->ticks_per_us);
+    c->first = 0;
+}
+
+static int __write_chrome(const char* path, const __trace_view* views, const int n_views,
+    const uint32_t ticks_per_us, const uint32_t dropped){
+    FILE* f = fopen(path, "w");
+    if (f == NULL){
+        printf("[Trace] cannot open %s\n", path);
+        return -1;
+    }
+    uint64_t base = UINT64_MAX;
+    for (int t = 0; t < n_views; t++){
+        if (views[t].last > views[t].first){
+            const uint64_t ts = views[t].ev[views[t].first % views[t].cap].ts;
+            base = ts < base ? ts : base;
+        }
+    }
+    __chrome_ctx c = { .f = f, .base = base == UINT64_MAX ? 0 : base,
+        .ticks_per_us = (double)ticks_per_us, .first = 1 };
+    fprintf(f, "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"ticks_per_us\": %u, \"dropped\": %u},\n"
+        "\"traceEvents\": [", ticks_per_us, dropped);
+    for (int t = 0; t < n_views; t++){
+        __trace_walk(&views[t], __chrome_region, &c);
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return 0;
+}
+#endif
+
+#if MICO_TRACE_LEVEL > 0
+
+// No string.h on the bare-metal targets
+static int __trace_streq(const char* a, const char* b){
+    while (*a && *a == *b){
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static size_t __trace_strlen(const char* s){
+    size_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+static __trace_ring trace_rings[MICO_TRACE_MAX_THREADS];
+static int trace_n_rings = 0;
+static uint32_t trace_dropped = 0;   // events of threads without a ring
+
+#ifdef USE_HOST
+static __thread __trace_ring* trace_tl_ring = NULL;
+static __thread int trace_tl_init = 0;
+#endif
+
+static inline __trace_ring* __trace_get_ring(){
+    #ifdef USE_HOST
+    if (!trace_tl_init){
+        const int id = __atomic_fetch_add(&trace_n_rings, 1, __ATOMIC_RELAXED);
+        trace_tl_ring = id < MICO_TRACE_MAX_THREADS ? &trace_rings[id] : NULL;
+        trace_tl_init = 1;
+    }
+    return trace_tl_ring;
+    #else
+    trace_n_rings = 1;
+    return &trace_rings[0];
+    #endif
+}
+
+static inline void __trace_record(const char* name){
+    __trace_ring* r = __trace_get_ring();
+    if (r == NULL){
+        __atomic_fetch_add(&trace_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    MiCo_Trace_Event* e = &r->ev[r->head % MICO_TRACE_RING_SIZE];
+    e->ts = MiCo_trace_clock();
+    e->name = name;
+    r->head++;
+}
+
+void MiCo_trace_begin(const char* name){
+    __trace_record(name);
+    #ifdef MICO_MEM
+    __MiCo_mem_begin(name);
+    #endif
+    #ifdef MICO_PERF
+    __MiCo_perf_begin(name);
+    #endif
+    #ifdef MICO_CACHESIM
+    __MiCo_cache_begin(name);
+    #endif
+}
+
+void MiCo_trace_end(){
+    #ifdef MICO_CACHESIM
+    __MiCo_cache_end();
+    #endif
+    #ifdef MICO_PERF
+    __MiCo_perf_end();
+    #endif
+    #ifdef MICO_MEM
+    __MiCo_mem_end();
+    #endif
+    __trace_record(NULL);
+}
+
+void MiCo_trace_reset(){
+    const int n = trace_n_rings < MICO_TRACE_MAX_THREADS ? trace_n_rings : MICO_TRACE_MAX_THREADS;
+    for (int t = 0; t < n; t++){
+        trace_rings[t].head = 0;
+    }
+    trace_dropped = 0;
+}
+
+static int __trace_views(__trace_view* views){
+    const int n = trace_n_rings < MICO_TRACE_MAX_THREADS ? trace_n_rings : MICO_TRACE_MAX_THREADS;
+    for (int t = 0; t < n; t++){
+        const __trace_ring* r = &trace_rings[t];
+        views[t].ev = r->ev;
+        views[t].cap = MICO_TRACE_RING_SIZE;
+        views[t].last = r->head;
+        views[t].first = r->head > MICO_TRACE_RING_SIZE ? r->head - MICO_TRACE_RING_SIZE : 0;
+        views[t].tid = t;
+    }
+    return n;
+}
+
+// Per-name totals; self time excludes nested regions
+typedef struct {
+    MiCo_Trace_Stat stat[MICO_TRACE_MAX_NAMES];
+    int n;
+} __trace_stats;
+
+static void __summary_region(void* ctx, const int tid, const char* name,
+    const uint64_t t0, const uint64_t t1, const uint64_t child){
+    __trace_stats* s = (__trace_stats*)ctx;
+    (void)tid;
+    int i = 0;
+    while (i < s->n && s->stat[i].name != name && !__trace_streq(s->stat[i].name, name)) i++;
+    if (i == s->n){
+        if (s->n == MICO_TRACE_MAX_NAMES) return;
+        s->stat[i].name = name;
+        s->stat[i].count = 0;
+        s->stat[i].total = 0;
+        s->stat[i].self = 0;
+        s->n++;
+    }
+    const uint64_t dur = t1 - t0;
+    s->stat[i].count++;
+    s->stat[i].total += dur;
+    s->stat[i].self += dur > child ? dur - child : 0;
+}
+
+static __trace_stats* __trace_collect(){
+    static __trace_view views[MICO_TRACE_MAX_THREADS];
+    static __trace_stats s;
+    s.n = 0;
+    const int n = __trace_views(views);
+    for (int t = 0; t < n; t++){
+        __trace_walk(&views[t], __summary_region, &s);
+    }
+    return &s;
+}
+
+int MiCo_trace_stats(MiCo_Trace_Stat* stats, const int max){
+    const __trace_stats* s = __trace_collect();
+    const int n = s->n < max ? s->n : max;
+    for (int i = 0; i < n; i++){
+        stats[i] = s->stat[i];
+    }
+    return n;
+}
+
+// One entry per region occurrence, in the order the regions close
+typedef struct {
+    MiCo_Trace_Stat* out;
+    int max;
+    int n;
+} __trace_list;
+
+static void __list_region(void* ctx, const int tid, const char* name,
+    const uint64_t t0, const uint64_t t1, const uint64_t child){
+    __trace_list* l = (__trace_list*)ctx;
+    (void)tid;
+    if (l->n == l->max) return;
+    const uint64_t dur = t1 - t0;
+    MiCo_Trace_Stat* s = &l->out[l->n++];
+    s->name = name;
+    s->count = 1;
+    s->total = dur;
+    s->self = dur > child ? dur - child : 0;
+}
+
+int MiCo_trace_regions(MiCo_Trace_Stat* regions, const int max){
+    static __trace_view views[MICO_TRACE_MAX_THREADS];
+    __trace_list l = { .out = regions, .max = max, .n = 0 };
+    const int n = __trace_views(views);
+    for (int t = 0; t < n; t++){
+        __trace_walk(&views[t], __list_region, &l);
+    }
+    return l.n;
+}
+
+void MiCo_trace_print_summary(){
+    const __trace_stats* s = __trace_collect();
+
+    // Cost of one empty region, measured on this thread and then rewound
+    uint64_t overhead = 0;
+    __trace_ring* r = __trace_get_ring();
+    if (r != NULL){
+        const uint64_t head = r->head;
+        const uint64_t t0 = MiCo_trace_clock();
+        for (int i = 0; i < 64; i++){
+            MiCo_trace_begin("__calib");
+            MiCo_trace_end();
+        }
+        overhead = (MiCo_trace_clock() - t0) / 64;
+        r->head = head;
+    }
+
+    printf("[Trace] %-24s %8s %14s %14s\n", "region", "count", "total(us)", "self(us)");
+    for (int i = 0; i < s->n; i++){
+        printf("[Trace] %-24s %8u %14.2f %14.2f\n", s->stat[i].name, (unsigned)s->stat[i].count,
+            (double)s->stat[i].total / MICO_TRACE_TICKS_PER_US,
+            (double)s->stat[i].self / MICO_TRACE_TICKS_PER_US);
+    }
+    printf("[Trace] overhead per region: %lu ticks, dropped events: %u\n",
+        (unsigned long)overhead, (unsigned)trace_dropped);
+}
+
+// Binary dump (little endian):
+//   "MTRC" | u8 version | u8 n_threads | u16 n_names | u32 ticks_per_us | u32 dropped
+//   n_names x (u8 len | name bytes)
+//   n_threads x (u8 tid | u32 n_events | n_events x (varint name_id + 1, 0 = end | varint dt))
+// dt is the tick delta to the previous event of the same thread.
+typedef struct {
+    MiCo_Trace_Writer write;
+    void* ctx;
+    uint8_t buf[64];
+    size_t len;
+    size_t total;
+} __trace_out;
+
+static void __out_flush(__trace_out* o){
+    if (o->len > 0) o->write(o->buf, o->len, o->ctx);
+    o->total += o->len;
+    o->len = 0;
+}
+
+static void __out_u8(__trace_out* o, const uint8_t v){
+    if (o->len == sizeof(o->buf)) __out_flush(o);
+    o->buf[o->len++] = v;
+}
+
+static void __out_u32(__trace_out* o, const uint32_t v){
+    for (int i = 0; i < 4; i++) __out_u8(o, (uint8_t)(v >> (8 * i)));
+}
+
+static void __out_varint(__trace_out* o, uint64_t v){
+    while (v >= 0x80){
+        __out_u8(o, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    __out_u8(o, (uint8_t)v);
+}
+
+static int __name_id(const char** names, int* n_names, const char* name){
+    for (int i = 0; i < *n_names; i++){
+        if (names[i] == name || __trace_streq(names[i], name)) return i;
+    }
+    if (*n_names == MICO_TRACE_MAX_NAMES) return -1;
+    names[*n_names] = name;
+    return (*n_names)++;
+}
+
+size_t MiCo_trace_dump_binary(MiCo_Trace_Writer write, void* ctx){
+    static __trace_view views[MICO_TRACE_MAX_THREADS];
+    static const char* names[MICO_TRACE_MAX_NAMES];
+    int n_names = 0;
+    const int n = __trace_views(views);
+    for (int t = 0; t < n; t++){
+        for (uint64_t i = views[t].first; i < views[t].last; i++){
+            const MiCo_Trace_Event* e = &views[t].ev[i % views[t].cap];
+            if (e->name != NULL) __name_id(names, &n_names, e->name);
+        }
+    }
+
+    __trace_out o = { .write = write, .ctx = ctx, .len = 0, .total = 0 };
+    for (int i = 0; i < 4; i++) __out_u8(&o, (uint8_t)MICO_TRACE_MAGIC[i]);
+    __out_u8(&o, 1);
+    __out_u8(&o, (uint8_t)n);
+    __out_u8(&o, (uint8_t)n_names);
+    __out_u8(&o, (uint8_t)(n_names >> 8));
+    __out_u32(&o, MICO_TRACE_TICKS_PER_US);
+    __out_u32(&o, trace_dropped);
+    for (int i = 0; i < n_names; i++){
+        const size_t len = __trace_strlen(names[i]) < 255 ? __trace_strlen(names[i]) : 255;
+        __out_u8(&o, (uint8_t)len);
+        for (size_t c = 0; c < len; c++) __out_u8(&o, (uint8_t)names[i][c]);
+    }
+    for (int t = 0; t < n; t++){
+        __out_u8(&o, (uint8_t)t);
+        __out_u32(&o, (uint32_t)(views[t].last - views[t].first));
+        uint64_t prev = 0;
+        for (uint64_t i = views[t].first; i < views[t].last; i++){
+            const MiCo_Trace_Event* e = &views[t].ev[i % views[t].cap];
+            const int id = e->name != NULL ? __name_id(names, &n_names, e->name) : -1;
+            // Names past the table limit are recorded as the first name
+            __out_varint(&o, e->name != NULL ? (uint64_t)(id < 0 ? 0 : id) + 1 : 0);
+            __out_varint(&o, e->ts - prev);
+            prev = e->ts;
+        }
+    }
+    __out_flush(&o);
+    return o.total;
+}
+
+#ifdef USE_HOST
+int MiCo_trace_dump_chrome(const char* path){
+    static __trace_view views[MICO_TRACE_MAX_THREADS];
+    const int n = __trace_views(views);
+    return __write_chrome(path, views, n, MICO_TRACE_TICKS_PER_US, trace_dropped);
+}
+#endif
+
+#else // MICO_TRACE_LEVEL == 0
+
+void MiCo_trace_begin(const char* name){
+    (void)name;
+}
+
+void MiCo_trace_end(){
+}
+
+void MiCo_trace_reset(){
+}
+
+void MiCo_trace_print_summary(){
+    printf("[Trace] tracing is disabled (MICO_TRACE_LEVEL=0)\n");
+}
+
+int MiCo_trace_stats(MiCo_Trace_Stat* stats, const int max){
+    (void)stats;
+    (void)max;
+    return 0;
+}
+
+int MiCo_trace_regions(MiCo_Trace_Stat* regions, const int max){
+    (void)regions;
+    (void)max;
+    return 0;
+}
+
+size_t MiCo_trace_dump_binary(MiCo_Trace_Writer write, void* ctx){
+    (void)write;
+    (void)ctx;
+    return 0;
+}
+
+#ifdef USE_HOST
+int MiCo_trace_dump_chrome(const char* path){
+    return __write_chrome(path, NULL, 0, MICO_TRACE_TICKS_PER_US, 0);
+}
+#endif
+
+#endif // MICO_TRACE_LEVEL
+
+#ifdef USE_HOST
+static int __read_u32(const uint8_t* p, const uint8_t* end, uint32_t* v){
+    if (end - p < 4) return 0;
+    *v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    return 4;
+}
+
+static int __read_varint(const uint8_t* p, const uint8_t* end, uint64_t* v){
+    int n = 0;
+    *v = 0;
+    while (p + n < end && n < 10){
+        *v |= (uint64_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n++] & 0x80)) return n;
+    }
+    return 0;
+}
+
+// Decode a binary dump (e.g. captured from the SoC UART) into Chrome JSON
+int MiCo_trace_binary_to_chrome(const char* bin_path, const char* json_path){
+    FILE* f = fopen(bin_path, "rb");
+    if (f == NULL){
+        printf("[Trace] cannot open %s\n", bin_path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = malloc(size > 0 ? size : 1);
+    const size_t got = data != NULL ? fread(data, 1, size, f) : 0;
+    fclose(f);
+
+    int ret = -1;
+    const uint8_t* p = data;
+    const uint8_t* end = data + got;
+    char** names = NULL;
+    MiCo_Trace_Event** events = NULL;
+    __trace_view* views = NULL;
+    int n_threads = 0, n_names = 0;
+    uint32_t ticks_per_us = 1, dropped = 0;
+
+    if (got < 16 || memcmp(p, MICO_TRACE_MAGIC, 4) || p[4] != 1){
+        printf("[Trace] %s is not a MiCo trace dump\n", bin_path);
+        goto done;
+    }
+    n_threads = p[5];
+    n_names = p[6] | (p[7] << 8);
+    __read_u32(p + 8, end, &ticks_per_us);
+    __read_u32(p + 12, end, &dropped);
+    p += 16;
+
+    names = calloc(n_names > 0 ? n_names : 1, sizeof(char*));
+    events = calloc(n_threads > 0 ? n_threads : 1, sizeof(MiCo_Trace_Event*));
+    views = calloc(n_threads > 0 ? n_threads : 1, sizeof(__trace_view));
+    if (names == NULL || events == NULL || views == NULL) goto done;
+
+    for (int i = 0; i < n_names; i++){
+        if (p >= end || end - p - 1 < p[0]) goto corrupt;
+        names[i] = malloc(p[0] + 1);
+        if (names[i] == NULL) goto done;
+        memcpy(names[i], p + 1, p[0]);
+        names[i][p[0]] = '\0';
+        p += 1 + p[0];
+    }
+    for (int t = 0; t < n_threads; t++){
+        uint32_t n_ev;
+        if (p >= end) goto corrupt;
+        views[t].tid = *p++;
+        if (!__read_u32(p, end, &n_ev)) goto corrupt;
+        p += 4;
+        if ((size_t)n_ev > (size_t)(end - p) / 2) goto corrupt;
+        events[t] = malloc((n_ev > 0 ? n_ev : 1) * sizeof(MiCo_Trace_Event));
+        if (events[t] == NULL) goto done;
+        uint64_t ts = 0;
+        for (uint32_t i = 0; i < n_ev; i++){
+            uint64_t id, dt;
+            int k = __read_varint(p, end, &id);
+            if (!k) goto corrupt;
+            p += k;
+            k = __read_varint(p, end, &dt);
+            if (!k || id > (uint64_t)n_names) goto corrupt;
+            p += k;
+            ts += dt;
+            events[t][i].ts = ts;
+            events[t][i].name = id ? names[id - 1] : NULL;
+        }
+        views[t].ev = events[t];
+        views[t].cap = n_ev > 0 ? n_ev : 1;
+        views[t].first = 0;
+        views[t].last = n_ev;
+    }
+    ret = __write_chrome(json_path, views, n_threads, ticks_per_us, dropped);
+    goto done;
+
+corrupt:
+    printf("[Trace] %s is truncated or corrupt\n", bin_path);
+done:
+    if (names != NULL){
+        for (int i = 0; i < n_names; i++) free(names[i]);
+    }
+    if (events != NULL){
+        for (int t = 0; t < n_threads; t++) free(events[t]);
+    }
+    free(names);
+    free(events);
+    free(views);
+    free(data);
+    return ret;
+}
+#endif
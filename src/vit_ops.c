@@ -9,8 +9,6 @@
 extern long ATTN_TIMER;
 extern long SOFTMAX_TIMER;
 
-long EXPF_TIMER;
-
 static inline size_t idx2(size_t i0, size_t i1, size_t d1){
     return i0 * d1 + i1;
 }
@@ -23,55 +21,19 @@ static inline size_t idx4(size_t i0, size_t i1, size_t i2, size_t i3, size_t d1,
     return ((i0 * d1 + i1) * d2 + i2) * d3 + i3;
 }
 
-// Exp LUT: covers [-EXP_LUT_MAX, 0] with EXP_LUT_SIZE entries
-#define EXP_LUT_SIZE 256
-#define EXP_LUT_MAX  16.0f
-#define EXP_LUT_STEP (EXP_LUT_MAX / (float)EXP_LUT_SIZE)
-
-static float exp_lut[EXP_LUT_SIZE];
-static int exp_lut_ready = 0;
-
-static void MiCo_init_exp_lut(void){
-    if (exp_lut_ready) return;
-    for (int i = 0; i < EXP_LUT_SIZE; i++){
-        exp_lut[i] = expf(-(float)i * EXP_LUT_STEP);
-    }
-    exp_lut_ready = 1;
-}
-
-static float MiCo_expf(float x){
-    long start = MiCo_time();
-    float res;
+static inline float MiCo_expf(float x){
     #ifdef EXP_ACCEL
-    if (x >= 0.0f) return expf(x);
-    if (x <= -EXP_LUT_MAX) return 0.0f;
-    int idx = (int)(-x * (1.0f / EXP_LUT_STEP));
-    if (idx >= EXP_LUT_SIZE) idx = EXP_LUT_SIZE - 1;
-    res = exp_lut[idx];
+    return MiCo_fast_expf(x);
     #else
-    res = expf(x);
+    return expf(x);
     #endif
-    EXPF_TIMER += MiCo_time() - start;
-    return res;
 }
 
 static void MiCo_softmax_vec(float *dst, const float *src, size_t n){
     long start = MiCo_time();
-    float max_val = src[0];
-    for (size_t i = 1; i < n; i++){
-        if (src[i] > max_val){
-            max_val = src[i];
-        }
-    }
-
-    float sum = 0.0f;
-    for (size_t i = 0; i < n; i++){
-        dst[i] = MiCo_expf(src[i] - max_val);
-        sum += dst[i];
-    }
-    for (size_t i = 0; i < n; i++){
-        dst[i] /= sum;
-    }
+    MiCo_TRACE_BEGIN(MICO_TRACE_PHASE, "softmax");
+    MiCo_softmax_f32(dst, src, n);
+    MiCo_TRACE_END(MICO_TRACE_PHASE);
     SOFTMAX_TIMER += MiCo_time() - start;
 }
 
@@ -88,6 +50,7 @@ void MiCo_flatten3d_f32(Tensor3D_F32 *y, const Tensor4D_F32 *x){
 
 void MiCo_repeat3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
     const size_t rep0, const size_t rep1, const size_t rep2){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "repeat3d_f32");
     MiCo_assert(y->shape[0] == x->shape[0] * rep0, "[Repeat3D] dim0 mismatch");
     MiCo_assert(y->shape[1] == x->shape[1] * rep1, "[Repeat3D] dim1 mismatch");
     MiCo_assert(y->shape[2] == x->shape[2] * rep2, "[Repeat3D] dim2 mismatch");
@@ -106,6 +69,7 @@ void MiCo_repeat3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x,
 }
 
 void MiCo_transpose3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const size_t dim0, const size_t dim1){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "transpose3d_f32");
     MiCo_assert(dim0 < 3 && dim1 < 3, "[Transpose3D] invalid dims");
 
     size_t xshape[3] = {x->shape[0], x->shape[1], x->shape[2]};
@@ -134,6 +98,7 @@ void MiCo_transpose3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const size_t d
 }
 
 void MiCo_transpose4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, const size_t dim0, const size_t dim1){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "transpose4d_f32");
     MiCo_assert(dim0 < 4 && dim1 < 4, "[Transpose4D] invalid dims");
 
     size_t xshape[4] = {x->shape[0], x->shape[1], x->shape[2], x->shape[3]};
@@ -165,6 +130,7 @@ void MiCo_transpose4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, const size_t d
 }
 
 void MiCo_getitem3d_to2d_f32(Tensor2D_F32 *y, const Tensor3D_F32 *x, const size_t index1){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "getitem3d_to2d_f32");
     MiCo_assert(index1 < x->shape[1], "[GetItem3D] index out of range");
     MiCo_assert(y->shape[0] == x->shape[0] && y->shape[1] == x->shape[2], "[GetItem3D] output shape mismatch");
 
@@ -176,6 +142,7 @@ void MiCo_getitem3d_to2d_f32(Tensor2D_F32 *y, const Tensor3D_F32 *x, const size_
 }
 
 void MiCo_im2word(Tensor3D_F32 *y, const Tensor4D_F32 *x, const size_t patch){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "im2word");
     const size_t batch = x->shape[0];
     #ifdef USE_ALT_LAYOUT
     const size_t in_h = x->shape[1];
@@ -218,6 +185,7 @@ void MiCo_im2word(Tensor3D_F32 *y, const Tensor4D_F32 *x, const size_t patch){
 }
 
 void MiCo_softmax2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const int dim){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "softmax2d_f32");
     int real_dim = dim < 0 ? dim + 2 : dim;
     MiCo_assert(real_dim == 1, "[Softmax2D] only last-dim softmax is supported");
     for (size_t i = 0; i < x->shape[0]; i++){
@@ -227,6 +195,7 @@ void MiCo_softmax2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const int dim){
 }
 
 void MiCo_softmax3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const int dim){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "softmax3d_f32");
     int real_dim = dim < 0 ? dim + 3 : dim;
     MiCo_assert(real_dim == 2, "[Softmax3D] only last-dim softmax is supported");
     for (size_t b = 0; b < x->shape[0]; b++){
@@ -238,6 +207,7 @@ void MiCo_softmax3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const int dim){
 }
 
 void MiCo_softmax4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, const int dim){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "softmax4d_f32");
     int real_dim = dim < 0 ? dim + 4 : dim;
     MiCo_assert(real_dim == 3, "[Softmax4D] only last-dim softmax is supported");
     for (size_t b = 0; b < x->shape[0]; b++){
@@ -251,6 +221,7 @@ void MiCo_softmax4d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, const int dim){
 }
 
 void MiCo_div2d_scalar_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const float scalar){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "div2d_scalar_f32");
     const size_t n = x->shape[0] * x->shape[1];
     for (size_t i = 0; i < n; i++){
         y->data[i] = x->data[i] / scalar;
@@ -258,6 +229,7 @@ void MiCo_div2d_scalar_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x, const float s
 }
 
 void MiCo_div3d_scalar_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const float scalar){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "div3d_scalar_f32");
     const size_t n = x->shape[0] * x->shape[1] * x->shape[2];
     for (size_t i = 0; i < n; i++){
         y->data[i] = x->data[i] / scalar;
@@ -265,6 +237,7 @@ void MiCo_div3d_scalar_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x, const float s
 }
 
 void MiCo_div4d_scalar_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, const float scalar){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "div4d_scalar_f32");
     const size_t n = x->shape[0] * x->shape[1] * x->shape[2] * x->shape[3];
     for (size_t i = 0; i < n; i++){
         y->data[i] = x->data[i] / scalar;
@@ -272,6 +245,7 @@ void MiCo_div4d_scalar_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x, const float s
 }
 
 void MiCo_gelu2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "gelu2d_f32");
     const size_t n = x->shape[0] * x->shape[1];
     const float inv_sqrt2 = 0.7071067811865475f;
     for (size_t i = 0; i < n; i++){
@@ -281,6 +255,7 @@ void MiCo_gelu2d_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x){
 }
 
 void MiCo_gelu3d_f32(Tensor3D_F32 *y, const Tensor3D_F32 *x){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "gelu3d_f32");
     const size_t n = x->shape[0] * x->shape[1] * x->shape[2];
     const float inv_sqrt2 = 0.7071067811865475f;
     for (size_t i = 0; i < n; i++){
@@ -296,6 +271,7 @@ void MiCo_linear_attention_f32(
     const Tensor4D_F32 *v,
     const float eps
 ){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "linear_attention_f32");
     const size_t B = q->shape[0];
     const size_t H = q->shape[1];
     const size_t N = q->shape[2];
@@ -309,15 +285,12 @@ void MiCo_linear_attention_f32(
     MiCo_assert(y->shape[0] == B && y->shape[1] == N && y->shape[2] == H && y->shape[3] == M,
                 "[LinearAttention] y shape mismatch");
 
-#if defined(EXP_ACCEL)
-    MiCo_init_exp_lut();
-#endif
-
+    MiCo_ROOFLINE_BEGIN();
     long start_time = MiCo_time();
-    float *context = (float *)malloc(H * D * M * sizeof(float));
-    float *k_sum   = (float *)malloc(H * D * sizeof(float));
-    float *phi_q   = (float *)malloc(N * D * sizeof(float));
-    float *num     = (float *)malloc(M * sizeof(float));
+    float *context = (float *)MiCo_malloc(H * D * M * sizeof(float));
+    float *k_sum   = (float *)MiCo_malloc(H * D * sizeof(float));
+    float *phi_q   = (float *)MiCo_malloc(N * D * sizeof(float));
+    float *num     = (float *)MiCo_malloc(M * sizeof(float));
     MiCo_assert(context != NULL && k_sum != NULL && phi_q != NULL && num != NULL,
                 "[LinearAttention] failed to allocate buffers");
 
@@ -373,10 +346,210 @@ void MiCo_linear_attention_f32(
     }
 
     ATTN_TIMER += MiCo_time() - start_time;
-    free(context);
-    free(k_sum);
-    free(phi_q);
-    free(num);
+    MiCo_ROOFLINE_END("linear_attention_f32", 2 * B * H * N * D * M, 32, 32,
+        4 * B * H * N * (2 * D + 2 * M));
+    MiCo_free(context);
+    MiCo_free(k_sum);
+    MiCo_free(phi_q);
+    MiCo_free(num);
+}
+
+// Streaming (causal) linear attention
+// The recurrent form keeps, per head, the running context S = sum phi(k)^T v
+// [D, M] and the key sum z = sum phi(k) [D]. Each new token costs O(D*M)
+// per head regardless of how many tokens came before.
+
+static inline float __phi(float x){
+    return x >= 0.0f ? x + 1.0f : MiCo_expf(x);
+}
+
+void MiCo_linear_attention_state_init(MiCo_LinearAttn_State *state,
+    const size_t n_heads, const size_t head_dim, const size_t value_dim){
+    state->n_heads = n_heads;
+    state->head_dim = head_dim;
+    state->value_dim = value_dim;
+    state->context = (float *)MiCo_alloc_kind(n_heads * head_dim * value_dim * sizeof(float), 0, MICO_MEM_KV);
+    state->k_sum = (float *)MiCo_alloc_kind(n_heads * head_dim * sizeof(float), 0, MICO_MEM_KV);
+    MiCo_assert(state->context != NULL && state->k_sum != NULL,
+                "[LinearAttention] failed to allocate state");
+    MiCo_linear_attention_state_reset(state);
+}
+
+void MiCo_linear_attention_state_reset(MiCo_LinearAttn_State *state){
+    const size_t H = state->n_heads;
+    const size_t D = state->head_dim;
+    const size_t M = state->value_dim;
+    memset(state->context, 0, H * D * M * sizeof(float));
+    memset(state->k_sum, 0, H * D * sizeof(float));
+}
+
+void MiCo_linear_attention_state_free(MiCo_LinearAttn_State *state){
+    MiCo_free(state->context);
+    MiCo_free(state->k_sum);
+    state->context = NULL;
+    state->k_sum = NULL;
+}
+
+// One new token: q, k [H, D], v [H, M] -> y [H, M]
+void MiCo_linear_attention_step_f32(
+    Tensor2D_F32 *y,
+    const Tensor2D_F32 *q,
+    const Tensor2D_F32 *k,
+    const Tensor2D_F32 *v,
+    MiCo_LinearAttn_State *state,
+    const float eps
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "linear_attention_step_f32");
+    const size_t H = state->n_heads;
+    const size_t D = state->head_dim;
+    const size_t M = state->value_dim;
+
+    MiCo_assert(q->shape[0] == H && q->shape[1] == D, "[LinearAttention] q shape mismatch");
+    MiCo_assert(k->shape[0] == H && k->shape[1] == D, "[LinearAttention] k shape mismatch");
+    MiCo_assert(v->shape[0] == H && v->shape[1] == M, "[LinearAttention] v shape mismatch");
+    MiCo_assert(y->shape[0] == H && y->shape[1] == M, "[LinearAttention] y shape mismatch");
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    for (size_t h = 0; h < H; h++){
+        float *ctx = state->context + h * D * M;
+        float *k_sum = state->k_sum + h * D;
+        const float *kh = k->data + h * D;
+        const float *qh = q->data + h * D;
+        const float *vh = v->data + h * M;
+        float *yh = y->data + h * M;
+
+        // state update with the current token
+        for (size_t d = 0; d < D; d++){
+            float kp = __phi(kh[d]);
+            k_sum[d] += kp;
+            float *ctx_d = ctx + d * M;
+            for (size_t m = 0; m < M; m++){
+                ctx_d[m] += kp * vh[m];
+            }
+        }
+
+        // query reduction against the updated state
+        float den = 0.0f;
+        memset(yh, 0, M * sizeof(float));
+        for (size_t d = 0; d < D; d++){
+            float qp = __phi(qh[d]);
+            den += qp * k_sum[d];
+            const float *ctx_d = ctx + d * M;
+            for (size_t m = 0; m < M; m++){
+                yh[m] += qp * ctx_d[m];
+            }
+        }
+        const float inv_den = 1.0f / (den + eps);
+        for (size_t m = 0; m < M; m++){
+            yh[m] *= inv_den;
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    // the state is read and written once per token
+    MiCo_ROOFLINE_END("linear_attention_step_f32", 2 * H * D * M, 32, 32,
+        4 * H * (2 * D + 2 * M) + 8 * H * (D * M + D));
+}
+
+// Chunked causal evaluation for prefill: q, k [H, C, D], v [H, C, M] -> y [C, H, M].
+// Token i of the chunk sees the carried state plus tokens 0..i of the chunk:
+//   num_i = phi(q_i) S + sum_{j<=i} (phi(q_i).phi(k_j)) v_j
+//   den_i = phi(q_i) z + sum_{j<=i} (phi(q_i).phi(k_j))
+// The state is advanced by the whole chunk afterwards, so the result matches
+// C calls of MiCo_linear_attention_step_f32.
+void MiCo_linear_attention_chunk_f32(
+    Tensor3D_F32 *y,
+    const Tensor3D_F32 *q,
+    const Tensor3D_F32 *k,
+    const Tensor3D_F32 *v,
+    MiCo_LinearAttn_State *state,
+    const float eps
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "linear_attention_chunk_f32");
+    const size_t H = state->n_heads;
+    const size_t D = state->head_dim;
+    const size_t M = state->value_dim;
+    const size_t C = q->shape[1];
+
+    MiCo_assert(q->shape[0] == H && q->shape[2] == D, "[LinearAttention] q shape mismatch");
+    MiCo_assert(k->shape[0] == H && k->shape[1] == C && k->shape[2] == D,
+                "[LinearAttention] k shape mismatch");
+    MiCo_assert(v->shape[0] == H && v->shape[1] == C && v->shape[2] == M,
+                "[LinearAttention] v shape mismatch");
+    MiCo_assert(y->shape[0] == C && y->shape[1] == H && y->shape[2] == M,
+                "[LinearAttention] y shape mismatch");
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+    float *phi_q = (float *)MiCo_malloc(C * D * sizeof(float));
+    float *phi_k = (float *)MiCo_malloc(C * D * sizeof(float));
+    MiCo_assert(phi_q != NULL && phi_k != NULL,
+                "[LinearAttention] failed to allocate buffers");
+
+    for (size_t h = 0; h < H; h++){
+        float *ctx = state->context + h * D * M;
+        float *k_sum = state->k_sum + h * D;
+
+        for (size_t i = 0; i < C * D; i++){
+            phi_q[i] = __phi(q->data[h * C * D + i]);
+            phi_k[i] = __phi(k->data[h * C * D + i]);
+        }
+
+        for (size_t i = 0; i < C; i++){
+            const float *qp = phi_q + i * D;
+            float *yi = y->data + idx3(i, h, 0, H, M);
+
+            // inter-chunk term against the carried state
+            float den = 0.0f;
+            memset(yi, 0, M * sizeof(float));
+            for (size_t d = 0; d < D; d++){
+                den += qp[d] * k_sum[d];
+                const float *ctx_d = ctx + d * M;
+                for (size_t m = 0; m < M; m++){
+                    yi[m] += qp[d] * ctx_d[m];
+                }
+            }
+
+            // intra-chunk causal term
+            for (size_t j = 0; j <= i; j++){
+                const float *kp = phi_k + j * D;
+                const float *vj = v->data + idx3(h, j, 0, C, M);
+                float a = 0.0f;
+                for (size_t d = 0; d < D; d++){
+                    a += qp[d] * kp[d];
+                }
+                den += a;
+                for (size_t m = 0; m < M; m++){
+                    yi[m] += a * vj[m];
+                }
+            }
+
+            const float inv_den = 1.0f / (den + eps);
+            for (size_t m = 0; m < M; m++){
+                yi[m] *= inv_den;
+            }
+        }
+
+        // advance the state by the whole chunk
+        for (size_t j = 0; j < C; j++){
+            const float *kp = phi_k + j * D;
+            const float *vj = v->data + idx3(h, j, 0, C, M);
+            for (size_t d = 0; d < D; d++){
+                k_sum[d] += kp[d];
+                float *ctx_d = ctx + d * M;
+                for (size_t m = 0; m < M; m++){
+                    ctx_d[m] += kp[d] * vj[m];
+                }
+            }
+        }
+    }
+
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("linear_attention_chunk_f32",
+        H * (2 * C * D * M + C * (C + 1) / 2 * (D + M)), 32, 32,
+        4 * H * C * (2 * D + 2 * M) + 8 * H * (D * M + D));
+    MiCo_free(phi_q);
+    MiCo_free(phi_k);
 }
 
 void MiCo_ViT_attention_f32(
@@ -386,6 +559,7 @@ void MiCo_ViT_attention_f32(
     const Tensor4D_F32 *v,
     const float scale
 ){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "ViT_attention_f32");
     const size_t B = q->shape[0];
     const size_t H = q->shape[1];
     const size_t I = q->shape[2];
@@ -397,19 +571,20 @@ void MiCo_ViT_attention_f32(
     MiCo_assert(y->shape[0] == B && y->shape[1] == I && y->shape[2] == H && y->shape[3] == F, "[Attention] y shape mismatch");
     MiCo_assert(scale != 0.0f, "[Attention] scale must be non-zero");
 
-    float *scores = (float *)malloc(J * sizeof(float));
+    float *scores = (float *)MiCo_malloc(J * sizeof(float));
     MiCo_assert(scores != NULL, "[Attention] failed to allocate scores buffer");
 
     #ifdef USE_INT8_KV
     // pre-quantized key/value buffers for current (b, h), reused across query positions
-    int8_t *k_int8 = (int8_t *)malloc(J * F * sizeof(int8_t));
-    int8_t *v_int8 = (int8_t *)malloc(J * F * sizeof(int8_t));
-    float *k_scales = (float *)malloc(J * sizeof(float));
-    float *v_scales = (float *)malloc(J * sizeof(float));
+    int8_t *k_int8 = (int8_t *)MiCo_malloc(J * F * sizeof(int8_t));
+    int8_t *v_int8 = (int8_t *)MiCo_malloc(J * F * sizeof(int8_t));
+    float *k_scales = (float *)MiCo_malloc(J * sizeof(float));
+    float *v_scales = (float *)MiCo_malloc(J * sizeof(float));
     MiCo_assert(k_int8 != NULL && v_int8 != NULL && k_scales != NULL && v_scales != NULL,
                 "[Attention] failed to allocate quantized KV buffers");
     #endif
 
+    MiCo_ROOFLINE_BEGIN();
     long start_time = MiCo_time();
 
     for (size_t b = 0; b < B; b++){
@@ -496,21 +671,233 @@ void MiCo_ViT_attention_f32(
         }
     }
     ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("ViT_attention_f32", 2 * B * H * I * J * F, 32, 32,
+        4 * B * H * (2 * I * F + 2 * J * F));
 
-    free(scores);
+    MiCo_free(scores);
     #ifdef USE_INT8_KV
-    free(k_int8);
-    free(v_int8);
-    free(k_scales);
-    free(v_scales);
+    MiCo_free(k_int8);
+    MiCo_free(v_int8);
+    MiCo_free(k_scales);
+    MiCo_free(v_scales);
     #endif
 }
 
+// Size-weighted (proportional) attention for merged tokens, ToMe style:
+// softmax(q.k / scale + log(size_j)), so a token standing for s merged
+// tokens gets the attention weight of s identical keys.
+void MiCo_ViT_attention_prop_f32(
+    Tensor4D_F32 *y,
+    const Tensor4D_F32 *q,
+    const Tensor4D_F32 *k,
+    const Tensor4D_F32 *v,
+    const Tensor2D_F32 *size,
+    const float scale
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "ViT_attention_prop_f32");
+    const size_t B = q->shape[0];
+    const size_t H = q->shape[1];
+    const size_t I = q->shape[2];
+    const size_t F = q->shape[3];
+    const size_t J = k->shape[2];
+
+    MiCo_assert(k->shape[0] == B && k->shape[1] == H && k->shape[3] == F, "[Attention] k shape mismatch");
+    MiCo_assert(v->shape[0] == B && v->shape[1] == H && v->shape[2] == J && v->shape[3] == F, "[Attention] v shape mismatch");
+    MiCo_assert(y->shape[0] == B && y->shape[1] == I && y->shape[2] == H && y->shape[3] == F, "[Attention] y shape mismatch");
+    MiCo_assert(size->shape[0] == B && size->shape[1] == J, "[Attention] size shape mismatch");
+    MiCo_assert(scale != 0.0f, "[Attention] scale must be non-zero");
+
+    float *scores = (float *)MiCo_malloc(J * sizeof(float));
+    float *log_size = (float *)MiCo_malloc(J * sizeof(float));
+    MiCo_assert(scores != NULL && log_size != NULL, "[Attention] failed to allocate scores buffer");
+
+    MiCo_ROOFLINE_BEGIN();
+    long start_time = MiCo_time();
+
+    for (size_t b = 0; b < B; b++){
+        for (size_t j = 0; j < J; j++){
+            log_size[j] = logf(size->data[idx2(b, j, J)]);
+        }
+        for (size_t h = 0; h < H; h++){
+            for (size_t i = 0; i < I; i++){
+                size_t q_base = idx4(b, h, i, 0, H, I, F);
+                for (size_t j = 0; j < J; j++){
+                    float sum = 0.0f;
+                    size_t k_base_j = idx4(b, h, j, 0, H, J, F);
+                    for (size_t f = 0; f < F; f++){
+                        sum += q->data[q_base + f] * k->data[k_base_j + f];
+                    }
+                    scores[j] = sum / scale + log_size[j];
+                }
+
+                MiCo_softmax_vec(scores, scores, J);
+
+                float *yi = y->data + idx4(b, i, h, 0, I, H, F);
+                for (size_t f = 0; f < F; f++){
+                    yi[f] = 0.0f;
+                }
+                for (size_t j = 0; j < J; j++){
+                    const float a = scores[j];
+                    const float *vj = v->data + idx4(b, h, j, 0, H, J, F);
+                    for (size_t f = 0; f < F; f++){
+                        yi[f] += a * vj[f];
+                    }
+                }
+            }
+        }
+    }
+    ATTN_TIMER += MiCo_time() - start_time;
+    MiCo_ROOFLINE_END("ViT_attention_prop_f32", 2 * B * H * I * J * F, 32, 32,
+        4 * B * H * (2 * I * F + 2 * J * F));
+
+    MiCo_free(scores);
+    MiCo_free(log_size);
+}
+
+// Token Merging (ToMe) with bipartite soft matching.
+// Tokens are split into set A (even indices) and set B (odd indices).
+// Every A token is matched to its most similar B token by cosine
+// similarity of the metric (typically keys averaged over heads). The r
+// best-matched A tokens are merged into their B partners by a
+// size-weighted average, and sizes are accumulated.
+// Output order: unmerged A tokens in their original order, then all B
+// tokens. With protect_cls, token 0 is never merged and stays first.
+// size may be NULL, meaning every input token has size 1.
+void MiCo_tome_merge_f32(
+    Tensor3D_F32 *y,                // [B, N - r, C] merged tokens
+    Tensor2D_F32 *size_out,         // [B, N - r] merged sizes
+    const Tensor3D_F32 *x,          // [B, N, C] tokens
+    const Tensor3D_F32 *metric,     // [B, N, D] similarity features
+    const Tensor2D_F32 *size,       // [B, N] token sizes, or NULL
+    const size_t r,
+    const int protect_cls
+){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "tome_merge_f32");
+    const size_t B = x->shape[0];
+    const size_t N = x->shape[1];
+    const size_t C = x->shape[2];
+    const size_t D = metric->shape[2];
+    const size_t NA = (N + 1) / 2;
+    const size_t NB = N / 2;
+    const size_t M = N - r;
+
+    MiCo_assert(metric->shape[0] == B && metric->shape[1] == N, "[ToMe] metric shape mismatch");
+    MiCo_assert(size == NULL || (size->shape[0] == B && size->shape[1] == N), "[ToMe] size shape mismatch");
+    MiCo_assert(r <= NA - (protect_cls ? 1 : 0) && (r == 0 || NB > 0), "[ToMe] r exceeds mergeable tokens");
+    MiCo_assert(y->shape[0] == B && y->shape[1] == M && y->shape[2] == C, "[ToMe] y shape mismatch");
+    MiCo_assert(size_out->shape[0] == B && size_out->shape[1] == M, "[ToMe] size_out shape mismatch");
+
+    float *inv_norm = (float *)MiCo_malloc(N * sizeof(float));
+    float *node_max = (float *)MiCo_malloc(NA * sizeof(float));
+    size_t *node_idx = (size_t *)MiCo_malloc(NA * sizeof(size_t));
+    size_t *order = (size_t *)MiCo_malloc(NA * sizeof(size_t));
+    uint8_t *merged = (uint8_t *)MiCo_malloc(NA * sizeof(uint8_t));
+    MiCo_assert(inv_norm != NULL && node_max != NULL && node_idx != NULL &&
+                order != NULL && merged != NULL, "[ToMe] failed to allocate buffers");
+
+    for (size_t b = 0; b < B; b++){
+        const float *mb = metric->data + idx3(b, 0, 0, N, D);
+        const float *xb = x->data + idx3(b, 0, 0, N, C);
+        float *yb = y->data + idx3(b, 0, 0, M, C);
+        float *sb = size_out->data + idx2(b, 0, M);
+
+        for (size_t n = 0; n < N; n++){
+            float ss = 0.0f;
+            for (size_t d = 0; d < D; d++){
+                ss += mb[n * D + d] * mb[n * D + d];
+            }
+            inv_norm[n] = ss > 0.0f ? 1.0f / sqrtf(ss) : 0.0f;
+        }
+
+        // best B partner of every A token
+        for (size_t a = 0; a < NA; a++){
+            const float *ma = mb + (2 * a) * D;
+            node_max[a] = -INFINITY;
+            node_idx[a] = 0;
+            for (size_t j = 0; j < NB; j++){
+                const float *mj = mb + (2 * j + 1) * D;
+                float dot = 0.0f;
+                for (size_t d = 0; d < D; d++){
+                    dot += ma[d] * mj[d];
+                }
+                dot *= inv_norm[2 * a] * inv_norm[2 * j + 1];
+                if (dot > node_max[a]){
+                    node_max[a] = dot;
+                    node_idx[a] = j;
+                }
+            }
+        }
+        if (protect_cls){
+            node_max[0] = -INFINITY;
+        }
+
+        // stable insertion sort of A by similarity, descending; merge the top r
+        for (size_t a = 0; a < NA; a++){
+            size_t p = a;
+            while (p > 0 && node_max[order[p - 1]] < node_max[a]){
+                order[p] = order[p - 1];
+                p--;
+            }
+            order[p] = a;
+        }
+        for (size_t a = 0; a < NA; a++){
+            merged[a] = 0;
+        }
+        for (size_t t = 0; t < r; t++){
+            merged[order[t]] = 1;
+        }
+
+        // unmerged A tokens keep their order and size
+        size_t m = 0;
+        for (size_t a = 0; a < NA; a++){
+            if (merged[a]) continue;
+            memcpy(yb + m * C, xb + (2 * a) * C, C * sizeof(float));
+            sb[m] = size != NULL ? size->data[idx2(b, 2 * a, N)] : 1.0f;
+            m++;
+        }
+
+        // B tokens accumulate size-weighted sums of their merged A tokens
+        float *yB = yb + m * C;
+        float *sB = sb + m;
+        for (size_t j = 0; j < NB; j++){
+            const float s = size != NULL ? size->data[idx2(b, 2 * j + 1, N)] : 1.0f;
+            const float *xj = xb + (2 * j + 1) * C;
+            for (size_t c = 0; c < C; c++){
+                yB[j * C + c] = xj[c] * s;
+            }
+            sB[j] = s;
+        }
+        for (size_t a = 0; a < NA; a++){
+            if (!merged[a]) continue;
+            const float s = size != NULL ? size->data[idx2(b, 2 * a, N)] : 1.0f;
+            const size_t j = node_idx[a];
+            const float *xa = xb + (2 * a) * C;
+            for (size_t c = 0; c < C; c++){
+                yB[j * C + c] += xa[c] * s;
+            }
+            sB[j] += s;
+        }
+        for (size_t j = 0; j < NB; j++){
+            const float inv = 1.0f / sB[j];
+            for (size_t c = 0; c < C; c++){
+                yB[j * C + c] *= inv;
+            }
+        }
+    }
+
+    MiCo_free(inv_norm);
+    MiCo_free(node_max);
+    MiCo_free(node_idx);
+    MiCo_free(order);
+    MiCo_free(merged);
+}
+
 void MiCo_einsum_bkn_bnd_bd_f32(
     Tensor2D_F32 *y,
     const Tensor3D_F32 *a,
     const Tensor3D_F32 *x
 ){
+    MiCo_TRACE_SCOPE(MICO_TRACE_LAYER, "einsum_bkn_bnd_bd_f32");
     const size_t B = a->shape[0];
     const size_t K = a->shape[1];
     const size_t N = a->shape[2];
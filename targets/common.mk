@@ -28,4 +28,39 @@ ifneq ($(filter alt-layout, $(OPT)),)
 	CFLAGS += -DUSE_ALT_LAYOUT
 endif
 
+# Tracing level (0: off, 1: layers, 2: + phases, 3: + inner kernels)
+ifneq ($(TRACE),)
+	CFLAGS += -DMICO_TRACE_LEVEL=$(TRACE)
+endif
+
+# Core clock in MHz, converts trace cycles to us off host (default 100)
+ifneq ($(CORE_MHZ),)
+	CFLAGS += -DMICO_CORE_MHZ=$(CORE_MHZ)
+endif
+
+# Hardware counters per trace region (Linux hosts)
+ifneq ($(PERF),)
+	CFLAGS += -DMICO_PERF
+endif
+
+# Memory high-water per trace region
+ifneq ($(MEM),)
+	CFLAGS += -DMICO_MEM
+endif
+
+# Roofline report per op call
+ifneq ($(ROOFLINE),)
+	CFLAGS += -DMICO_ROOFLINE
+endif
+
+# Data-cache model of im2col / quant / matmul accesses (host)
+ifneq ($(CACHESIM),)
+	CFLAGS += -DMICO_CACHESIM
+endif
+
+# Output rows per im2col block in bitconv2d
+ifneq ($(IM2COL_BLOCK),)
+	CFLAGS += -DMICO_IM2COL_BLOCK_ROWS=$(IM2COL_BLOCK)
+endif
+
 CFLAGS += $(C_DEFINES)
\ No newline at end of file
@@ -0,0 +1,45 @@
+EMU_PATH = $(MICO_DIR)/targets/emu
+
+# Host build of the VexiiRiscv custom-ISA kernels on the instruction emulator
+# EMU selects the kernels: cfu (MiCo CFU VPU), simd (mico32 / mico64),
+# bnrv (BitNet RV) or bncfu (BitNet CFU)
+EMU ?= cfu
+
+# For MiCo CFU VPU and BitNet CFU (64 - 512)
+VLEN ?= 128
+# For MiCo SIMD (32 or 64)
+EMU_XLEN ?= 32
+# For BitNet RV and BitNet CFU
+USE_SIMD ?= 32
+BITNET_QUANT ?= 3
+
+MICO_SOURCES += $(EMU_PATH)/mico_emu.c
+CFLAGS += -DUSE_HOST -DMICO_EMU -I$(EMU_PATH)
+
+ifeq ($(EMU), cfu)
+	MICO_SOURCES += $(MICO_DIR)/targets/vexii_soc/cfu/qmatmul.c
+	CFLAGS += -DVLEN=$(VLEN)
+	EMU_TAG = cfu_v$(VLEN)
+endif
+
+ifeq ($(EMU), simd)
+	MICO_SOURCES += $(MICO_DIR)/targets/vexii/mico$(EMU_XLEN)/qmatmul.c
+	CFLAGS += -DMICO_EMU_XLEN=$(EMU_XLEN)
+	EMU_TAG = simd$(EMU_XLEN)
+endif
+
+ifeq ($(EMU), bnrv)
+	MICO_SOURCES += $(MICO_DIR)/targets/vexii_bitnet/bitnet_matmul.c
+	CFLAGS += -DUSE_SIMD=$(USE_SIMD) -DBITNET_QUANT=$(BITNET_QUANT)
+	EMU_TAG = bnrv_q$(BITNET_QUANT)_s$(USE_SIMD)
+endif
+
+ifeq ($(EMU), bncfu)
+	MICO_SOURCES += $(MICO_DIR)/targets/vexii_soc/bncfu/bitnet_cfu_matmul.c
+	CFLAGS += -DVLEN=$(VLEN) -DBITNET_QUANT=$(BITNET_QUANT)
+	EMU_TAG = bncfu_q$(BITNET_QUANT)_v$(VLEN)
+endif
+
+ifeq ($(EMU_TAG),)
+$(error Unknown EMU=$(EMU), expected cfu, simd, bnrv or bncfu)
+endif
@@ -0,0 +1,207 @@
+#include <string.h>
+
+#include "nn.h"
+#include "mico_qnn.h"
+#include "mico_emu.h"
+
+// Software models of the MiCo custom instructions.
+//
+// CFU VPU: two VLEN-bit vector registers loaded from memory. vdot(vs1, vs2)
+// decodes vs1 at the higher configured precision qa. With qa == qb both
+// operands hold VLEN/qa elements; otherwise vs2 holds qa/qb slices of
+// VLEN/qa low-precision elements, consumed in order by consecutive vdots
+// and rewound when vs2 is reloaded.
+//
+// MiCo SIMD: XLEN-wide operands in integer registers. Mixed ops walk the
+// slices of rs2 with a counter that wraps after qa/qb ops and restarts when
+// rs2 or the mixed op changes, which is what the kernels rely on for the
+// partial group at the end of a row.
+//
+// BitNet RV: bn_store fills a 64-bit weight buffer {rs1, rs2}; each bn_sum
+// multiplies rs1 and rs2 (4 INT8 each) with the next 8 weights. With
+// USE_SIMD=4 there is no buffer and rs2 carries 4 packed weights.
+//
+// Sub-byte elements are packed LSB first and decode like the generic
+// kernels: 4-bit sign-extended, 2-bit {0, 1, -2, -1}, 1-bit {+1, -1}.
+
+#define EMU_VBYTES (VLEN / 8)
+#define EMU_BN_WQ (BITNET_QUANT == 2 ? 1 : 2)
+
+static MiCo_Emu_Stats emu_stats;
+
+static struct {
+    int enabled;
+    int qa, qb;
+    uint8_t v[2][EMU_VBYTES];
+    int slice[2];
+} emu_vpu;
+
+static struct {
+    int qa, qb;
+    uint64_t rs2;
+    int slice;
+} emu_simd;
+
+static struct {
+    uint64_t buffer;
+    int pos;    // weights consumed since the last bn_store
+} emu_bn;
+
+static const char* emu_insn_names[MICO_EMU_N_INSNS] = {
+    "cfu.enable", "fence", "vpu.config", "vpu.load", "vpu.vdot",
+    "simd.mac", "bn.store", "bn.sum", "bn.dotp8", "bn.dotp8x2"
+};
+
+static inline int __emu_qlog(const int q){
+    return q == 8 ? 3 : (q == 4 ? 2 : (q == 2 ? 1 : 0));
+}
+
+static inline int __emu_valid_q(const int q){
+    return q == 1 || q == 2 || q == 4 || q == 8;
+}
+
+static inline int32_t __emu_elem(const uint8_t* v, const int i, const int q){
+    switch (q){
+        case 8: return (int8_t)v[i];
+        case 4: return SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(v[i >> 1], i & 1), 4);
+        case 2: return TWO_BIT_TO_INT8(EXTRACT_2BIT(v[i >> 2], i & 3));
+        default: return BIT_TO_INT8(EXTRACT_BIT(v[i >> 3], i & 7));
+    }
+}
+
+// n elements of a at qa times elements [off, off + n) of b at qb
+static int32_t __emu_dot(const uint8_t* a, const int qa,
+    const uint8_t* b, const int qb, const int off, const int n){
+    int32_t acc = 0;
+    for (int i = 0; i < n; i++){
+        acc += __emu_elem(a, i, qa) * __emu_elem(b, off + i, qb);
+    }
+    emu_stats.macs += n;
+    emu_stats.dot[__emu_qlog(qa)][__emu_qlog(qb)]++;
+    return acc;
+}
+
+static inline void __emu_bytes(uint8_t* p, const uint64_t x, const int n){
+    for (int i = 0; i < n; i++) p[i] = (uint8_t)(x >> (8 * i));
+}
+
+void __MiCo_emu_cfu_enable(void){
+    emu_stats.insn[MICO_EMU_CFU_ENABLE]++;
+    emu_vpu.enabled = 1;
+}
+
+void __MiCo_emu_fence(void){
+    emu_stats.insn[MICO_EMU_FENCE]++;
+}
+
+void __MiCo_emu_vpu_config(const int qa, const int qb){
+    emu_stats.insn[MICO_EMU_VPU_CONFIG]++;
+    MiCo_assert(emu_vpu.enabled, "[Emu] vpu.config before cfu_enable");
+    MiCo_assert(__emu_valid_q(qa) && __emu_valid_q(qb) && qa >= qb,
+        "[Emu] vpu.config needs qa >= qb in {1, 2, 4, 8}");
+    emu_vpu.qa = qa;
+    emu_vpu.qb = qb;
+    emu_vpu.slice[0] = emu_vpu.slice[1] = 0;
+}
+
+void __MiCo_emu_vpu_load(const int vd, const void* addr){
+    emu_stats.insn[MICO_EMU_VPU_LOAD]++;
+    MiCo_assert(emu_vpu.enabled, "[Emu] vpu.load before cfu_enable");
+    memcpy(emu_vpu.v[vd], addr, EMU_VBYTES);
+    emu_vpu.slice[vd] = 0;
+    emu_stats.load_bytes += EMU_VBYTES;
+}
+
+int32_t __MiCo_emu_vpu_vdot(const int vs1, const int vs2){
+    emu_stats.insn[MICO_EMU_VPU_VDOT]++;
+    MiCo_assert(emu_vpu.qa != 0, "[Emu] vpu.vdot before vpu.config");
+    const int qa = emu_vpu.qa, qb = emu_vpu.qb;
+    const int n = VLEN / qa;
+    const int off = emu_vpu.slice[vs2] * n;
+    if (qa != qb) emu_vpu.slice[vs2] = (emu_vpu.slice[vs2] + 1) % (qa / qb);
+    return __emu_dot(emu_vpu.v[vs1], qa, emu_vpu.v[vs2], qb, off, n);
+}
+
+int32_t __MiCo_emu_simd_mac(const uint64_t a, const uint64_t b,
+    const int qa, const int qb, const int xlen){
+    emu_stats.insn[MICO_EMU_SIMD_MAC]++;
+    uint8_t va[8], vb[8];
+    __emu_bytes(va, a, xlen / 8);
+    __emu_bytes(vb, b, xlen / 8);
+    const int n = xlen / qa;
+    int off = 0;
+    if (qa != qb){
+        if (emu_simd.qa != qa || emu_simd.qb != qb || emu_simd.rs2 != b){
+            emu_simd.qa = qa;
+            emu_simd.qb = qb;
+            emu_simd.rs2 = b;
+            emu_simd.slice = 0;
+        }
+        off = emu_simd.slice * n;
+        emu_simd.slice = (emu_simd.slice + 1) % (qa / qb);
+    }
+    return __emu_dot(va, qa, vb, qb, off, n);
+}
+
+void __MiCo_emu_bn_store(const uint32_t hi, const uint32_t lo){
+    emu_stats.insn[MICO_EMU_BN_STORE]++;
+    emu_bn.buffer = ((uint64_t)hi << 32) | lo;
+    emu_bn.pos = 0;
+}
+
+int32_t __MiCo_emu_bn_sum(const uint32_t a, const uint32_t b){
+    emu_stats.insn[MICO_EMU_BN_SUM]++;
+    uint8_t va[4], vw[8];
+    __emu_bytes(va, a, 4);
+    #if USE_SIMD == 4
+    __emu_bytes(vw, b, 4);
+    return __emu_dot(va, 8, vw, EMU_BN_WQ, 0, 4);
+    #else
+    uint8_t vb[4];
+    __emu_bytes(vb, b, 4);
+    __emu_bytes(vw, emu_bn.buffer, 8);
+    const int off = emu_bn.pos;
+    emu_bn.pos = (emu_bn.pos + 8) % (64 / EMU_BN_WQ);
+    return __emu_dot(va, 8, vw, EMU_BN_WQ, off, 4) +
+        __emu_dot(vb, 8, vw, EMU_BN_WQ, off + 4, 4);
+    #endif
+}
+
+int32_t __MiCo_emu_bn_dotp8(const uint32_t a, const uint32_t b){
+    emu_stats.insn[MICO_EMU_BN_DOTP8]++;
+    uint8_t va[4], vb[4];
+    __emu_bytes(va, a, 4);
+    __emu_bytes(vb, b, 4);
+    return __emu_dot(va, 8, vb, 8, 0, 4);
+}
+
+int32_t __MiCo_emu_bn_dotp8x2(const uint32_t a, const uint32_t w){
+    emu_stats.insn[MICO_EMU_BN_DOTP8X2]++;
+    uint8_t va[4], vw[1];
+    __emu_bytes(va, a, 4);
+    __emu_bytes(vw, w, 1);
+    return __emu_dot(va, 8, vw, 2, 0, 4);
+}
+
+const MiCo_Emu_Stats* MiCo_emu_stats(void){
+    return &emu_stats;
+}
+
+void MiCo_emu_reset(void){
+    memset(&emu_stats, 0, sizeof(emu_stats));
+}
+
+void MiCo_emu_print_report(void){
+    printf("[Emu] VLEN=%d XLEN=%d\n", VLEN, MICO_EMU_XLEN);
+    for (int i = 0; i < MICO_EMU_N_INSNS; i++){
+        if (emu_stats.insn[i] == 0) continue;
+        printf("[Emu] %-12s %12lu\n", emu_insn_names[i], (unsigned long)emu_stats.insn[i]);
+    }
+    for (int a = 3; a >= 0; a--)
+    for (int b = a; b >= 0; b--){
+        if (emu_stats.dot[a][b] == 0) continue;
+        printf("[Emu] dot %dx%-6d %12lu\n", 1 << a, 1 << b, (unsigned long)emu_stats.dot[a][b]);
+    }
+    printf("[Emu] MACs %lu, vector load bytes %lu\n",
+        (unsigned long)emu_stats.macs, (unsigned long)emu_stats.load_bytes);
+}
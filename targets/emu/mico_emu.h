@@ -0,0 +1,115 @@
+#ifndef MICO_EMU_H
+#define MICO_EMU_H
+
+// Host emulation of the MiCo VexiiRiscv custom instructions
+// Included by the custom-ISA kernels in place of their inline-asm macros
+// when built with -DMICO_EMU (see targets/emu.mk). Every instruction is
+// executed in software and counted, so the CFU, SIMD and BitNet kernels can
+// be checked and profiled on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Vector register length of the CFU VPU / BitNet CFU in bits
+#ifndef VLEN
+#define VLEN 128
+#endif
+
+#if VLEN < 64 || VLEN > 512 || (VLEN & (VLEN - 1)) != 0
+#error "MiCo emulator supports VLEN of 64, 128, 256 or 512"
+#endif
+
+// Register width of the MiCo SIMD core (mico32 / mico64)
+#ifndef MICO_EMU_XLEN
+#define MICO_EMU_XLEN 32
+#endif
+
+#ifndef BITNET_QUANT
+#define BITNET_QUANT 3
+#endif
+
+#ifndef USE_SIMD
+#define USE_SIMD 32
+#endif
+
+enum {
+    MICO_EMU_CFU_ENABLE,
+    MICO_EMU_FENCE,
+    MICO_EMU_VPU_CONFIG,
+    MICO_EMU_VPU_LOAD,
+    MICO_EMU_VPU_VDOT,
+    MICO_EMU_SIMD_MAC,
+    MICO_EMU_BN_STORE,
+    MICO_EMU_BN_SUM,
+    MICO_EMU_BN_DOTP8,
+    MICO_EMU_BN_DOTP8X2,
+    MICO_EMU_N_INSNS
+};
+
+typedef struct {
+    uint64_t insn[MICO_EMU_N_INSNS];
+    uint64_t dot[4][4];     // dot-product instructions per [qlog(high)][qlog(low)]
+    uint64_t macs;
+    uint64_t load_bytes;
+} MiCo_Emu_Stats;
+
+const MiCo_Emu_Stats* MiCo_emu_stats(void);
+void MiCo_emu_reset(void);
+void MiCo_emu_print_report(void);
+
+void __MiCo_emu_cfu_enable(void);
+void __MiCo_emu_fence(void);
+void __MiCo_emu_vpu_config(const int qa, const int qb);
+void __MiCo_emu_vpu_load(const int vd, const void* addr);
+int32_t __MiCo_emu_vpu_vdot(const int vs1, const int vs2);
+int32_t __MiCo_emu_simd_mac(const uint64_t a, const uint64_t b,
+    const int qa, const int qb, const int xlen);
+void __MiCo_emu_bn_store(const uint32_t hi, const uint32_t lo);
+int32_t __MiCo_emu_bn_sum(const uint32_t a, const uint32_t b);
+int32_t __MiCo_emu_bn_dotp8(const uint32_t a, const uint32_t b);
+int32_t __MiCo_emu_bn_dotp8x2(const uint32_t a, const uint32_t w);
+
+// MiCo CFU VPU (targets/vexii_soc/cfu)
+#define cfu_enable() __MiCo_emu_cfu_enable()
+#define fence_i() __MiCo_emu_fence()
+#define vpu_config(qa, qb) __MiCo_emu_vpu_config(qa, qb)
+#define vpu_load_v0(addr) __MiCo_emu_vpu_load(0, addr)
+#define vpu_load_v1(addr) __MiCo_emu_vpu_load(1, addr)
+#define vpu_vdot_v0_v1() __MiCo_emu_vpu_vdot(0, 1)
+#define vpu_vdot_v1_v0() __MiCo_emu_vpu_vdot(1, 0)
+
+// BitNet CFU (targets/vexii_soc/bncfu): the VPU fixed to 8 x BitNet weights
+#define bncfu_enable() do { \
+    __MiCo_emu_cfu_enable(); \
+    __MiCo_emu_vpu_config(8, BITNET_QUANT == 2 ? 1 : 2); \
+} while(0)
+#define bncfu_fence() __MiCo_emu_fence()
+#define bncfu_load_v0(addr) __MiCo_emu_vpu_load(0, addr)
+#define bncfu_load_v1(addr) __MiCo_emu_vpu_load(1, addr)
+#define bncfu_bdot_v0_v1() __MiCo_emu_vpu_vdot(0, 1)
+#define bncfu_bdot_v1_v0() __MiCo_emu_vpu_vdot(1, 0)
+
+// MiCo SIMD (targets/vexii/mico32, mico64); rs1 holds the higher precision
+#define mico_v4s8_mac(a, b) __MiCo_emu_simd_mac(a, b, 8, 8, 32)
+#define mico_v8s4_mac(a, b) __MiCo_emu_simd_mac(a, b, 4, 4, 32)
+#define mico_v16s2_mac(a, b) __MiCo_emu_simd_mac(a, b, 2, 2, 32)
+#define mico_v32s1_mac(a, b) __MiCo_emu_simd_mac(a, b, 1, 1, 32)
+#define mico_v8s8_mac(a, b) __MiCo_emu_simd_mac(a, b, 8, 8, 64)
+#define mico_v16s4_mac(a, b) __MiCo_emu_simd_mac(a, b, 4, 4, 64)
+#define mico_v32s2_mac(a, b) __MiCo_emu_simd_mac(a, b, 2, 2, 64)
+#define mico_v64s1_mac(a, b) __MiCo_emu_simd_mac(a, b, 1, 1, 64)
+#define mico_mac_8x4(a, b) __MiCo_emu_simd_mac(a, b, 8, 4, MICO_EMU_XLEN)
+#define mico_mac_8x2(a, b) __MiCo_emu_simd_mac(a, b, 8, 2, MICO_EMU_XLEN)
+#define mico_mac_8x1(a, b) __MiCo_emu_simd_mac(a, b, 8, 1, MICO_EMU_XLEN)
+#define mico_mac_4x2(a, b) __MiCo_emu_simd_mac(a, b, 4, 2, MICO_EMU_XLEN)
+#define mico_mac_4x1(a, b) __MiCo_emu_simd_mac(a, b, 4, 1, MICO_EMU_XLEN)
+#define mico_mac_2x1(a, b) __MiCo_emu_simd_mac(a, b, 2, 1, MICO_EMU_XLEN)
+
+// BitNet RV (targets/vexii_bitnet)
+#define bn_store(w0, w1) __MiCo_emu_bn_store(w0, w1)
+#define bn_sum8(a, b) __MiCo_emu_bn_sum(a, b)
+#define bn_sum4(a, b) __MiCo_emu_bn_sum(a, b)
+#define bn_dotp8(a, b) __MiCo_emu_bn_dotp8(a, b)
+#define bn_dotp8x2(a, b) __MiCo_emu_bn_dotp8x2(a, b)
+
+#endif // MICO_EMU_H
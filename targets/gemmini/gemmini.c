@@ -45,6 +45,7 @@ void MiCo_bitlinear_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x,
 
     start = MiCo_time();
     const size_t qx_size = b*aligned_size*sizeof(int8_t) / (8/aq);
+    MiCo_mem_qbuffer_use(qx_size);
     MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
     qx.data = MiCo_QX_Buffer_Global.buffer;
     MiCo_2D_quant(&qx, x, aq);
@@ -56,7 +57,7 @@ void MiCo_bitlinear_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x,
     // Initialization
     bool use_bias = (bias->shape[0] != 0); 
 
-    int32_t* qB = malloc(m*sizeof(int32_t));
+    int32_t* qB = MiCo_malloc(m*sizeof(int32_t));
     int8_t C[n][m];
     for (size_t i = 0; i < b; i++) {
         for (size_t j = 0; j < m; j++){
@@ -103,7 +104,7 @@ void MiCo_bitlinear_f32(Tensor2D_F32 *y, const Tensor2D_F32 *x,
     // printf("DeQuant Scale: %.4f\n", scale);
     
     // Free Quantized Memory
-    free(qB);
+    MiCo_free(qB);
 }
 
 
@@ -175,6 +176,7 @@ void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
     long start; // Profiler
 
     size_t qx_size = in_c_per_group * kernel_size * out_h * out_w * sizeof(qbyte);
+    MiCo_mem_qbuffer_use(qx_size);
     MiCo_assert(qx_size < QUANTIZE_BUFFER_SIZE, "Quantization Buffer Overflow");
 
     // Initialization
@@ -193,7 +195,7 @@ void MiCo_bitconv2d_f32(Tensor4D_F32 *y, const Tensor4D_F32 *x,
     float scale = weight->scale * qx.scale;
 
     if (use_bias){
-        qb = malloc(out_c_per_group * sizeof(int32_t));
+        qb = MiCo_malloc(out_c_per_group * sizeof(int32_t));
         for (size_t i = 0; i < out_c_per_group; i++){
             qb[i] = bias->data[i] / scale;
         }
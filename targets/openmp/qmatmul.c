@@ -71,11 +71,16 @@ void MiCo_Q2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w){
     const size_t in_features = x->shape[1];
     const size_t out_features = w->shape[0];
 
+    // Thread-local temporary storage for results, one row per thread,
+    // allocated outside the parallel region
+    const int n_threads = omp_get_max_threads();
+    int32_t* results = (int32_t*)MiCo_malloc((size_t)n_threads * out_features * sizeof(int32_t));
+    MiCo_assert(results != NULL, "[Q2MatMul] failed to allocate buffer");
+
     // Use dynamic scheduling for potentially imbalanced workloads
     #pragma omp parallel for schedule(dynamic, 1)
     for (size_t i = 0; i < batch_size; i++) {
-        // Thread-local temporary storage for results
-        int32_t* thread_results = (int32_t*)malloc(out_features * sizeof(int32_t));
+        int32_t* thread_results = results + (size_t)omp_get_thread_num() * out_features;
         
         for (size_t j = 0; j < out_features; j++) {
             int32_t acc = 0;
@@ -119,9 +124,8 @@ void MiCo_Q2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w){
                 O[i * out_features + j] = thread_results[j];
             }
         }
-        
-        free(thread_results);
     }
+    MiCo_free(results);
 }
 
 void MiCo_Q1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w){
@@ -3,6 +3,9 @@
 // SIMD accelerated Implementation of 8-bit MatMul
 // Requires ISA support
 
+#ifdef MICO_EMU
+#include "mico_emu.h"
+#else
 #define mico_v4s8_mac(a, b) ({                 \
     int32_t _r;                                \
     __asm__ volatile(".insn r 0x0B, 0x4, 0x01, %0, %1, %2" \
@@ -77,7 +80,7 @@
                      : "r"(a), "r"(b));        \
     _r;                                        \
 })
-
+#endif // MICO_EMU
 
 void MiCo_Q8_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w){
     
@@ -21,6 +21,9 @@ typedef uint8_t int1x8_t;
 typedef uint16_t int1x16_t;
 typedef uint32_t int1x32_t;
 
+#ifdef MICO_EMU
+#include "mico_emu.h"
+#else
 #define bn_sum8(a, b) ({                                      \
     int32_t _r;                                               \
     __asm__ volatile(".insn r 0x0B, 0x1, 0x00, %0, %1, %2"   \
@@ -57,6 +60,7 @@ typedef uint32_t int1x32_t;
                      : "r"(a), "r"(b));                      \
     _r;                                                       \
 })
+#endif // MICO_EMU
 
 static inline int32_t bitnet_row_acc_q8xq(const int8_t *input, const int8_t *weight, int n) {
     int32_t acc = 0;
@@ -15,6 +15,9 @@
 #define BNCFU_Q1_FULL_ELEMS (BNCFU_Q8_ELEMS * BNCFU_Q1_DOTS_PER_LOAD)
 #define BNCFU_Q2_FULL_ELEMS (BNCFU_Q8_ELEMS * BNCFU_Q2_DOTS_PER_LOAD)
 
+#ifdef MICO_EMU
+#include "mico_emu.h"
+#else
 #define bncfu_enable() do { \
     __asm__ volatile( \
         "li t1, 0x80000000\n\t" \
@@ -58,6 +61,7 @@
     ); \
     _result; \
 })
+#endif // MICO_EMU
 
 #if BITNET_QUANT == 2
 void MiCo_Q8x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
@@ -85,6 +89,10 @@ void MiCo_Q8x1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
                     x_ptr += BNCFU_BYTES;
                 }
             }
+            for(size_t t = full_iters * BNCFU_Q1_FULL_ELEMS; t < in_features; ++t) {
+                const int8_t w_bit = EXTRACT_BIT(w->data[(j * in_features + t) >> 3], (j * in_features + t) & 0x7);
+                acc += AMUX_1BIT(w_bit, x_base[t]);
+            }
             O[i * out_features + j] = acc;
         }
     }
@@ -115,6 +123,10 @@ void MiCo_Q1x8_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
                     w_ptr += BNCFU_BYTES;
                 }
             }
+            for(size_t t = full_iters * BNCFU_Q1_FULL_ELEMS; t < in_features; ++t) {
+                const int8_t a_bit = EXTRACT_BIT(x->data[(i * in_features + t) >> 3], (i * in_features + t) & 0x7);
+                acc += AMUX_1BIT(a_bit, w_base[t]);
+            }
             O[i * out_features + j] = acc;
         }
     }
@@ -145,6 +157,10 @@ void MiCo_Q8x2_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
                     x_ptr += BNCFU_BYTES;
                 }
             }
+            for(size_t t = full_iters * BNCFU_Q2_FULL_ELEMS; t < in_features; ++t) {
+                const int8_t w_2bit = EXTRACT_2BIT(w->data[(j * in_features + t) >> 2], (j * in_features + t) & 0x3);
+                acc += AMUX_2BIT(w_2bit, x_base[t]);
+            }
             O[i * out_features + j] = acc;
         }
     }
@@ -175,6 +191,10 @@ void MiCo_Q2x8_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
                     w_ptr += BNCFU_BYTES;
                 }
             }
+            for(size_t t = full_iters * BNCFU_Q2_FULL_ELEMS; t < in_features; ++t) {
+                const int8_t a_2bit = EXTRACT_2BIT(x->data[(i * in_features + t) >> 2], (i * in_features + t) & 0x3);
+                acc += AMUX_2BIT(a_2bit, w_base[t]);
+            }
             O[i * out_features + j] = acc;
         }
     }
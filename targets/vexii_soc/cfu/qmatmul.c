@@ -23,6 +23,9 @@
 #define VPU_ELEMS_Q2 (VLEN / 2)    // Elements per vector op for 2-bit
 #define VPU_ELEMS_Q1 (VLEN / 1)    // Elements per vector op for 1-bit
 
+#ifdef MICO_EMU
+#include "mico_emu.h"
+#else
 // Inline macro to enable CFU
 #define cfu_enable() do { \
     __asm__ volatile( \
@@ -92,7 +95,7 @@
     ); \
     _result; \
 })
-
+#endif // MICO_EMU
 
 void MiCo_Q8_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w){
     
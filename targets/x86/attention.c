@@ -0,0 +1,85 @@
+#include "mico_nn.h"
+#include "mico_qnn.h"
+#include <immintrin.h> // For AVX/SSE intrinsics
+
+// AVX2 kernels for the packed 4/2-bit KV cache.
+// Each step unpacks 16 signed values into int8 lanes, widens them to FP32
+// and multiplies against the FP32 operand; the tail falls back to scalar.
+
+// Unpack 8 bytes of 4-bit data into 16 sign-extended int8 lanes
+static inline __m128i unpack_16x4bit(const qbyte* p){
+    const __m128i nib = _mm_set1_epi8(0x0F);
+    const __m128i sign = _mm_set1_epi8(0x08);
+    __m128i b = _mm_loadl_epi64((const __m128i*)p);
+    __m128i lo = _mm_and_si128(b, nib);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), nib);
+    __m128i v = _mm_unpacklo_epi8(lo, hi);
+    return _mm_sub_epi8(_mm_xor_si128(v, sign), sign);
+}
+
+// Unpack 4 bytes of 2-bit data into 16 sign-extended int8 lanes
+static inline __m128i unpack_16x2bit(const qbyte* p){
+    const __m128i m2 = _mm_set1_epi8(0x03);
+    const __m128i sign = _mm_set1_epi8(0x02);
+    __m128i b = _mm_cvtsi32_si128(*(const int32_t*)p);
+    __m128i v0 = _mm_and_si128(b, m2);
+    __m128i v1 = _mm_and_si128(_mm_srli_epi16(b, 2), m2);
+    __m128i v2 = _mm_and_si128(_mm_srli_epi16(b, 4), m2);
+    __m128i v3 = _mm_and_si128(_mm_srli_epi16(b, 6), m2);
+    __m128i v01 = _mm_unpacklo_epi8(v0, v1);
+    __m128i v23 = _mm_unpacklo_epi8(v2, v3);
+    __m128i v = _mm_unpacklo_epi16(v01, v23);
+    return _mm_sub_epi8(_mm_xor_si128(v, sign), sign);
+}
+
+static inline __m128i unpack_16(const qbyte* p, const qtype bits){
+    return bits == 4 ? unpack_16x4bit(p) : unpack_16x2bit(p);
+}
+
+static inline int8_t kvq_get(const qbyte* p, const int i, const qtype bits){
+    if (bits == 4){
+        return SIGN_EXTEND_TO_INT8(EXTRACT_4BIT(p[i / 2], i & 0x1), 4);
+    }
+    return SIGN_EXTEND_TO_INT8(EXTRACT_2BIT(p[i / 4], i & 0x3), 2);
+}
+
+float MiCo_kvq_dot_f32(const float* q, const qbyte* k,
+    const int n, const qtype bits){
+    const int step_bytes = 16 * bits / 8;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m128i v = unpack_16(k + i / 16 * step_bytes, bits);
+        __m256 f0 = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(v));
+        __m256 f1 = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(v, 8)));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(q + i), f0));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(q + i + 8), f1));
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    float sum = _mm_cvtss_f32(s);
+    for (; i < n; i++){
+        sum += q[i] * kvq_get(k, i, bits);
+    }
+    return sum;
+}
+
+void MiCo_kvq_axpy_f32(float* y, const float a, const qbyte* v,
+    const int n, const qtype bits){
+    const int step_bytes = 16 * bits / 8;
+    const __m256 va = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m128i w = unpack_16(v + i / 16 * step_bytes, bits);
+        __m256 f0 = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(w));
+        __m256 f1 = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(w, 8)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(va, f0)));
+        _mm256_storeu_ps(y + i + 8, _mm256_add_ps(_mm256_loadu_ps(y + i + 8), _mm256_mul_ps(va, f1)));
+    }
+    for (; i < n; i++){
+        y[i] += a * kvq_get(v, i, bits);
+    }
+}
@@ -30,10 +30,8 @@ static inline __m256i extract_2bit_values(const int8_t* data, size_t base_idx, s
         size_t bit_pos = (bit_idx % 4) * 2;
         
         int8_t two_bits = (data[byte_idx] >> bit_pos) & 0x3;
-        // Convert 2-bit to signed int8: 0->1, 1->0, 2->-2, 3->-1
-        extracted[i] = (two_bits == 0) ? 1 : 
-                       (two_bits == 1) ? 0 : 
-                       (two_bits == 2) ? -2 : -1;
+        // Convert 2-bit to signed int8 as TWO_BIT_TO_INT8: 0->0, 1->1, 2->-2, 3->-1
+        extracted[i] = TWO_BIT_TO_INT8(two_bits);
     }
     return _mm256_loadu_si256((__m256i*)extracted);
 }
@@ -685,11 +683,11 @@ void MiCo_Q1_MatMul(int32_t *O, const Tensor2D_Q8 *x, const Tensor2D_Q8 *w) {
             // For binary operations, we can use XOR and population count
             // This is much faster than extracting each bit individually
             for (size_t k = 0; k < in_features/8; k++) {
-                // XNOR of bits gives 1 when bits match, 0 when they differ
-                uint8_t xnor_result = ~(x_row[k] ^ w_row[k]);
+                // XOR of bits gives 1 when the signs differ
+                uint8_t xor_result = x_row[k] ^ w_row[k];
                 
-                // Count set bits (each set bit contributes -1, each unset bit +1)
-                acc += (8 - __builtin_popcount(xnor_result) - __builtin_popcount(xnor_result));
+                // Matching bits contribute +1, differing bits -1
+                acc += 8 - 2 * __builtin_popcount(xor_result);
             }
             
             O[i * out_features + j] = acc;
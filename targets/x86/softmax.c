@@ -0,0 +1,84 @@
+#include "nn.h"
+#include <immintrin.h> // For AVX/SSE intrinsics
+
+// AVX2 softmax: 8-wide version of the range-reduced polynomial exp used
+// by the portable kernel in src/softmax.c, same constants and error bound
+// (below 8.5e-8 relative); inputs below the low clamp, including -inf, give 0.
+
+static inline __m256 exp256_ps(__m256 x){
+    const __m256 hi = _mm256_set1_ps(88.0f);
+    const __m256 lo = _mm256_set1_ps(-87.3365447504019f);
+    const __m256 log2e = _mm256_set1_ps(1.44269504088896341f);
+    const __m256 ln2_hi = _mm256_set1_ps(0.693359375f);
+    const __m256 ln2_lo = _mm256_set1_ps(-2.12194440e-4f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    const __m256 keep = _mm256_cmp_ps(x, lo, _CMP_GE_OQ);
+    x = _mm256_min_ps(_mm256_max_ps(x, lo), hi);
+    __m256 fn = _mm256_round_ps(_mm256_mul_ps(x, log2e),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(fn, ln2_hi));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(fn, ln2_lo));
+
+    __m256 p = _mm256_set1_ps(1.9875691500E-4f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.3981999507E-3f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(8.3334519073E-3f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(4.1665795894E-2f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.6666665459E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(5.0000001201E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, r), r), _mm256_add_ps(r, one));
+
+    __m256i n = _mm256_cvtps_epi32(fn);
+    __m256i pow2n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+    return _mm256_and_ps(_mm256_mul_ps(p, _mm256_castsi256_ps(pow2n)), keep);
+}
+
+static inline float hmax256_ps(__m256 v){
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 0x1));
+    return _mm_cvtss_f32(m);
+}
+
+static inline float hsum256_ps(__m256 v){
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x1));
+    return _mm_cvtss_f32(s);
+}
+
+void MiCo_softmax_f32(float* dst, const float* src, const size_t n){
+    size_t i = 0;
+    if (n == 0) return;
+    __m256 vmax = _mm256_set1_ps(src[0]);
+    for (; i + 8 <= n; i += 8){
+        vmax = _mm256_max_ps(vmax, _mm256_loadu_ps(src + i));
+    }
+    float max_val = hmax256_ps(vmax);
+    for (; i < n; i++){
+        max_val = src[i] > max_val ? src[i] : max_val;
+    }
+
+    const __m256 vm = _mm256_set1_ps(max_val);
+    __m256 vsum = _mm256_setzero_ps();
+    for (i = 0; i + 8 <= n; i += 8){
+        __m256 e = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(src + i), vm));
+        _mm256_storeu_ps(dst + i, e);
+        vsum = _mm256_add_ps(vsum, e);
+    }
+    float sum = hsum256_ps(vsum);
+    for (; i < n; i++){
+        float e = MiCo_fast_expf(src[i] - max_val);
+        dst[i] = e;
+        sum += e;
+    }
+
+    const float inv_sum = 1.0f / sum;
+    const __m256 vinv = _mm256_set1_ps(inv_sum);
+    for (i = 0; i + 8 <= n; i += 8){
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(dst + i), vinv));
+    }
+    for (; i < n; i++){
+        dst[i] *= inv_sum;
+    }
+}